@@ -62,7 +62,6 @@ static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system m
 static float Be[3];	                    // local magnetic unit vector in NED frame
 static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
-static float K[NUMX][NUMV];	     // feedback gain matrix
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -87,10 +86,8 @@ void INSGPSInit()		//pretty much just a place holder for now
 		for (int j = 0; j < NUMW; j++)
 			G[i][j] = 0.0f;
 			
-		for (int j = 0; j < NUMV; j++) {
+		for (int j = 0; j < NUMV; j++)
 			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
-		}
 			
 		X[i] = 0.0f;
 	}
@@ -1336,6 +1333,22 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 }
 #endif
 
+//  Each row of H, as filled in by LinearizeH(), only has nonzero entries in
+//  one run of consecutive states.  SerialUpdate() only visits those columns
+//  when forming H*P and H*P*H'.
+//    GPS position and velocity - one unit entry on states 0-5
+//    magnetometer              - the attitude states 6-9
+//    baro altitude             - the down position, state 2
+static const struct {
+	uint8_t first;
+	uint8_t count;
+} H_nonzero[NUMV] = {
+	{ 0, 1 }, { 1, 1 }, { 2, 1 },
+	{ 3, 1 }, { 4, 1 }, { 5, 1 },
+	{ 6, 4 }, { 6, 4 }, { 6, 4 },
+	{ 2, 1 },
+};
+
 //  *************  SerialUpdate *******************
 //  Does the update step of the Kalman filter for the covariance and estimate
 //  Outputs are Xnew & Pnew, and are written over P and X
@@ -1356,34 +1369,38 @@ static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
-	float HP[NUMX], HPHR, Error;
+	float HP[NUMX], K[NUMX], HPHR, Error;
 	uint8_t i, j, k, m;
 
 	for (m = 0; m < NUMV; m++) {
 
 		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
 
+			const uint8_t first = H_nonzero[m].first;
+			const uint8_t last = first + H_nonzero[m].count;
+
 			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
-				HP[j] = 0;
-				for (k = 0; k < NUMX; k++)
+				HP[j] = 0.0f;
+				for (k = first; k < last; k++)
 					HP[j] += H[m][k] * P[k][j];
 			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
+			for (k = first; k < last; k++)
 				HPHR += HP[k] * H[m][k];
 
 			for (k = 0; k < NUMX; k++)
-				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+				K[k] = HP[k] / HPHR;	// find K = HP/HPHR
 
 			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
+				const float Ki = K[i];
 				for (j = i; j < NUMX; j++)
 					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
+					    P[i][j] - Ki * HP[j];
 			}
 
 			Error = Z[m] - Y[m];
 			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
-				X[i] = X[i] + K[i][m] * Error;
+				X[i] = X[i] + K[i] * Error;
 
 		}
 	}
@@ -90,6 +90,18 @@ static MixerSettingsData mixerSettings;
 // Ditto, for the actuator settings.
 static ActuatorSettingsData actuatorSettings;
 
+/**
+ * The mixer settings compiled into one row of gains per output channel,
+ * already scaled by MULTIROTOR_MIXER_UPPER_BOUND, so that each cycle is a
+ * single pass over a dense matrix instead of a walk through the per
+ * channel fields of MixerSettings.
+ */
+static struct {
+	float matrix[MAX_MIX_ACTUATORS][MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+	uint8_t type[MAX_MIX_ACTUATORS];
+	uint8_t num_mixers;
+} compiled_mixer;
+
 // Private functions
 static void actuator_task(void* parameters);
 static float scale_channel(float value, int idx);
@@ -98,10 +110,9 @@ static float throt_curve(const float input, const float* curve, uint8_t num_poin
 static float collective_curve(const float input, const float* curve, uint8_t num_points);
 static bool set_channel(uint8_t mixer_channel, float value);
 static void actuator_set_servo_mode(void);
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired);
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2);
+static void compile_mixer(void);
+static float process_mixer(const int index, const float *inputs);
+static float mix_channel(int ct, const float *inputs);
 
 static MixerSettingsMixer1TypeOptions get_mixer_type(int idx);
 static typeof(mixerSettings.Mixer1Vector) *get_mixer_vec(int idx);
@@ -257,6 +268,7 @@ static void actuator_task(void* parameters)
 			mixer_settings_updated = false;
 			MixerSettingsGet(&mixerSettings);
 			SystemSettingsAirframeTypeGet(&airframe_type);
+			compile_mixer();
 		}
 
 		if (rc != true) {
@@ -297,14 +309,7 @@ static void actuator_task(void* parameters)
 			manualControlCommandUpdated = false;
 		}
 
-		int nMixers = 0;
-
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			if (get_mixer_type(ct) != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
-				nMixers++;
-			}
-		}
-		if ((nMixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
+		if ((compiled_mixer.num_mixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
 			set_failsafe(); // So that channels like PWM buzzer keep working
 			continue;
 		}
@@ -352,6 +357,14 @@ static void actuator_task(void* parameters)
 				mixerSettings.ThrottleCurve2,
 				MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
 
+		// Inputs to the mixer matrix, in the order of the mixer vectors
+		float inputs[MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+		inputs[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] = curve1;
+		inputs[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] = curve2;
+		inputs[MIXERSETTINGS_MIXER1VECTOR_ROLL] = desired.Roll;
+		inputs[MIXERSETTINGS_MIXER1VECTOR_PITCH] = desired.Pitch;
+		inputs[MIXERSETTINGS_MIXER1VECTOR_YAW] = desired.Yaw;
+
 		float * status = (float *)&mixerStatus; //access status objects as an array of floats
 
 		float min_chan = INFINITY;
@@ -360,9 +373,9 @@ static void actuator_task(void* parameters)
 		int num_motors = 0;
 
 		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			status[ct] = mix_channel(ct, &desired, curve1, curve2);
+			status[ct] = mix_channel(ct, inputs);
 
-			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+			if (compiled_mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
 				min_chan = fminf(min_chan, status[ct]);
 				max_chan = fmaxf(max_chan, status[ct]);
 
@@ -417,7 +430,7 @@ static void actuator_task(void* parameters)
 
 		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
 			// Motors have additional protection for when to be on
-			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+			if (compiled_mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
 				if (!armed) {
 					status[ct] = -1;  //force min throttle
 				} else if (!stabilize_now) {
@@ -479,22 +492,45 @@ static void actuator_task(void* parameters)
 }
 
 /**
- *Process mixing for one actuator
+ * Compile the mixer settings into the dense gain matrix and type table.
+ * Called whenever MixerSettings change, so the per channel field lookups
+ * stay out of the control loop.
  */
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired)
+static void compile_mixer(void)
 {
-	// Taking the pointer to the array preserves type information so smart compilers
-	// can detect accesses past the end.
-	typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(index);
+	compiled_mixer.num_mixers = 0;
+
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		// Taking the pointer to the array preserves type information so smart compilers
+		// can detect accesses past the end.
+		typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(ct);
 
-	float result = (((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] * curve1) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] * curve2) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_ROLL] * desired->Roll) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_PITCH] * desired->Pitch) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_YAW] * desired->Yaw)) * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND);
+		compiled_mixer.type[ct] = get_mixer_type(ct);
+		if (compiled_mixer.type[ct] != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
+			compiled_mixer.num_mixers++;
+		}
 
-	return (result);
+		// Scaling by a power of two is exact, so this mixes bit for bit
+		// the same as scaling the sum afterwards
+		for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++) {
+			compiled_mixer.matrix[ct][i] = (*vector)[i] * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND);
+		}
+	}
+}
+
+/**
+ * Process mixing for one actuator: one row of the mixer matrix times the inputs
+ */
+static float process_mixer(const int index, const float *inputs)
+{
+	const float *row = compiled_mixer.matrix[index];
+
+	float result = 0;
+	for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++) {
+		result += row[i] * inputs[i];
+	}
+
+	return result;
 }
 
 /**
@@ -724,10 +760,9 @@ static void actuator_set_servo_mode(void)
 			actuatorSettings.ChannelMin);
 }
 
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2)
+static float mix_channel(int ct, const float *inputs)
 {
-	MixerSettingsMixer1TypeOptions type = get_mixer_type(ct);
+	MixerSettingsMixer1TypeOptions type = compiled_mixer.type[ct];
 
 	switch (type) {
 	case MIXERSETTINGS_MIXER1TYPE_DISABLED:
@@ -736,14 +771,8 @@ static float mix_channel(int ct, ActuatorDesiredData *desired,
 		break;
 
 	case MIXERSETTINGS_MIXER1TYPE_SERVO:
-		return process_mixer(ct, curve1, curve2, desired);
-		break;
-
 	case MIXERSETTINGS_MIXER1TYPE_MOTOR:
-		(void) 0;               // nil statement
-		float val = process_mixer(ct, curve1, curve2, desired);
-
-		return val;
+		return process_mixer(ct, inputs);
 		break;
 	// If an accessory channel is selected for direct bypass mode
 	// In this configuration the accessory channel is scaled and
@@ -80,8 +80,28 @@ const char DIGITS[16] = "0123456789abcdef";
 
 #define LOGGING_PERIOD_MS 100
 
+// Objects that can be delta encoded, and room for their reference copies
+#ifndef LOG_DELTA_MAX_INSTANCES
+#define LOG_DELTA_MAX_INSTANCES 64
+#endif
+#ifndef LOG_DELTA_POOL_BYTES
+#define LOG_DELTA_POOL_BYTES 4096
+#endif
+
+// Longest time between complete copies of a delta encoded object
+#define LOG_KEYFRAME_PERIOD_MS 1000
+
 // Private types
 
+//! The copy of an object a delta encoded update is relative to
+struct log_delta_ref {
+	UAVObjHandle obj;
+	uint16_t instId;
+	bool valid;
+	uint32_t keyframe_time;
+	UAVTalkDeltaRef delta;
+};
+
 // Private variables
 static UAVTalkConnection uavTalkCon;
 static struct pios_thread *loggingTaskHandle;
@@ -93,6 +113,8 @@ static LoggingStatsData loggingData;
 static void    loggingTask(void *parameters);
 static int32_t send_data(uint8_t *data, int32_t length);
 static int32_t send_data_nonblock(uint8_t *data, int32_t length);
+static uint8_t *reserve_data(uint16_t length);
+static int32_t commit_data(uint16_t length);
 static uint16_t get_minimum_logging_period();
 static void unregister_object(UAVObjHandle obj);
 static void register_object(UAVObjHandle obj);
@@ -101,11 +123,20 @@ static void logAll(UAVObjHandle obj);
 static void logSettings(UAVObjHandle obj);
 static void writeHeader();
 static void updateSettings();
+static void updateBytesDropped();
+static void resetDeltaRefs();
+static void logObject(UAVObjHandle obj, uint16_t instId);
 
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
+static uint32_t dropped_bytes;
 static bool destination_onboard_flash;
+static bool delta_encoding;
+static struct log_delta_ref *delta_refs;
+static uint8_t *delta_pool;
+static uint16_t delta_refs_used;
+static uint16_t delta_pool_used;
 
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
 static const struct streamfs_cfg streamfs_settings = {
@@ -185,6 +216,7 @@ int32_t LoggingInitialize(void)
 		module_enabled = false;
 		return -1;
 	}
+	UAVTalkSetTxReservation(uavTalkCon, &reserve_data, &commit_data);
 	
 	return 0;
 }
@@ -323,6 +355,9 @@ static void loggingTask(void *parameters)
 			// Write information at start of the log file
 			writeHeader();
 
+			// Deltas must not refer to anything before this file
+			resetDeltaRefs();
+
 			// Log settings
 			if (settings.InitiallyLog == LOGGINGSETTINGS_INITIALLYLOG_ALLOBJECTS) {
 				UAVObjIterate(&logAll);
@@ -343,6 +378,7 @@ static void loggingTask(void *parameters)
 
 			// Empty the queue
 			LoggingStatsBytesLoggedSet(&written_bytes);
+			updateBytesDropped();
 			loggingData.Operation = LOGGINGSTATS_OPERATION_LOGGING;
 			LoggingStatsSet(&loggingData);
 			break;
@@ -352,6 +388,7 @@ static void loggingTask(void *parameters)
 				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
 
 				LoggingStatsBytesLoggedSet(&written_bytes);
+				updateBytesDropped();
 
 				now = PIOS_Thread_Systime();
 			}
@@ -453,8 +490,10 @@ static void logSettings(UAVObjHandle obj)
  */
 static int32_t send_data(uint8_t *data, int32_t length)
 {
-	if (PIOS_COM_SendBuffer(logging_com_id, data, length) < 0)
+	if (PIOS_COM_SendBuffer(logging_com_id, data, length) < 0) {
+		dropped_bytes += length;
 		return -1;
+	}
 
 	written_bytes += length;
 
@@ -463,8 +502,53 @@ static int32_t send_data(uint8_t *data, int32_t length)
 
 static int32_t send_data_nonblock(uint8_t *data, int32_t length)
 {
-	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0)
+	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0) {
+		// The output fell behind
+		dropped_bytes += length;
 		return -1;
+	}
+
+	written_bytes += length;
+
+	return length;
+}
+
+/**
+ * Publish the number of log bytes lost so far, both those the output could
+ * not accept and those the flash could not store
+ */
+static void updateBytesDropped()
+{
+	uint32_t bytes_dropped = dropped_bytes;
+
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+	if (destination_onboard_flash) {
+		int32_t flash_dropped = PIOS_STREAMFS_DroppedBytes(logging_com_id);
+
+		if (flash_dropped > 0) {
+			bytes_dropped += flash_dropped;
+		}
+	}
+#endif
+
+	LoggingStatsBytesDroppedSet(&bytes_dropped);
+}
+
+/**
+ * Reserve room for a packet in the log output, so that objects are packed
+ * straight into it. Falls back to send_data_nonblock() when NULL.
+ */
+static uint8_t *reserve_data(uint16_t length)
+{
+	return PIOS_COM_ReserveTx(logging_com_id, length);
+}
+
+static int32_t commit_data(uint16_t length)
+{
+	if (PIOS_COM_CommitTx(logging_com_id, length) < 0) {
+		dropped_bytes += length;
+		return -1;
+	}
 
 	written_bytes += length;
 
@@ -484,7 +568,94 @@ static void obj_updated_callback(UAVObjEvent * ev, void* cb_ctx, void *uavo_data
 		return;
 	}
 
-	UAVTalkSendObjectTimestamped(uavTalkCon, ev->obj, ev->instId, false, 0);
+	logObject(ev->obj, ev->instId);
+}
+
+/**
+ * Forget all delta references, and allocate the tables on first use. Delta
+ * encoding is turned off if there is no memory for them.
+ */
+static void resetDeltaRefs()
+{
+	delta_encoding = settings.Encoding == LOGGINGSETTINGS_ENCODING_DELTA;
+
+	if (delta_encoding && !delta_refs) {
+		delta_refs = PIOS_malloc_no_dma(LOG_DELTA_MAX_INSTANCES * sizeof(*delta_refs));
+		delta_pool = PIOS_malloc_no_dma(LOG_DELTA_POOL_BYTES);
+
+		if (!delta_refs || !delta_pool) {
+			delta_encoding = false;
+			return;
+		}
+	}
+
+	delta_refs_used = 0;
+	delta_pool_used = 0;
+}
+
+/**
+ * Find the delta reference of an object instance, making one if there is
+ * room left
+ * \return NULL if the object can not be delta encoded
+ */
+static struct log_delta_ref *getDeltaRef(UAVObjHandle obj, uint16_t instId)
+{
+	for (int i = 0; i < delta_refs_used; i++) {
+		if (delta_refs[i].obj == obj && delta_refs[i].instId == instId) {
+			return &delta_refs[i];
+		}
+	}
+
+	uint16_t length = UAVObjGetNumBytes(obj);
+	if (delta_refs_used >= LOG_DELTA_MAX_INSTANCES ||
+			delta_pool_used + length > LOG_DELTA_POOL_BYTES) {
+		return NULL;
+	}
+
+	struct log_delta_ref *ref = &delta_refs[delta_refs_used++];
+	ref->obj = obj;
+	ref->instId = instId;
+	ref->valid = false;
+	ref->delta.data = &delta_pool[delta_pool_used];
+	ref->delta.keyframeStamp = 0;
+	ref->delta.sequence = 0;
+	delta_pool_used += length;
+
+	return ref;
+}
+
+/**
+ * Log an object update, as a delta from the previous update when enabled.
+ * A complete copy is logged at least every LOG_KEYFRAME_PERIOD_MS so that
+ * a reader can start decoding part way through and recovers from lost data.
+ * \param[in] obj Object to log
+ * \param[in] instId The instance ID
+ */
+static void logObject(UAVObjHandle obj, uint16_t instId)
+{
+	struct log_delta_ref *ref = NULL;
+
+	if (delta_encoding) {
+		ref = getDeltaRef(obj, instId);
+	}
+
+	if (!ref) {
+		UAVTalkSendObjectTimestamped(uavTalkCon, obj, instId, false, 0);
+		return;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	bool keyframe = !ref->valid ||
+		(now - ref->keyframe_time) >= LOG_KEYFRAME_PERIOD_MS;
+
+	int32_t rc = UAVTalkSendObjectDeltaTimestamped(uavTalkCon, obj, instId,
+			&ref->delta, keyframe);
+	if (rc >= 0) {
+		ref->valid = true;
+		if (rc == 1) {
+			ref->keyframe_time = now;
+		}
+	}
 }
 
 
@@ -168,6 +168,11 @@ static void SensorsTask(void *parameters)
 	AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
 
 	PIOS_SENSORS_SetMaxGyro(500);
+
+	// Step the models on the system clock, so that in lockstep they run
+	// on virtual time at exactly the sensor rate
+	uint32_t last_step = PIOS_Thread_Systime();
+
 	// Main task loop
 	while (1) {
 		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
@@ -221,8 +226,7 @@ static void SensorsTask(void *parameters)
 				simulateModelCar();
 		}
 
-		PIOS_Thread_Sleep(2);
-
+		PIOS_Thread_Sleep_Until(&last_step, SENSOR_PERIOD);
 	}
 }
 
@@ -54,8 +54,40 @@
 #define CONNECTION_TIMEOUT_MS 8000
 #define USB_ACTIVITY_TIMEOUT_MS 6000
 
+// Updates waiting for link budget, at most one per object instance
+#ifndef TELEM_MAX_PENDING
+#define TELEM_MAX_PENDING 24
+#endif
+
+// Share of the serial link the scheduler plans to use, leaving headroom
+// for framing and radio overhead
+#define LINK_BUDGET_PERCENT 90
+
+// Objects streamed faster than this are the first to give way
+#define FAST_UPDATE_PERIOD_MS 500
+
+// Updates that waited this long are sent ahead of everything else
+#define PENDING_MAX_AGE_MS 1000
+
+// UAVTalk header (with instance id) and checksum, per object sent
+#define PACKET_OVERHEAD_BYTES 11
+
 // Private types
 
+//! Scheduling classes, lower is sent first
+enum telem_priority {
+	TELEM_PRIO_HIGH = 0,	/**< Acked, on change and settings objects */
+	TELEM_PRIO_NORMAL,	/**< Slow periodic and throttled objects */
+	TELEM_PRIO_LOW,		/**< Fast periodic and throttled streams */
+};
+
+//! An update waiting to be sent
+struct telem_pending {
+	UAVObjEvent ev;
+	uint32_t queued_at;
+	uint8_t priority;
+};
+
 // Private variables
 static struct pios_queue *queue;
 
@@ -63,6 +95,19 @@ static uint32_t txErrors;
 static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
+static uintptr_t reservedPort;
+
+static struct telem_pending pending[TELEM_MAX_PENDING];
+static uint8_t numPending;
+
+// Token bucket, in bytes. May go negative when an object larger than the
+// balance is sent; nothing else is sent until it is paid back.
+static uint32_t linkBudget;		// bytes per second, 0 when unlimited
+static int32_t tokens;
+static uint32_t tokensUpdated;
+
+static uint32_t txDroppedBytes;
+static uint32_t txCoalesced;
 
 #if defined(PIOS_INCLUDE_USB)
 static volatile uint32_t usb_timeout_time;
@@ -72,13 +117,19 @@ static volatile uint32_t usb_timeout_time;
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 static int32_t transmitData(uint8_t * data, int32_t length);
+static uint8_t *reserveTransmit(uint16_t length);
+static int32_t commitTransmit(uint16_t length);
 static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static void processObjEvent(UAVObjEvent * ev);
+static void scheduleObjEvent(const UAVObjEvent * ev);
+static void sendPending();
+static uint32_t pendingTimeout();
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
 static void updateSettings();
+static uint32_t getSpeedBps(HwSharedSpeedBpsOptions speed);
 static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev, void *ctx, void *obj,
 		int len);
@@ -132,6 +183,7 @@ int32_t TelemetryInitialize(void)
 
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkSetTxReservation(uavTalkCon, &reserveTransmit, &commitTransmit);
 
 	if (SessionManagingInitialize() == -1) {
 		return -1;
@@ -295,12 +347,205 @@ static void telemetryTxTask(void *parameters)
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
+		// Wait for queue message, or for the link budget to allow
+		// sending what is pending
+		if (PIOS_Queue_Receive(queue, &ev, pendingTimeout()) == true) {
+			// Drain the queue so repeated updates coalesce
+			do {
+				if (ev.obj == 0 || ev.obj == FlightTelemetryStatsHandle() ||
+						ev.obj == GCSTelemetryStatsHandle()) {
+					// Statistics and handshake are never held back
+					processObjEvent(&ev);
+				} else {
+					scheduleObjEvent(&ev);
+				}
+			} while (PIOS_Queue_Receive(queue, &ev, 0) == true);
+		}
+
+		sendPending();
+	}
+}
+
+/**
+ * Scheduling class of an object, from its metadata. Event driven and
+ * acked objects carry state changes and go first. Of the streamed
+ * objects, the fast ones lose the least when an update is late.
+ */
+static uint8_t getPriority(UAVObjHandle obj)
+{
+	UAVObjMetadata metadata;
+
+	if (UAVObjIsMetaobject(obj) || UAVObjIsSettings(obj)) {
+		return TELEM_PRIO_HIGH;
+	}
+
+	UAVObjGetMetadata(obj, &metadata);
+
+	if (UAVObjGetTelemetryAcked(&metadata)) {
+		return TELEM_PRIO_HIGH;
+	}
+
+	switch (UAVObjGetTelemetryUpdateMode(&metadata)) {
+	case UPDATEMODE_PERIODIC:
+	case UPDATEMODE_THROTTLED:
+		if (metadata.telemetryUpdatePeriod < FAST_UPDATE_PERIOD_MS) {
+			return TELEM_PRIO_LOW;
+		}
+		return TELEM_PRIO_NORMAL;
+	case UPDATEMODE_ONCHANGE:
+	case UPDATEMODE_MANUAL:
+	default:
+		return TELEM_PRIO_HIGH;
+	}
+}
+
+/**
+ * Bytes on the link to send an event's object
+ */
+static uint32_t eventCost(const UAVObjEvent * ev)
+{
+	uint32_t instances = 1;
+
+	if (ev->instId == UAVOBJ_ALL_INSTANCES) {
+		instances = UAVObjGetNumInstances(ev->obj);
+	}
+
+	return instances * (UAVObjGetNumBytes(ev->obj) + PACKET_OVERHEAD_BYTES);
+}
+
+/**
+ * Add an update to the pending set. An event for an object instance that
+ * is already pending is merged with it, since the data is only read when
+ * sent.
+ * When the set is full the least important, oldest update is dropped.
+ */
+static void scheduleObjEvent(const UAVObjEvent * ev)
+{
+	for (int i = 0; i < numPending; i++) {
+		if (pending[i].ev.obj == ev->obj && pending[i].ev.instId == ev->instId &&
+				pending[i].ev.event == ev->event) {
+			txCoalesced++;
+			return;
+		}
+	}
+
+	uint8_t priority = getPriority(ev->obj);
+
+	if (numPending == TELEM_MAX_PENDING) {
+		int victim = 0;
+
+		for (int i = 1; i < numPending; i++) {
+			if (pending[i].priority > pending[victim].priority ||
+					(pending[i].priority == pending[victim].priority &&
+					 (int32_t) (pending[i].queued_at - pending[victim].queued_at) < 0)) {
+				victim = i;
+			}
+		}
+
+		if (pending[victim].priority < priority) {
+			// Everything pending is more important
+			txDroppedBytes += eventCost(ev);
+			return;
+		}
+
+		txDroppedBytes += eventCost(&pending[victim].ev);
+		pending[victim] = pending[--numPending];
+	}
+
+	pending[numPending].ev = *ev;
+	pending[numPending].queued_at = PIOS_Thread_Systime();
+	pending[numPending].priority = priority;
+	numPending++;
+}
+
+/**
+ * Index of the pending update to send next: the highest class, oldest
+ * first, with updates that waited too long promoted to the top.
+ */
+static int nextPending(uint32_t now)
+{
+	int best = -1;
+	uint8_t best_priority = 0;
+
+	for (int i = 0; i < numPending; i++) {
+		uint8_t priority = pending[i].priority;
+
+		if (now - pending[i].queued_at > PENDING_MAX_AGE_MS) {
+			priority = TELEM_PRIO_HIGH;
+		}
+
+		if (best < 0 || priority < best_priority ||
+				(priority == best_priority &&
+				 (int32_t) (pending[i].queued_at - pending[best].queued_at) < 0)) {
+			best = i;
+			best_priority = priority;
 		}
 	}
+
+	return best;
+}
+
+/**
+ * Budget of the link that is in use, in bytes per second, 0 if unlimited
+ */
+static uint32_t currentBudget()
+{
+	if (getComPort() == PIOS_COM_TELEM_RF) {
+		return linkBudget;
+	}
+
+	return 0;
+}
+
+/**
+ * Send pending updates for as long as the link budget allows
+ */
+static void sendPending()
+{
+	uint32_t budget = currentBudget();
+	uint32_t now = PIOS_Thread_Systime();
+
+	if (budget) {
+		int32_t burst = budget / 10;
+
+		tokens += (int32_t) ((uint64_t) (now - tokensUpdated) * budget / 1000);
+		if (tokens > burst) {
+			tokens = burst;
+		}
+	}
+	tokensUpdated = now;
+
+	while (numPending > 0 && (budget == 0 || tokens >= 0)) {
+		int next = nextPending(now);
+		UAVObjEvent ev = pending[next].ev;
+
+		pending[next] = pending[--numPending];
+
+		if (budget) {
+			tokens -= (int32_t) eventCost(&ev);
+		}
+
+		processObjEvent(&ev);
+	}
+}
+
+/**
+ * How long the transmit task may wait for new events before the budget
+ * allows sending what is pending.
+ */
+static uint32_t pendingTimeout()
+{
+	if (numPending == 0) {
+		return PIOS_QUEUE_TIMEOUT_MAX;
+	}
+
+	uint32_t budget = currentBudget();
+
+	if (budget == 0 || tokens >= 0) {
+		return 0;
+	}
+
+	return (uint32_t) (-tokens) * 1000 / budget + 1;
 }
 
 #if defined(PIOS_INCLUDE_USB)
@@ -398,6 +643,33 @@ static int32_t transmitData(uint8_t * data, int32_t length)
 	return -1;
 }
 
+/**
+ * Reserve space for a packet directly in the transmit buffer of the
+ * modem or USB port.
+ * \param[in] length Length of the packet
+ * \return NULL if there is no room, UAVTalk then uses transmitData()
+ * \return pointer to length bytes to fill in otherwise
+ */
+static uint8_t *reserveTransmit(uint16_t length)
+{
+	reservedPort = getComPort();
+
+	if (reservedPort)
+		return PIOS_COM_ReserveTx(reservedPort, length);
+
+	return NULL;
+}
+
+/**
+ * Send the packet built by the last reserveTransmit().
+ * \param[in] length Length of the packet
+ * \return number of bytes transmitted
+ */
+static int32_t commitTransmit(uint16_t length)
+{
+	return PIOS_COM_CommitTx(reservedPort, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -459,17 +731,26 @@ static void updateTelemetryStats()
 		flightStats.RxFailures += utalkStats.rxErrors;
 		flightStats.TxFailures += txErrors;
 		flightStats.TxRetries += txRetries;
+		flightStats.TxDroppedBytes += txDroppedBytes;
+		flightStats.TxCoalesced += txCoalesced;
 		txErrors = 0;
 		txRetries = 0;
+		txDroppedBytes = 0;
+		txCoalesced = 0;
 	} else {
 		flightStats.RxDataRate = 0;
 		flightStats.TxDataRate = 0;
 		flightStats.RxFailures = 0;
 		flightStats.TxFailures = 0;
 		flightStats.TxRetries = 0;
+		flightStats.TxDroppedBytes = 0;
+		flightStats.TxCoalesced = 0;
 		txErrors = 0;
 		txRetries = 0;
+		txDroppedBytes = 0;
+		txCoalesced = 0;
 	}
+	flightStats.TxLinkBudget = currentBudget();
 
 	// Check for connection timeout
 	timeNow = PIOS_Thread_Systime();
@@ -534,10 +815,44 @@ static void updateSettings()
 		ModuleSettingsTelemetrySpeedGet(&speed);
 
 		PIOS_HAL_ConfigureSerialSpeed(PIOS_COM_TELEM_RF, speed);
+
+		// 10 bits per byte on the wire
+		linkBudget = getSpeedBps(speed) / 10 * LINK_BUDGET_PERCENT / 100;
 	}
 #endif
 }
 
+/**
+ * Baud rate the serial port is configured to for a speed setting
+ */
+static uint32_t getSpeedBps(HwSharedSpeedBpsOptions speed)
+{
+	switch (speed) {
+	case HWSHARED_SPEEDBPS_1200:
+		// PIOS_HAL_ConfigureSerialSpeed() sets 2400 for this one
+	case HWSHARED_SPEEDBPS_2400:
+		return 2400;
+	case HWSHARED_SPEEDBPS_4800:
+		return 4800;
+	case HWSHARED_SPEEDBPS_9600:
+		return 9600;
+	case HWSHARED_SPEEDBPS_19200:
+		return 19200;
+	case HWSHARED_SPEEDBPS_38400:
+		return 38400;
+	case HWSHARED_SPEEDBPS_57600:
+		return 57600;
+	case HWSHARED_SPEEDBPS_230400:
+		return 230400;
+	case HWSHARED_SPEEDBPS_115200:
+	case HWSHARED_SPEEDBPS_INITHC05:
+	case HWSHARED_SPEEDBPS_INITHC06:
+	case HWSHARED_SPEEDBPS_INITHM10:
+	default:
+		return 115200;
+	}
+}
+
 /**
  * Determine input/output com port as highest priority available
  */
@@ -42,6 +42,9 @@
 #endif
 
 #include <unistd.h>
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+#include <sys/time.h>
+#endif
 
 /*===========================================================================*/
 /* Port interrupt handlers.                                                  */
@@ -155,6 +158,40 @@ void port_suspend(void) {
 void port_enable(void) {
 }
 
+/* Whether the system time is virtual, see port_enable_lockstep() */
+static bool_t lockstep;
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+/**
+ * @brief   Stops the tick timer and runs on virtual time instead.
+ * @details The system time then only advances when every thread is waiting,
+ *          by one tick each time the idle thread gets to run, so the system
+ *          runs as fast as the host allows and no thread is ever preempted
+ *          by the tick.  A thread that never waits stops the clock.
+ * @note    Not available on Windows, which has no interval timer to stop.
+ */
+void port_enable_lockstep(void) {
+  struct itimerval itimer = {
+    .it_interval = { 0, 0 },
+    .it_value = { 0, 0 },
+  };
+
+  if (setitimer(PORT_TIMER_TYPE, &itimer, NULL) < 0)
+    port_halt();
+
+  lockstep = TRUE;
+}
+#endif
+
+/**
+ * @brief   Tells whether the system runs on virtual time.
+ *
+ * @return              TRUE after port_enable_lockstep().
+ */
+bool_t port_is_lockstep(void) {
+  return lockstep;
+}
+
 /**
  * @brief   Enters an architecture-dependent IRQ-waiting mode.
  * @details The function is meant to return when an interrupt becomes pending.
@@ -163,6 +200,14 @@ void port_enable(void) {
  *          modes.
  */
 void port_wait_for_interrupt(void) {
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+  if (lockstep) {
+    /* Every thread is waiting, so deliver the next tick right away */
+    port_tick_signal_handler(PORT_TIMER_SIGNAL, NULL, NULL);
+    return;
+  }
+#endif
+
 	select(0, NULL, NULL, NULL, NULL);
 }
 
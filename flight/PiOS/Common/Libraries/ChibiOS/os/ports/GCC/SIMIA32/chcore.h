@@ -261,6 +261,10 @@ extern "C" {
   void port_wait_for_interrupt(void);
   void port_halt(void);
   void port_switch(Thread *ntp, Thread *otp);
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+  void port_enable_lockstep(void);
+#endif
+  bool_t port_is_lockstep(void);
 
   void _port_thread_start(void (*func)(int), int arg);
 #ifdef __cplusplus
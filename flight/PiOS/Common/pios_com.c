@@ -382,6 +382,91 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return sent;
 }
 
+/**
+* Reserves contiguous space at the head of the transmit fifo so that the
+* caller can build a packet in place instead of copying it in.  The port
+* stays locked until the reservation is handed to PIOS_COM_CommitTx().
+* \param[in] port COM port
+* \param[in] len number of bytes to reserve
+* \return pointer to len writable bytes
+* \return NULL if the port is unavailable, busy, or the free space is not
+*         contiguous; the caller should fall back to PIOS_COM_SendBuffer()
+*/
+uint8_t *PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return NULL;
+	}
+
+	PIOS_Assert(com_dev->tx);
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, 0) != true) {
+		return NULL;
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	uint16_t contig = 0;
+	uint8_t *pos = NULL;
+
+	/* A device that is down is handled as a data sink by the copying
+	 * path, so leave it to that */
+	if (!com_dev->driver->available || com_dev->driver->available(com_dev->lower_id)) {
+		pos = circ_queue_write_pos(com_dev->tx, &contig, NULL);
+	}
+
+	if (pos == NULL || contig < len) {
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+		PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+		return NULL;
+	}
+
+	return pos;
+}
+
+/**
+* Makes the data written to a reservation from PIOS_COM_ReserveTx()
+* available to the driver and releases the port.
+* \param[in] port COM port
+* \param[in] len number of bytes filled in, at most the reserved length.
+*            Zero cancels the reservation.
+* \return -1 if port not available
+* \return number of bytes queued on success
+*/
+int32_t PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->tx);
+
+	if (len > 0) {
+		circ_queue_advance_write_multi(com_dev->tx, len);
+
+		if (com_dev->driver->tx_start) {
+			uint16_t tx_avail;
+
+			circ_queue_read_pos(com_dev->tx, NULL, &tx_avail);
+			com_dev->driver->tx_start(com_dev->lower_id,
+						  tx_avail);
+		}
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+
+	return len;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memcpy */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -51,6 +52,12 @@
  * sector has a footer to indicate the file id and the sector id.
  *
  * Arenas map onto sectors. 
+ *
+ * Logged data is combined in RAM into blocks of write_size bytes that
+ * are aligned within the arena, and a block is only programmed once it
+ * is full (or the file is closed). With write_size a multiple of the
+ * flash page size this programs each page once, instead of once per
+ * fragment the logger happened to queue.
  */
 
 #include <pios_com.h>
@@ -88,11 +95,18 @@ struct streamfs_state {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
-	uint8_t *com_buffer;
+
+	/* Block being combined, starting at active_file_arena_offset */
+	uint8_t *write_buf;
+	uint16_t write_buf_len;
+
+	/* Bytes lost to flash errors, to a full file or arriving with no file open */
+	uint32_t dropped_bytes;
 
 	/* Information for current file handle */
 	bool file_open_writing;
 	bool file_open_reading;
+	bool file_full;		/* The next arena could not be started */
 	int32_t active_file_id;
 	int32_t active_file_segment;
 	int32_t active_file_arena;
@@ -366,6 +380,9 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 	if (streamfs->file_open_reading)
 		return -2;
 
+	if (streamfs->file_full)
+		return -5;
+
 	uint32_t total_written = 0;
 
 	while (len > 0) {
@@ -391,6 +408,8 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 
 		if (streamfs->active_file_arena_offset >= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer))) {
 			if (streamfs_new_sector(streamfs) != 0) {
+				// The file cannot grow any further, drop the rest
+				streamfs->file_full = true;
 				return -4;
 			}
 		}
@@ -399,6 +418,79 @@ static int32_t streamfs_append_to_file(struct streamfs_state *streamfs, uint8_t
 	return total_written;
 }
 
+/**
+ * @brief Room left in the write buffer before the block it holds is complete
+ * @return number of bytes that can still be buffered
+ */
+static uint32_t streamfs_buffer_space(const struct streamfs_state *streamfs)
+{
+	uint32_t write_size = streamfs->cfg->write_size;
+	uint32_t data_size = streamfs->cfg->arena_size - sizeof(struct streamfs_footer);
+
+	/* Data for a full file is only collected to be dropped, a whole
+	 * buffer at a time */
+	if (streamfs->file_full) {
+		return write_size - streamfs->write_buf_len;
+	}
+
+	/* Blocks are aligned to write_size, the last one of an arena is cut
+	 * short by the footer */
+	uint32_t block_end = (streamfs->active_file_arena_offset / write_size + 1) * write_size;
+	if (block_end > data_size) {
+		block_end = data_size;
+	}
+
+	return block_end - streamfs->active_file_arena_offset - streamfs->write_buf_len;
+}
+
+/**
+ * @brief Program the buffered data to the file. The data is discarded
+ * (and counted as dropped) if it cannot be written.
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_flush_buffer(struct streamfs_state *streamfs)
+{
+	if (streamfs->write_buf_len == 0) {
+		return 0;
+	}
+
+	int32_t rc = streamfs_append_to_file(streamfs, streamfs->write_buf, streamfs->write_buf_len);
+	if (rc < 0) {
+		streamfs->dropped_bytes += streamfs->write_buf_len;
+	}
+
+	streamfs->write_buf_len = 0;
+
+	return (rc < 0) ? rc : 0;
+}
+
+/**
+ * @brief Move data queued on the COM interface into the write buffer,
+ * up to the end of the current block
+ * @return number of bytes moved
+ */
+static int32_t streamfs_fill_buffer(struct streamfs_state *streamfs)
+{
+	if (!streamfs->tx_out_cb) {
+		return 0;
+	}
+
+	uint32_t space = streamfs->cfg->write_size - streamfs->write_buf_len;
+	if (streamfs->file_open_writing) {
+		space = streamfs_buffer_space(streamfs);
+	}
+
+	uint16_t bytes_read = (streamfs->tx_out_cb)(
+			streamfs->tx_out_context,
+			&streamfs->write_buf[streamfs->write_buf_len],
+			space, NULL, NULL);
+
+	streamfs->write_buf_len += bytes_read;
+
+	return bytes_read;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t *data, uint32_t len)
 {
@@ -519,17 +611,25 @@ static void PIOS_STREAMFS_Task(void *parameters)
 	PIOS_Assert(tmp);
 
 	while (1) {
-		int32_t bytes_to_write = 0;
-
-		if (streamfs->tx_out_cb) {
-			bytes_to_write = (streamfs->tx_out_cb)(
-				streamfs->tx_out_context,
-				streamfs->com_buffer,
-				streamfs->cfg->write_size,
-				NULL, NULL);
+		if (streamfs->file_open_writing && streamfs_buffer_space(streamfs) == 0) {
+			// A whole block is buffered, program it
+			if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
+				PIOS_Mutex_Unlock(streamfs->mutex);
+				PIOS_Thread_Sleep(50);	// Don't spin
+				tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+				PIOS_Assert(tmp);
+				continue;
+			}
+
+			streamfs_flush_buffer(streamfs);
+
+			PIOS_FLASH_end_transaction(streamfs->partition_id);
+			continue;
 		}
 
-		if (bytes_to_write <= 0) {
+		int32_t bytes_read = streamfs_fill_buffer(streamfs);
+
+		if (bytes_read <= 0) {
 			// Block here until woken.
 			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Semaphore_Take(streamfs->sem, PIOS_SEMAPHORE_TIMEOUT_MAX);
@@ -540,32 +640,9 @@ static void PIOS_STREAMFS_Task(void *parameters)
 
 		if (!streamfs->file_open_writing) {
 			// Drain out pending data while file not open
-			continue;
-		}
-
-		if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
-			PIOS_Mutex_Unlock(streamfs->mutex);
-			PIOS_Thread_Sleep(50);	// Don't spin
-			tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
-			PIOS_Assert(tmp);
-			continue;
+			streamfs->dropped_bytes += streamfs->write_buf_len;
+			streamfs->write_buf_len = 0;
 		}
-
-		// Flush available data from PIOS_COM interface to
-		// file system
-		while (bytes_to_write > 0) {
-			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
-				break;
-			}
-
-			bytes_to_write = (streamfs->tx_out_cb)(
-					streamfs->tx_out_context,
-					streamfs->com_buffer,
-					streamfs->cfg->write_size,
-					NULL, NULL);
-		}
-
-		PIOS_FLASH_end_transaction(streamfs->partition_id);
 	}
 }
 
@@ -611,8 +688,8 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
-	streamfs->com_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
-	if (!streamfs->com_buffer) {
+	streamfs->write_buf = (uint8_t *)PIOS_malloc(cfg->write_size);
+	if (!streamfs->write_buf) {
 		PIOS_free(streamfs);
 		return -1;
 	}
@@ -625,10 +702,14 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 
 	streamfs->file_open_writing        = false;
 	streamfs->file_open_reading        = false;
+	streamfs->file_full                = false;
 	streamfs->active_file_id           = 0;
 	streamfs->active_file_arena        = 0;
 	streamfs->active_file_arena_offset = 0;
 
+	streamfs->write_buf_len = 0;
+	streamfs->dropped_bytes = 0;
+
 	streamfs->mutex = PIOS_Mutex_Create();
 
 	if (!streamfs->mutex) {
@@ -764,6 +845,7 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_arena = streamfs_find_new_sector(streamfs);
 	streamfs->active_file_arena_offset = 0;
 	streamfs->file_open_writing = true;
+	streamfs->file_full = false;
 
 	// Erase this sector to prepare for streaming
 	if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
@@ -906,17 +988,26 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
-	if (streamfs->active_file_arena_offset != 0) {
+	// Flush what is still queued on the COM interface, and the partly
+	// filled block
+	do {
+		if (streamfs_buffer_space(streamfs) == 0) {
+			streamfs_flush_buffer(streamfs);
+		}
+	} while (streamfs_fill_buffer(streamfs) > 0);
+
+	streamfs_flush_buffer(streamfs);
+
+	if (streamfs->active_file_arena_offset != 0 && !streamfs->file_full) {
 		// Close segment when something has been written. This avoids creating
-		// null files with an open/close operation
+		// null files with an open/close operation. A full file already
+		// failed to write its last footer
 		if (streamfs_close_sector(streamfs) != 0) {
 			rc = -3;
 			goto out_end_trans;
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
 	streamfs->file_open_writing = false;
 
 	if (streamfs_scan_filesystem(streamfs) != 0) {
@@ -972,6 +1063,25 @@ int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len) {
 	return rc;
 }
 
+/**
+ * Number of bytes that never made it to flash, because the flash could not
+ * be written or because no file was open
+ *
+ * @param[in] fs_id the streaming device handle
+ * @returns the count, or <0 if fs_id is not valid
+ */
+int32_t PIOS_STREAMFS_DroppedBytes(uintptr_t fs_id)
+{
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	if (!streamfs_validate(streamfs)) {
+		return -1;
+	}
+
+	return streamfs->dropped_bytes;
+}
+
 // Testing methods for unit tests
 int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len)
 {
@@ -987,10 +1097,22 @@ int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len
 		goto out_exit;
 	}
 
-	rc = streamfs_append_to_file (streamfs, data, len);
-	if (rc < 0) {
-		rc = -2;
-		goto out_end_trans;
+	// Same write combining as data arriving through the COM interface
+	while (len > 0) {
+		uint32_t bytes_to_copy = MIN(len, streamfs_buffer_space(streamfs));
+
+		memcpy(&streamfs->write_buf[streamfs->write_buf_len], data, bytes_to_copy);
+		streamfs->write_buf_len += bytes_to_copy;
+		data += bytes_to_copy;
+		len -= bytes_to_copy;
+
+		if (streamfs_buffer_space(streamfs) == 0 &&
+				streamfs_flush_buffer(streamfs) != 0) {
+			// The rest of this write is lost too
+			streamfs->dropped_bytes += len;
+			rc = -2;
+			goto out_end_trans;
+		}
 	}
 
 	rc = 0;
@@ -99,6 +99,17 @@ static uint32_t get_monotonic_us_time(void) {
 	return val;
 }
 
+/**
+ * In lockstep the system time is virtual, and so are delays.
+ */
+static bool virtual_time(void) {
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	return port_is_lockstep();
+#else
+	return false;
+#endif
+}
+
 /**
 * Initialises the Timer used by PIOS_DELAY functions<BR>
 * This is called from pios.c as part of the main() function
@@ -125,6 +136,11 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+	// Virtual time can not pass while this thread is running
+	if (virtual_time()) {
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -149,6 +165,10 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+	if (virtual_time()) {
+		return 0;
+	}
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -162,6 +182,12 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	if (virtual_time()) {
+		return chTimeNow() * (1000000 / CH_FREQUENCY);
+	}
+#endif
+
 	uint32_t raw_us = get_monotonic_us_time() - base_time;
 	return raw_us;
 }
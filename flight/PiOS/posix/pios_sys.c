@@ -73,15 +73,24 @@
 #if defined(PIOS_INCLUDE_SYS)
 static bool debug_fpe=false;
 
+/* Options PIOS_Board_Init() needs, see PIOS_SYS_EarlyArgs() */
+static const char *flash_path = "theflash.bin";
+static uint16_t telemetry_port = 9000;
+
+#define SIM_OPTIONS "frLl:s:d:S:F:p:"
+
 #define MAX_SPI_BUSES 16
 int num_spi = 0;
 uintptr_t spi_devs[16];
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f] [-r] [-l logfile] [-s spibase] [-d drvname:bus:id]\n"
+	printf( "usage: %s [-f] [-r] [-L] [-F flashfile] [-p port] [-l logfile] [-s spibase] [-d drvname:bus:id]\n"
 		"\n"
 		"\t-f\tEnables floating point exception trapping mode\n"
 		"\t-r\tGoes realtime-class and pins all memory (requires root)\n"
+		"\t-L\tLockstep: runs on virtual time, as fast as the host allows\n"
+		"\t-F file\tKeeps the flash image in file (default theflash.bin)\n"
+		"\t-p port\tListens for telemetry on this TCP port (default 9000)\n"
 		"\t-l log\tWrites simulation data to a log\n"
 #ifdef PIOS_INCLUDE_SERIAL
 		"\t-S drvname:serialpath\tStarts a serial driver on serialpath\n"
@@ -325,13 +334,59 @@ static void go_realtime() {
 static int saved_argc;
 static char **saved_argv;
 
+/**
+ * Pick out the options that have to be known before PIOS_Board_Init(),
+ * which runs ahead of PIOS_SYS_Args().  These let several simulators run
+ * side by side, each with its own flash image and telemetry port.
+ */
+void PIOS_SYS_EarlyArgs(int argc, char *argv[]) {
+	int opt;
+
+	opterr = 0;
+
+	while ((opt = getopt(argc, argv, SIM_OPTIONS)) != -1) {
+		switch (opt) {
+			case 'F':
+				flash_path = optarg;
+				break;
+			case 'p':
+			{
+				int port = atoi(optarg);
+
+				if (port <= 0 || port > 65535) {
+					printf("Invalid telemetry port %s\n", optarg);
+					exit(1);
+				}
+
+				telemetry_port = port;
+				break;
+			}
+		}
+	}
+
+	/* Let PIOS_SYS_Args() parse everything again */
+	opterr = 1;
+	optind = 1;
+#ifdef __APPLE__
+	optreset = 1;
+#endif
+}
+
+const char *PIOS_SYS_GetFlashPath(void) {
+	return flash_path;
+}
+
+uint16_t PIOS_SYS_GetTelemetryPort(void) {
+	return telemetry_port;
+}
+
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	saved_argc = argc;
 	saved_argv = argv;
 
 	int opt;
 
-	while ((opt = getopt(argc, argv, "frl:s:d:S:")) != -1) {
+	while ((opt = getopt(argc, argv, SIM_OPTIONS)) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe = true;
@@ -339,6 +394,18 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 			case 'r':
 				go_realtime();
 				break;
+			case 'L':
+#if defined(PIOS_INCLUDE_CHIBIOS) && !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+				port_enable_lockstep();
+#else
+				printf("Lockstep needs the ChibiOS simulation port on a POSIX host\n");
+				exit(1);
+#endif
+				break;
+			case 'F':
+			case 'p':
+				/* Handled by PIOS_SYS_EarlyArgs() */
+				break;
 			case 'l':
 			{
 				uintptr_t tmp;
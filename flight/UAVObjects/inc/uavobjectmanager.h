@@ -143,14 +143,27 @@ typedef struct {
 	uint32_t eventCallbackErrors;
 	uint32_t lastCallbackErrorID;
 	uint32_t lastQueueErrorID;
+	uint32_t eventsCoalesced;	/** Events merged into one already pending for the same object and instance */
+	uint16_t maxPendingEvents;	/** Deepest the pending event list has been */
 } UAVObjStats;
 
+/**
+ * Per subscriber event statistics, only collected when built with
+ * UAVO_EVENT_DIAGNOSTICS
+ */
+typedef struct {
+	uint32_t delivered;	/** Events handed to the callback or queue */
+	uint32_t dropped;	/** Events lost to a full queue or pending event list */
+	uint32_t maxLatency;	/** Longest time from the update to the delivery, in us */
+} UAVObjSubscriberStats;
+
 typedef void (*new_uavo_instance_cb_t)(uint32_t,uint32_t);
 void UAVObjRegisterNewInstanceCB(new_uavo_instance_cb_t callback);
 
 int32_t UAVObjInitialize();
 void UAVObjGetStats(UAVObjStats* statsOut);
 void UAVObjClearStats();
+int32_t UAVObjGetSubscriberStats(UAVObjHandle obj_handle, uint8_t index, UAVObjSubscriberStats *statsOut);
 UAVObjHandle UAVObjRegister(uint32_t id,
 		int32_t isSingleInstance, int32_t isSettings, uint32_t numBytes, UAVObjInitializeCallback initCb);
 UAVObjHandle UAVObjGetByID(uint32_t id);
@@ -36,6 +36,11 @@ void UAVObjectsInitializeAll();
 
 #define UAVOBJECTS_LARGEST $(SIZECALCULATION)
 
+/* Number of generated objects, and their IDs in ascending order */
+#define UAVOBJECTS_COUNT $(OBJCOUNT)
+#define UAVOBJECTS_SORTED_IDS {$(OBJIDS) \
+}
+
 #endif /* UAVOBJECTSINIT_H */
 
 /**
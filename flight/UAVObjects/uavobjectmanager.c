@@ -40,6 +40,7 @@
 #include "pios_mutex.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "uavobjectsinit.h"
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -66,6 +67,9 @@ struct ObjectEventEntry {
 	UAVObjEventCallback       cb;
 	uint8_t                   hasThrottle : 1;
 	uint8_t                   eventMask : 7;
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+	UAVObjSubscriberStats     diag;
+#endif
 	struct ObjectEventEntry * next;
 };
 
@@ -177,6 +181,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event, void *obj_data, int len);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static int32_t UAVObjIndexOfID(uint32_t id);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, void *cbCtx, uint8_t eventMask,
 			uint16_t interval);
@@ -185,6 +190,14 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 
 // Private variables
 static struct UAVOData * uavo_list;
+
+/*
+ * Registered objects indexed by the position of their ID in the generated,
+ * sorted ID table.  Entries are only ever written once, with the mutex held,
+ * after the object is fully set up, so lookups can read them without locking.
+ */
+static const uint32_t uavo_sorted_ids[UAVOBJECTS_COUNT] = UAVOBJECTS_SORTED_IDS;
+static struct UAVOData * volatile uavo_by_index[UAVOBJECTS_COUNT];
 static struct ObjectEventEntry * events_unused;
 static struct ObjectEventEntry * events_unused_throttled;
 static struct pios_recursive_mutex *mutex;
@@ -205,6 +218,12 @@ static new_uavo_instance_cb_t newUavObjInstanceCB;
 
 #define UAVO_CB_STACK_SIZE 512
 
+/* Events raised from callbacks wait here until the current event has been
+ * delivered.  Updates of the same object and instance share one entry */
+#ifndef UAVO_MAX_PENDING_EVENTS
+#define UAVO_MAX_PENDING_EVENTS 8
+#endif
+
 static void *cb_stack;
 
 /**
@@ -216,6 +235,7 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	memset((void *) uavo_by_index, 0, sizeof(uavo_by_index));
 	events_unused = NULL;
 	events_unused_throttled = NULL;
 
@@ -262,6 +282,42 @@ void UAVObjClearStats()
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
+/**
+ * Get the event statistics of one subscriber of an object
+ * \param[in] obj_handle The object
+ * \param[in] index Subscriber index, in the order they were connected
+ * \param[out] statsOut The statistics
+ * \return 0 Success
+ * \return -1 No such subscriber, or not built with UAVO_EVENT_DIAGNOSTICS
+ */
+int32_t UAVObjGetSubscriberStats(UAVObjHandle obj_handle, uint8_t index,
+		UAVObjSubscriberStats *statsOut)
+{
+	PIOS_Assert(obj_handle);
+
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+	int32_t rc = -1;
+	struct ObjectEventEntry *event;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	LL_FOREACH(((struct UAVOBase *) obj_handle)->next_event, event) {
+		if (index-- == 0) {
+			*statsOut = event->diag;
+			rc = 0;
+			break;
+		}
+	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return rc;
+#else
+	(void) index;
+	(void) statsOut;
+
+	return -1;
+#endif /* UAVO_EVENT_DIAGNOSTICS */
+}
+
 /************************
  * Object Initialization
  ***********************/
@@ -349,6 +405,7 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 			UAVObjInitializeCallback initCb)
 {
 	struct UAVOData * uavo_data = NULL;
+	int32_t index;
 
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
@@ -394,11 +451,44 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
 
+	/* Publish it for lock-free lookups, now that its defaults and settings
+	 * are in place.  Objects whose ID is not in the generated table are
+	 * found by the list walk in UAVObjGetByID, which waits for the lock */
+	index = UAVObjIndexOfID(id);
+	if (index >= 0) {
+		__sync_synchronize();
+		uavo_by_index[index] = uavo_data;
+	}
+
 unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return (UAVObjHandle) uavo_data;
 }
 
+/**
+ * Find an ID in the generated table of object IDs
+ * \param[in] id The object ID
+ * \return Position of the ID in the table, or -1 if it is not a generated object
+ */
+static int32_t UAVObjIndexOfID(uint32_t id)
+{
+	int32_t low = 0;
+	int32_t high = UAVOBJECTS_COUNT - 1;
+
+	while (low <= high) {
+		int32_t mid = (low + high) / 2;
+
+		if (uavo_sorted_ids[mid] < id)
+			low = mid + 1;
+		else if (uavo_sorted_ids[mid] > id)
+			high = mid - 1;
+		else
+			return mid;
+	}
+
+	return -1;
+}
+
 /**
  * Retrieve an object from the list given its id
  * \param[in] The object ID
@@ -407,12 +497,26 @@ unlock_exit:
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
 	UAVObjHandle found_obj = NULL;
+	struct UAVOData * tmp_obj;
+
+	/* Fast path, without the lock: a data object, then the meta object
+	 * of the data object whose ID precedes this one */
+	int32_t index = UAVObjIndexOfID(id);
+	int32_t meta_index = UAVObjIndexOfID(id - 1);
+
+	if (index >= 0 && (tmp_obj = uavo_by_index[index]) != NULL)
+		return &tmp_obj->base;
+
+	if (meta_index >= 0 && (tmp_obj = uavo_by_index[meta_index]) != NULL)
+		return &(tmp_obj->metaObj.base);
+
+	if (index >= 0 || meta_index >= 0)
+		return NULL;
 
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Look for object
-	struct UAVOData * tmp_obj;
+	// Look for an object that is not in the generated table
 	LL_FOREACH(uavo_list, tmp_obj) {
 		if (tmp_obj->id == id) {
 			found_obj = &tmp_obj->base;
@@ -1714,7 +1818,8 @@ static void invokeCallback(struct ObjectEventEntry *event, UAVObjEvent *msg,
 #endif
 
 /* First argument is deliberately not a pointer to get a copy of msg */
-static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
+static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len,
+		uint32_t queued_at) {
 	// Go through each object and push the event message in the queue (if event is activated for the queue)
 	struct ObjectEventEntry *event;
 	LL_FOREACH(msg.obj->next_event, event) {
@@ -1734,6 +1839,15 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 				throtInfo->due += ((now - throtInfo->due) / throtInfo->interval + 1) * throtInfo->interval;
 			}
 
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+			uint32_t latency = PIOS_DELAY_DiffuS(queued_at);
+			if (latency > event->diag.maxLatency)
+				event->diag.maxLatency = latency;
+			event->diag.delivered++;
+#else
+			(void) queued_at;
+#endif
+
 			// Invoke callback (from event task) if a valid one is registered
 			if (event->cb) {
 				// invoke callback directly; callbacks must be well behaved
@@ -1744,6 +1858,10 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 				if (PIOS_Queue_Send(event->cbInfo.queue, &msg, 0) != true) {
 					stats.lastQueueErrorID = UAVObjGetID(msg.obj);
 					++stats.eventQueueErrors;
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+					event->diag.delivered--;
+					event->diag.dropped++;
+#endif
 				}
 			}
 
@@ -1753,6 +1871,23 @@ static int32_t pumpOneEvent(UAVObjEvent msg, void *obj_data, int len) {
 	return 0;
 }
 
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+/**
+ * Count an event that never made it to the pending list against
+ * every subscriber that would have received it.
+ */
+static void dropEvent(struct UAVOBase *obj, UAVObjEventType triggered_event)
+{
+	struct ObjectEventEntry *event;
+	LL_FOREACH(obj->next_event, event) {
+		if (event->eventMask == 0
+			|| (event->eventMask & triggered_event) != 0) {
+			event->diag.dropped++;
+		}
+	}
+}
+#endif
+
 /**
  * Send a triggered event to all event queues registered on the object.
  */
@@ -1760,86 +1895,125 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType triggered_event,
 			void *obj_data, int len)
 {
-	static uint8_t num_pending = 0;
-
 	static struct PendEvent {
 		UAVObjEvent msg;
 		void *obj_data;
 		int len;
-	} pending_events[3];
+		uint32_t queued_at;
+	} pending_events[UAVO_MAX_PENDING_EVENTS];
+
+	static uint8_t pending_head = 0;
+	static uint8_t num_pending = 0;
+
+	/* The event being delivered, .obj is NULL while idle */
+	static UAVObjEvent in_progress;
 
 	/* The logic to spool up callbacks here may be a little confusing.
-	 * basically, this relies on the fact that we are in a re-entrant
-	 * locked section.  If we get in here and the static variable
-	 * in_progress is set, we are entering from a task that itself is
-	 * performing a parent callback.
+	 * Everything happens under the recursive object manager lock, so
+	 * only one task at a time gets here.  If we get in here while
+	 * in_progress.obj is set, we are entering from a callback of the event
+	 * being pumped.
 	 *
 	 * In other words, while executing a callback it did a uav object
 	 * update that will trigger in turn more callbacks.
 	 *
-	 * To handle this, we have a small buffer to store the pending
-	 * callbacks.
+	 * Those events are appended to a bounded FIFO and delivered once
+	 * the current event has been handed to all of its subscribers.
 	 *
-	 * We also make the point of disallowing a callback from generating
-	 * the exact same callback.  This is relevant to things like
-	 * the session managing object in telemetry.  While it is possible
-	 * to do this safely (by "stopping" the quasi-recursion) it seems
-	 * better to disallow it.
+	 * Subscribers always get a pointer to the live object data, so
+	 * several pending updates of the same object and instance are
+	 * coalesced into one: the latest value wins.  For the same reason
+	 * an event a callback raises again on the object, instance and
+	 * event type that is being delivered is folded into the delivery
+	 * in progress.  This is relevant to things like the session
+	 * managing object in telemetry, which would otherwise loop forever.
+	 * Events on other instances or of another type are queued like any
+	 * other.
 	 *
 	 * However, infinite loops are still possible; callback A can
 	 * trigger callback B which triggers callback A.  Don't do that.
 	 */
 
-	if (num_pending >= 3) {
-		/* Unable to pump event; backlog too long */
-		stats.eventCallbackErrors++;
-		stats.lastCallbackErrorID = UAVObjGetID(obj);
+	struct PendEvent *pend;
+	int32_t rc = 0;
 
-		return -1;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (in_progress.obj == obj && in_progress.instId == instId
+			&& in_progress.event == triggered_event) {
+		stats.eventsCoalesced++;
+		goto unlock_exit;
 	}
 
-	static struct UAVOBase *in_progress = NULL;
+	for (uint8_t i = 0; i < num_pending; i++) {
+		pend = &pending_events[(pending_head + i) % UAVO_MAX_PENDING_EVENTS];
 
-	if (num_pending) {
-		if (in_progress == obj) {
-			return -1;	/* We don't fire events
-					 * of the same type generated by
-					 * an event callback. */
+		if (pend->msg.obj == obj && pend->msg.instId == instId
+				&& pend->msg.event == triggered_event) {
+			pend->obj_data = obj_data;
+			pend->len = len;
+			stats.eventsCoalesced++;
+			goto unlock_exit;
 		}
 	}
 
-	pending_events[num_pending].msg = (UAVObjEvent) {
+	if (num_pending >= UAVO_MAX_PENDING_EVENTS) {
+		/* Unable to pump event; backlog too long */
+		stats.eventCallbackErrors++;
+		stats.lastCallbackErrorID = UAVObjGetID(obj);
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+		dropEvent(obj, triggered_event);
+#endif
+
+		rc = -1;
+		goto unlock_exit;
+	}
+
+	pend = &pending_events[(pending_head + num_pending) % UAVO_MAX_PENDING_EVENTS];
+
+	pend->msg = (UAVObjEvent) {
 		.obj    = obj,
 		.event  = triggered_event,
 		.instId = instId
 	};
-
-	pending_events[num_pending].obj_data = obj_data;
-	pending_events[num_pending].len = len;
+	pend->obj_data = obj_data;
+	pend->len = len;
+#if defined(UAVO_EVENT_DIAGNOSTICS)
+	pend->queued_at = PIOS_DELAY_GetRaw();
+#else
+	pend->queued_at = 0;
+#endif
 
 	num_pending++;
+	if (num_pending > stats.maxPendingEvents)
+		stats.maxPendingEvents = num_pending;
 
 	/* Only enter the section of pumping events if we are the "first event" */
-	if (!in_progress) {
+	if (!in_progress.obj) {
 		/* While there are events to pump.. */
 		while (num_pending) {
-			/* Deallocate the top one.. */
+			/* Take the oldest one off the list, its slot may be
+			 * reused by the callbacks we are about to run */
+			struct PendEvent next = pending_events[pending_head];
+
+			pending_head = (pending_head + 1) % UAVO_MAX_PENDING_EVENTS;
 			num_pending--;
 
-			/* Mask off events of the same type resulting from
-			 * the callback... */
-			in_progress = pending_events[num_pending].msg.obj;
+			/* Fold the same event raised again into it... */
+			in_progress = next.msg;
 
 			/* And pump the event. */
-			pumpOneEvent(pending_events[num_pending].msg,
-				pending_events[num_pending].obj_data,
-				pending_events[num_pending].len);
+			pumpOneEvent(next.msg, next.obj_data, next.len,
+				next.queued_at);
 		}
+
+		in_progress.obj = NULL;
 	}
 
-	in_progress = NULL;
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
 
-	return 0;
+	return rc;
 }
 
 /**
@@ -34,6 +34,11 @@
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t* data, int32_t length);
 
+//! Reserves length contiguous bytes in the output, or NULL to use the output stream
+typedef uint8_t *(*UAVTalkTxReserve)(uint16_t length);
+//! Sends length bytes written to the last reservation, zero cancels it
+typedef int32_t (*UAVTalkTxCommit)(uint16_t length);
+
 //! Tracking statistics for a UAVTalk connection
 typedef struct {
 	uint32_t txBytes;
@@ -46,6 +51,13 @@ typedef struct {
 	uint32_t rxErrors;
 } UAVTalkStats;
 
+//! The data delta encoded packets of an object instance are relative to
+typedef struct {
+	uint8_t *data;		/** UAVObjGetNumBytes() bytes, the data sent before */
+	uint16_t keyframeStamp;	/** Timestamp of the keyframe the deltas build on */
+	uint8_t sequence;	/** Deltas sent since the keyframe */
+} UAVTalkDeltaRef;
+
 typedef void* UAVTalkConnection;
 
 typedef enum {UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID,
@@ -55,8 +67,11 @@ typedef enum {UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, U
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetTxReservation(UAVTalkConnection connectionHandle, UAVTalkTxReserve reserve, UAVTalkTxCommit commit);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
+int32_t UAVTalkSendObjectDeltaTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId,
+		UAVTalkDeltaRef *ref, bool keyframe);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
 int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId);
@@ -84,6 +84,8 @@ typedef struct {
 typedef struct {
 	uint8_t canari;
 	UAVTalkOutputStream outStream;
+	UAVTalkTxReserve txReserve;
+	UAVTalkTxCommit txCommit;
 	struct pios_recursive_mutex *lock;
 	struct pios_recursive_mutex *transLock;
 	struct pios_semaphore *respSema;
@@ -94,6 +96,7 @@ typedef struct {
 	uint8_t *rxBuffer;
 	uint32_t txSize;
 	uint8_t *txBuffer;
+	uint8_t *deltaBuffer;
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI         0xCA
@@ -108,8 +111,10 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_DELTA (UAVTALK_TYPE_VER | 0x05)
 #define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
+#define UAVTALK_TYPE_OBJ_DELTA_TS (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_DELTA)
 
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
@@ -36,11 +36,14 @@
 #include "uavtalk_priv.h"
 #include "pios_mutex.h"
 #include "pios_thread.h"
+#include "uavtalk_delta.h"
 
 // Private functions
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static void packHeader(uint8_t *buf, UAVObjHandle obj, uint16_t instId, uint8_t type, int32_t dataOffset, int32_t length);
+static int32_t encodeDelta(uint8_t *out, int32_t maxLength, const uint8_t *data, const uint8_t *reference, int32_t length);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
@@ -61,6 +64,9 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	connection->iproc.rxPacketLength = 0;
 	connection->iproc.state = UAVTALK_STATE_SYNC;
 	connection->outStream = outputStream;
+	connection->txReserve = NULL;
+	connection->txCommit = NULL;
+	connection->deltaBuffer = NULL;
 	connection->lock = PIOS_Recursive_Mutex_Create();
 	PIOS_Assert(connection->lock != NULL);
 	connection->transLock = PIOS_Recursive_Mutex_Create();
@@ -102,6 +108,36 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
 
 }
 
+/**
+ * Let the connection build packets directly in the output buffer. When
+ * reserve returns space, objects are packed in place and handed to commit,
+ * otherwise they are built in the connection buffer and written to the
+ * output stream as before.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserve Function that reserves contiguous space in the output
+ * \param[in] commit Function that sends the data written to the reservation
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetTxReservation(UAVTalkConnection connectionHandle, UAVTalkTxReserve reserve, UAVTalkTxCommit commit)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if ((reserve == NULL) != (commit == NULL)) {
+		return -1;
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	connection->txReserve = reserve;
+	connection->txCommit = commit;
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -226,6 +262,198 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	}
 }
 
+/**
+ * Send an object with a timestamp, as the difference from the copy of its
+ * data that was sent before. Meant for logs, where most of an object does
+ * not change from one update to the next. See uavtalk_delta.h for the
+ * layout of delta packets.
+ *
+ * The complete object (a keyframe) is sent instead when asked to, when the
+ * sequence number would wrap or when the delta would not be smaller. The
+ * deltas name the timestamp of their keyframe, so that a reader that lost
+ * a keyframe does not apply them to the one before. A keyframe with the
+ * same timestamp as the one before can't be told apart from it, so it is
+ * followed by another keyframe.
+ *
+ * Like other objects, the packet is built in place in the output when the
+ * connection has a transmit reservation, see UAVTalkSetTxReservation().
+ *
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \param[in,out] ref The data sent before and the keyframe it builds on
+ * \param[in] keyframe Send the complete object
+ * \return 0 Success, a delta was sent
+ * \return 1 Success, a keyframe was sent
+ * \return -1 Failure, ref is unchanged
+ */
+int32_t UAVTalkSendObjectDeltaTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId,
+		UAVTalkDeltaRef *ref, bool keyframe)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (!connection->outStream) return -1;
+
+	int32_t length = UAVObjGetNumBytes(obj);
+	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH) {
+		return -1;
+	}
+
+	int32_t dataOffset = (UAVObjIsSingleInstance(obj) ? 8 : 10) + 2;
+	int32_t rc = -1;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (!connection->deltaBuffer) {
+		connection->deltaBuffer = PIOS_malloc(UAVTALK_MAX_PAYLOAD_LENGTH);
+		if (!connection->deltaBuffer) {
+			goto out;
+		}
+	}
+
+	// The data is packed aside to compare it with the reference, the
+	// packet is built in place in the output when possible
+	uint8_t *data = connection->deltaBuffer;
+
+	if (UAVObjPack(obj, instId, data) < 0) {
+		goto out;
+	}
+
+	// A delta is never longer than the keyframe, reserve room for that
+	uint8_t *buf = NULL;
+	if (connection->txReserve) {
+		buf = connection->txReserve(dataOffset + length + UAVTALK_CHECKSUM_LENGTH);
+	}
+	bool reserved = buf != NULL;
+	if (!reserved) {
+		buf = connection->txBuffer;
+	}
+
+	// The delta, its header included, must be shorter than the object
+	int32_t payloadLength = -1;
+	if (!keyframe && ref->sequence < UINT8_MAX && length > UAVTALK_DELTA_HEADER_LENGTH + 1) {
+		buf[dataOffset] = (uint8_t)(ref->keyframeStamp & 0xFF);
+		buf[dataOffset + 1] = (uint8_t)((ref->keyframeStamp >> 8) & 0xFF);
+		buf[dataOffset + 2] = ref->sequence + 1;
+		payloadLength = encodeDelta(&buf[dataOffset + UAVTALK_DELTA_HEADER_LENGTH],
+				length - UAVTALK_DELTA_HEADER_LENGTH - 1, data, ref->data, length);
+		if (payloadLength >= 0) {
+			payloadLength += UAVTALK_DELTA_HEADER_LENGTH;
+		}
+	}
+
+	uint8_t type = UAVTALK_TYPE_OBJ_DELTA_TS;
+	if (payloadLength < 0) {
+		type = UAVTALK_TYPE_OBJ_TS;
+		memcpy(&buf[dataOffset], data, length);
+		payloadLength = length;
+	}
+
+	packHeader(buf, obj, instId, type, dataOffset, payloadLength);
+	buf[dataOffset + payloadLength] = PIOS_CRC_updateCRC(0, buf, dataOffset + payloadLength);
+
+	uint16_t stamp = buf[dataOffset - 2] | (buf[dataOffset - 1] << 8);
+
+	int32_t tx_msg_len = dataOffset + payloadLength + UAVTALK_CHECKSUM_LENGTH;
+	int32_t sent;
+	if (reserved) {
+		sent = connection->txCommit(tx_msg_len);
+	} else {
+		sent = (*connection->outStream)(buf, tx_msg_len);
+	}
+
+	if (sent == tx_msg_len) {
+		++connection->stats.txObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += payloadLength;
+
+		memcpy(ref->data, data, length);
+		if (type == UAVTALK_TYPE_OBJ_TS) {
+			ref->sequence = (stamp == ref->keyframeStamp) ? UINT8_MAX : 0;
+			ref->keyframeStamp = stamp;
+			rc = 1;
+		} else {
+			ref->sequence++;
+			rc = 0;
+		}
+	}
+
+out:
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return rc;
+}
+
+/**
+ * Write a varint, 7 bits per byte starting with the least significant,
+ * with the top bit set on all bytes but the last.
+ * \return Number of bytes written
+ */
+static int32_t putVarint(uint8_t *out, uint32_t value)
+{
+	int32_t n = 0;
+
+	while (value >= 0x80) {
+		out[n++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	out[n++] = value;
+
+	return n;
+}
+
+/**
+ * Encode the runs of a delta packet, see UAVTalkSendObjectDeltaTimestamped()
+ * \param[out] out Encoded runs
+ * \param[in] maxLength Space in out
+ * \param[in] data New object data
+ * \param[in] reference Object data sent before
+ * \param[in] length Object length
+ * \return Number of bytes encoded
+ * \return -1 if the runs do not fit in maxLength
+ */
+static int32_t encodeDelta(uint8_t *out, int32_t maxLength, const uint8_t *data, const uint8_t *reference, int32_t length)
+{
+	int32_t outLength = 0;
+	int32_t pos = 0;
+
+	while (true) {
+		int32_t start = pos;
+		while (start < length && data[start] == reference[start]) {
+			start++;
+		}
+
+		if (start == length) {
+			break;
+		}
+
+		// Gaps of up to two unchanged bytes cost no more to send
+		// inside the run than to skip with a new run
+		int32_t end = start + 1;
+		for (int32_t i = end; i < length && i - end < 3; i++) {
+			if (data[i] != reference[i]) {
+				end = i + 1;
+			}
+		}
+
+		// Objects are shorter than 16k, so each varint is at most 2 bytes
+		if (outLength + 4 + (end - start) > maxLength) {
+			return -1;
+		}
+
+		outLength += putVarint(&out[outLength], start - pos);
+		outLength += putVarint(&out[outLength], end - start);
+		for (int32_t i = start; i < end; i++) {
+			out[outLength++] = data[i] ^ reference[i];
+		}
+
+		pos = end;
+	}
+
+	return outLength;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -966,34 +1194,14 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 {
 	int32_t length;
 	int32_t dataOffset;
-	uint32_t objId;
+	bool singleInstance;
 
 	if (!connection->outStream) return -1;
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-
-	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj)) {
-		dataOffset = 8;
-	} else {
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
-	}
-
-	// Add timestamp when the transaction type is appropriate
+	// Work out the packet layout first, so that space can be reserved for it
+	singleInstance = UAVObjIsSingleInstance(obj);
+	dataOffset = singleInstance ? 8 : 10;
 	if (type & UAVTALK_TIMESTAMPED) {
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
 
@@ -1009,22 +1217,40 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 		return -1;
 	}
 
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
+	// Build the packet in place in the output when possible, so the
+	// object data is only copied once
+	uint8_t *buf = NULL;
+	if (connection->txReserve) {
+		buf = connection->txReserve(tx_msg_len);
+	}
+	bool reserved = buf != NULL;
+	if (!reserved) {
+		buf = connection->txBuffer;
+	}
+
+	packHeader(buf, obj, instId, type, dataOffset, length);
+
 	// Copy data (if any)
 	if (length > 0) {
-		if (UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0) {
+		if (UAVObjPack(obj, instId, &buf[dataOffset]) < 0) {
+			if (reserved) {
+				connection->txCommit(0);
+			}
 			return -1;
 		}
 	}
 
-	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
-
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	buf[dataOffset+length] = PIOS_CRC_updateCRC(0, buf, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+	int32_t rc;
+	if (reserved) {
+		rc = connection->txCommit(tx_msg_len);
+	} else {
+		rc = (*connection->outStream)(buf, tx_msg_len);
+	}
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -1037,6 +1263,43 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	return 0;
 }
 
+/**
+ * Fill in the header of a packet
+ * \param[out] buf Packet buffer
+ * \param[in] obj Object sent
+ * \param[in] instId The instance ID, unused for single instance objects
+ * \param[in] type Transaction type, timestamped types get a timestamp
+ * \param[in] dataOffset Header length
+ * \param[in] length Payload length
+ */
+static void packHeader(uint8_t *buf, UAVObjHandle obj, uint16_t instId, uint8_t type, int32_t dataOffset, int32_t length)
+{
+	// Setup type and object id fields
+	uint32_t objId = UAVObjGetID(obj);
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = type;
+	// Store the packet length
+	buf[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	buf[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+
+	// Setup instance ID if one is required
+	if (!UAVObjIsSingleInstance(obj)) {
+		buf[8] = (uint8_t)(instId & 0xFF);
+		buf[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED) {
+		uint32_t time = PIOS_Thread_Systime();
+		buf[dataOffset - 2] = (uint8_t)(time & 0xFF);
+		buf[dataOffset - 1] = (uint8_t)((time >> 8) & 0xFF);
+	}
+}
+
 /**
  * Send a NACK through the telemetry link.
  * \param[in] connection UAVTalkConnection to be used
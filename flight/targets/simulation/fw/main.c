@@ -108,6 +108,9 @@ void initTask(void *parameters)
 
 	PIOS_SYS_Init();
 
+	/* Options the board needs, such as where the flash image lives */
+	PIOS_SYS_EarlyArgs(g_argc, g_argv);
+
 	/* board driver init */
 	PIOS_Board_Init();
 
@@ -55,7 +55,8 @@
 void Stack_Change() {
 }
 
-const struct pios_tcp_cfg pios_tcp_telem_cfg = {
+/* The port can be changed on the command line */
+static struct pios_tcp_cfg pios_tcp_telem_cfg = {
   .ip = "0.0.0.0",
   .port = 9000,
 };
@@ -91,11 +92,20 @@ void PIOS_Board_Init(void) {
 	/* Delay system */
 	PIOS_DELAY_Init();
 
-	int32_t retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config);
+	/* The image file can be changed on the command line */
+	static struct pios_flash_posix_cfg sim_flash_config;
+	sim_flash_config = flash_config;
+	sim_flash_config.path = PIOS_SYS_GetFlashPath();
+
+	int32_t retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &sim_flash_config);
 	if (retval != 0) {
 		printf("Flash file doesn't exist or is too small, creating a new one\n");
 		/* create an empty, appropriately sized flash filesystem */
-		FILE * theflash = fopen("theflash.bin", "w");
+		FILE * theflash = fopen(sim_flash_config.path, "w");
+		if (theflash == NULL) {
+			perror(sim_flash_config.path);
+			exit(1);
+		}
 		uint8_t sector[flash_config.size_of_sector];
 		memset(sector, 0xFF, sizeof(sector));
 		for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++) {
@@ -103,7 +113,7 @@ void PIOS_Board_Init(void) {
 		}
 		fclose(theflash);
 
-		retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config);
+		retval = PIOS_Flash_Posix_Init(&pios_posix_flash_id, &sim_flash_config);
 
 		if (retval != 0) {
 			fprintf(stderr, "Unable to initialize flash posix simulator: %d\n", retval);
@@ -133,6 +143,8 @@ void PIOS_Board_Init(void) {
 	HwSparkyInitialize();
 	HwSimulationInitialize();
 
+	pios_tcp_telem_cfg.port = PIOS_SYS_GetTelemetryPort();
+
 	uintptr_t pios_tcp_telem_rf_id;
 	if (PIOS_TCP_Init(&pios_tcp_telem_rf_id, &pios_tcp_telem_cfg)) {
 		PIOS_Assert(0);
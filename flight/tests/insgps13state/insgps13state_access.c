@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file       insgps13state_access.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Exposes the private parts of the 13 state filter to the unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <string.h>
+
+#include "insgps13state.c"
+
+#include "insgps13state_access.h"
+
+void ut_serial_update(float H_in[NUMV][NUMX], float Z[NUMV], float Y[NUMV],
+		float P_io[NUMX][NUMX], float X_io[NUMX], uint16_t SensorsUsed)
+{
+	SerialUpdate(H_in, R, Z, Y, P_io, X_io, SensorsUsed);
+}
+
+void ut_linearize(float H_out[NUMV][NUMX], float Y_out[NUMV])
+{
+	LinearizeH(X, Be, H_out);
+	MeasurementEq(X, Be, Y_out);
+}
+
+void ut_get_filter(float P_out[NUMX][NUMX], float X_out[NUMX], float R_out[NUMV])
+{
+	memcpy(P_out, P, sizeof(P));
+	memcpy(X_out, X, sizeof(X));
+	memcpy(R_out, R, sizeof(R));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * @file       insgps13state_access.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Exposes the private parts of the 13 state filter to the unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef INSGPS13STATE_ACCESS_H
+#define INSGPS13STATE_ACCESS_H
+
+#include <stdint.h>
+
+#define UT_NUMX 13
+#define UT_NUMV 10
+
+//! Runs the filter's SerialUpdate() with its measurement noise R
+void ut_serial_update(float H[UT_NUMV][UT_NUMX], float Z[UT_NUMV], float Y[UT_NUMV],
+		float P[UT_NUMX][UT_NUMX], float X[UT_NUMX], uint16_t SensorsUsed);
+
+//! H and the predicted measurements Y for the current state
+void ut_linearize(float H[UT_NUMV][UT_NUMX], float Y[UT_NUMV]);
+
+//! Copies of the covariance, the state and the measurement noise
+void ut_get_filter(float P[UT_NUMX][UT_NUMX], float X[UT_NUMX], float R[UT_NUMV]);
+
+#endif /* INSGPS13STATE_ACCESS_H */
+
+/**
+ * @}
+ * @}
+ */
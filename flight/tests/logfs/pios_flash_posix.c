@@ -17,6 +17,8 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	struct pios_flash_posix_stats stats;
+	uint32_t writable_size;
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -42,8 +44,10 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	memset(&flash_dev->stats, 0, sizeof(flash_dev->stats));
+	flash_dev->writable_size = cfg->size_of_flash;
 
-	flash_dev->flash_file = fopen ("theflash.bin", "r+");
+	flash_dev->flash_file = fopen (cfg->path ? cfg->path : "theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
 		return -1;
 	}
@@ -68,6 +72,22 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 	PIOS_free(flash_dev);
 }
 
+void PIOS_Flash_Posix_GetStats(uintptr_t chip_id, struct pios_flash_posix_stats * stats)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	assert(stats);
+
+	*stats = flash_dev->stats;
+}
+
+void PIOS_Flash_Posix_SetWritableSize(uintptr_t chip_id, uint32_t writable_size)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	flash_dev->writable_size = writable_size;
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -103,6 +123,10 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert(flash_dev->transaction_in_progress);
 
+	if (chip_offset + flash_dev->cfg->size_of_sector > flash_dev->writable_size) {
+		return -1;
+	}
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -116,6 +140,8 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert (s == flash_dev->cfg->size_of_sector);
 
+	flash_dev->stats.sector_erases++;
+
 	return 0;
 }
 
@@ -128,6 +154,10 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert(flash_dev->transaction_in_progress);
 
+	if (chip_offset + len > flash_dev->writable_size) {
+		return -1;
+	}
+
 	if (fseek (flash_dev->flash_file, chip_offset, SEEK_SET) != 0) {
 		assert(0);
 	}
@@ -137,6 +167,9 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert (s == len);
 
+	flash_dev->stats.page_writes++;
+	flash_dev->stats.bytes_written += len;
+
 	return 0;
 }
 
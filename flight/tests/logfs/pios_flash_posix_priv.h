@@ -3,9 +3,23 @@
 struct pios_flash_posix_cfg {
 	uint32_t size_of_flash;
 	uint32_t size_of_sector;
+	const char *path;	/* Image file, theflash.bin when NULL */
+};
+
+/* Operations issued to the emulated chip, to estimate the time a real
+ * chip would need for the same work */
+struct pios_flash_posix_stats {
+	uint32_t sector_erases;
+	uint32_t page_writes;
+	uint32_t bytes_written;
 };
 
 int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix_cfg * cfg);
 void PIOS_Flash_Posix_Destroy(uintptr_t chip_id);
+void PIOS_Flash_Posix_GetStats(uintptr_t chip_id, struct pios_flash_posix_stats * stats);
+
+/* Erases and writes that reach past writable_size fail, as if the chip
+ * ended there */
+void PIOS_Flash_Posix_SetWritableSize(uintptr_t chip_id, uint32_t writable_size);
 
 extern const struct pios_flash_driver pios_posix_flash_driver;
@@ -0,0 +1,2 @@
+/* Only what pios_thread.h needs, the RTOS itself is stubbed out */
+#define configMINIMAL_STACK_SIZE 128
@@ -0,0 +1,5 @@
+#define PIOS_INCLUDE_FLASH
+#define PIOS_INCLUDE_FREERTOS
+#include <stdlib.h>
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv) (free(pv))
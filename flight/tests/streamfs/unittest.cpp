@@ -0,0 +1,234 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <unistd.h>		/* unlink */
+
+extern "C" {
+
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "pios_flash_priv.h"	/* struct pios_flash_partition */
+
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+
+#include "../logfs/pios_flash_posix_priv.h"
+
+extern uintptr_t pios_posix_flash_id;
+extern struct pios_flash_posix_cfg flash_config;
+
+#include "pios_streamfs_priv.h"
+#include "pios_streamfs.h"
+
+extern struct streamfs_cfg streamfs_config;
+
+int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len);
+
+}
+
+/* A little over three arenas of log */
+#define LOG_SIZE (200 * 1024)
+
+/* Typical SPI NOR flash (M25P16) timings, to turn operation counts into
+ * the throughput the logger could sustain on a real chip */
+#define PAGE_PROGRAM_US  640
+#define SECTOR_ERASE_US  600000
+
+class StreamfsTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    /* create an empty, appropriately sized flash filesystem */
+    FILE * theflash = fopen("theflash.bin", "w");
+    uint8_t sector[flash_config.size_of_sector];
+    memset(sector, 0xFF, sizeof(sector));
+    for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++) {
+      fwrite(sector, sizeof(sector), 1, theflash);
+    }
+    fclose(theflash);
+
+    /* Log data with a pattern that does not repeat on page boundaries */
+    for (uint32_t i = 0; i < sizeof(log); i++) {
+      log[i] = (i * 7 + i / 251) & 0xFF;
+    }
+
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    PIOS_FLASH_register_partition_table(pios_flash_partition_table, pios_flash_partition_table_size);
+    EXPECT_EQ(0, PIOS_STREAMFS_Init(&fs_id, &streamfs_config, FLASH_PARTITION_LABEL_LOG));
+  }
+
+  virtual void TearDown() {
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+    unlink("theflash.bin");
+  }
+
+  /* Writes the log in fragments sized like UAVTalk packets */
+  void writeLog() {
+    uint32_t offset = 0;
+    uint32_t fragment = 0;
+
+    while (offset < sizeof(log)) {
+      uint32_t len = 13 + (fragment++ * 37) % 120;
+      if (len > sizeof(log) - offset) {
+        len = sizeof(log) - offset;
+      }
+
+      ASSERT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, &log[offset], len));
+      offset += len;
+    }
+  }
+
+  uintptr_t fs_id;
+  uint8_t log[LOG_SIZE];
+};
+
+TEST_F(StreamfsTest, WriteReadBack) {
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  writeLog();
+  ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  int32_t file_id = PIOS_STREAMFS_MaxFileId(fs_id);
+  EXPECT_EQ(0, file_id);
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, file_id));
+
+  static uint8_t readback[LOG_SIZE + 128];
+  uint32_t total = 0;
+  int32_t bytes_read;
+  do {
+    bytes_read = PIOS_STREAMFS_Read(fs_id, &readback[total], 128);
+    ASSERT_GE(bytes_read, 0);
+    total += bytes_read;
+  } while (bytes_read == 128);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  ASSERT_EQ(sizeof(log), total);
+  EXPECT_EQ(0, memcmp(log, readback, sizeof(log)));
+  EXPECT_EQ(0, PIOS_STREAMFS_DroppedBytes(fs_id));
+}
+
+TEST_F(StreamfsTest, WholePagesProgrammed) {
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  writeLog();
+  ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  struct pios_flash_posix_stats stats;
+  PIOS_Flash_Posix_GetStats(pios_posix_flash_id, &stats);
+
+  uint32_t arenas = LOG_SIZE / streamfs_config.arena_size + 1;
+  uint32_t pages = LOG_SIZE / 256 + 1;
+
+  /* Every data page is programmed once. Each arena adds its footer and
+   * a short page before it. */
+  EXPECT_LE(stats.page_writes, pages + 2 * arenas);
+
+  uint64_t flash_us = (uint64_t) stats.page_writes * PAGE_PROGRAM_US +
+    (uint64_t) stats.sector_erases * SECTOR_ERASE_US;
+  printf("%u bytes: %u page programs, %u sector erases, ~%u bytes/s on NOR flash\n",
+    LOG_SIZE, stats.page_writes, stats.sector_erases,
+    (uint32_t) ((uint64_t) LOG_SIZE * 1000000 / flash_us));
+}
+
+TEST_F(StreamfsTest, FillPartition) {
+  const uint32_t data_size = streamfs_config.arena_size - 14;  /* less the footer */
+
+  /* The chip ends one byte short of the fourth footer, so the file fills
+   * up when it tries to move past the fourth arena */
+  PIOS_Flash_Posix_SetWritableSize(pios_posix_flash_id, 4 * streamfs_config.arena_size - 1);
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+
+  /* Keep logging well past the end. This must not hang, every write
+   * after the file fills up is dropped */
+  uint32_t total = 0;
+  uint32_t failed_writes = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    for (uint32_t offset = 0; offset < sizeof(log); offset += 100) {
+      uint32_t len = sizeof(log) - offset < 100 ? sizeof(log) - offset : 100;
+
+      if (PIOS_STREAMFS_Testing_Write(fs_id, &log[offset], len) != 0) {
+        failed_writes++;
+      }
+      total += len;
+    }
+  }
+
+  EXPECT_GT(failed_writes, 0u);
+
+  /* Everything past the fourth arena is dropped, and at most the fourth
+   * arena whose footer was lost on top */
+  int32_t dropped = PIOS_STREAMFS_DroppedBytes(fs_id);
+  EXPECT_GE(dropped, (int32_t) (total - 4 * data_size));
+  EXPECT_LE(dropped, (int32_t) (total - 3 * data_size));
+
+  ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  /* The three arenas with footers read back intact */
+  int32_t file_id = PIOS_STREAMFS_MaxFileId(fs_id);
+  EXPECT_EQ(0, file_id);
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenRead(fs_id, file_id));
+
+  static uint8_t readback[LOG_SIZE + 128];
+  uint32_t read_total = 0;
+  int32_t bytes_read;
+  do {
+    bytes_read = PIOS_STREAMFS_Read(fs_id, &readback[read_total], 128);
+    ASSERT_GE(bytes_read, 0);
+    read_total += bytes_read;
+  } while (bytes_read == 128);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  ASSERT_EQ(3 * data_size, read_total);
+  EXPECT_EQ(0, memcmp(log, readback, read_total));
+
+  /* A new file can be opened again afterwards */
+  PIOS_Flash_Posix_SetWritableSize(pios_posix_flash_id, flash_config.size_of_flash);
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  ASSERT_EQ(0, PIOS_STREAMFS_Testing_Write(fs_id, log, 1000));
+  ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+  EXPECT_EQ(1, PIOS_STREAMFS_MaxFileId(fs_id));
+}
+
+TEST_F(StreamfsTest, CloseWithoutData) {
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(fs_id));
+  ASSERT_EQ(0, PIOS_STREAMFS_Close(fs_id));
+
+  /* No data, no file */
+  EXPECT_EQ(-1, PIOS_STREAMFS_MaxFileId(fs_id));
+}
@@ -0,0 +1,113 @@
+/* 
+ * These need to be defined in a .c file so that we can use
+ * designated initializer syntax which c++ doesn't support (yet).
+ */
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include "pios_streamfs_priv.h"
+
+const struct streamfs_cfg streamfs_config = {
+	.fs_magic      = 0x89abceef,
+	.arena_size    = 0x00010000, /* 64kb */
+	.write_size    = 0x00000100, /* 256 bytes */
+};
+
+#include "../logfs/pios_flash_posix_priv.h"
+
+#include "pios_flash_priv.h"
+
+const struct pios_flash_posix_cfg flash_config = {
+	.size_of_flash  = 1 * 1024 * 1024,
+	.size_of_sector = FLASH_SECTOR_64KB,
+};
+
+static const struct pios_flash_sector_range posix_flash_sectors[] = {
+	{
+		.base_sector = 0,
+		.last_sector = 15,
+		.sector_size = FLASH_SECTOR_64KB,
+	},
+};
+
+uintptr_t pios_posix_flash_id;
+static const struct pios_flash_chip pios_flash_chip_posix = {
+	.driver        = &pios_posix_flash_driver,
+	.chip_id       = &pios_posix_flash_id,
+	.page_size     = 256,
+	.sector_blocks = posix_flash_sectors,
+	.num_blocks    = NELEMENTS(posix_flash_sectors),
+};
+
+const struct pios_flash_partition pios_flash_partition_table[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_LOG,
+		.chip_desc    = &pios_flash_chip_posix,
+		.first_sector = 0,
+		.last_sector  = 15,
+		.chip_offset  = 0,
+		.size         = (15 - 0 + 1) * FLASH_SECTOR_64KB,
+	},
+};
+
+uint32_t pios_flash_partition_table_size = NELEMENTS(pios_flash_partition_table);
+
+/*
+ * Single threaded stand-ins for the RTOS and COM layer. The streamfs task
+ * is never started, data goes in through PIOS_STREAMFS_Testing_Write.
+ */
+
+#include "pios_config.h"
+#include <stddef.h>
+
+#include "pios_mutex.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+static struct pios_mutex mutex;
+static struct pios_semaphore semaphore;
+
+struct pios_mutex *PIOS_Mutex_Create(void)
+{
+	return &mutex;
+}
+
+bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Mutex_Unlock(struct pios_mutex *mtx)
+{
+	return true;
+}
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	return &semaphore;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	return true;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	return NULL;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+}
+
+/* The tests use the streamfs handle in place of a COM device */
+uintptr_t PIOS_COM_GetDriverCtx(uintptr_t com_id)
+{
+	return com_id;
+}
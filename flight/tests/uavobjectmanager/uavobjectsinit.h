@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @file       uavobjectsinit.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Stand-in for the generated object table
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTSINIT_H
+#define UAVOBJECTSINIT_H
+
+void UAVObjectsInitializeAll();
+
+/*
+ * As many IDs as there are object definitions, scattered over the 32 bit
+ * range with the low bit clear like generated IDs, so that lookups cost
+ * what they do with the real table.
+ */
+#define UAVOBJECTS_COUNT 124
+#define UAVOBJECTS_SORTED_IDS { \
+	0x021E51A8, 0x02B9B06C, 0x037DA704, 0x0555D50A, 0x0B76758E, 0x0C5AF43A, \
+	0x0C88D006, 0x0ED55D5E, 0x0F082320, 0x11E194FA, 0x145F2BAA, 0x14A3785E, \
+	0x173F1676, 0x18259C20, 0x18280BA6, 0x18D63796, 0x1B3FF0E4, 0x1FF59D7A, \
+	0x211A4F40, 0x2416262E, 0x24EC3A0C, 0x25446F86, 0x27036094, 0x2B7A1762, \
+	0x2D5DE398, 0x2DA15EC6, 0x3188406C, 0x32EEE3F6, 0x33367D66, 0x3502F6F8, \
+	0x350321AE, 0x3529EE60, 0x352B9264, 0x3537EFA0, 0x35BB2122, 0x3A972DF2, \
+	0x3D665FC4, 0x3D8824C2, 0x3F30AE96, 0x40603738, 0x47B5608C, 0x4C29E17C, \
+	0x4E8851C4, 0x50B61ACA, 0x5576B3F2, 0x56FFFC94, 0x583363B2, 0x5E02B982, \
+	0x5E1D65C2, 0x5F1C8C50, 0x62D2F55E, 0x64F29606, 0x66A33C12, 0x67219BEC, \
+	0x67607E58, 0x6906BAD8, 0x69253A62, 0x69F0844E, 0x6F1F52E2, 0x77257836, \
+	0x7B8D3D8E, 0x7E613866, 0x7EC0F4E2, 0x805D0DC2, 0x82964A88, 0x86A3C508, \
+	0x870F8FDC, 0x8A4E01FA, 0x8F3C37AE, 0x8FF21AE8, 0x905B8FB6, 0x91D65140, \
+	0x93D357F0, 0x94211094, 0x955867FA, 0x965C6824, 0x978156C2, 0x9AC1CA48, \
+	0xA13516E8, 0xA27B11FE, 0xA2C6CA62, 0xA45F07BA, 0xA5151E56, 0xA5862ADC, \
+	0xAA98E6BC, 0xAAA55630, 0xABB2E892, 0xAF3E538E, 0xB13477CC, 0xB5FEF56E, \
+	0xB685F186, 0xB79BBF5C, 0xBC9523B6, 0xBE7DEF54, 0xBFBD230A, 0xC05D21F4, \
+	0xC5BE7B40, 0xC5D95238, 0xC640B6BC, 0xC69BB088, 0xC729DC84, 0xC90A3252, \
+	0xCC368876, 0xD0185200, 0xD0185250, 0xD203AC86, 0xD5845776, 0xD74BFFC6, \
+	0xD8066B8A, 0xDCC02516, 0xDD9EA94C, 0xE08825AE, 0xE0E0D658, 0xE36998F0, \
+	0xE491300E, 0xEF7463CE, 0xF32F607C, 0xF6DE340E, 0xF8E46D2C, 0xF9E2F5A8, \
+	0xFA0696C0, 0xFA94C318, 0xFB0F5438, 0xFE141800, \
+}
+
+#endif /* UAVOBJECTSINIT_H */
+
+/**
+ * @}
+ * @}
+ */
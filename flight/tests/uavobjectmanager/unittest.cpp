@@ -0,0 +1,288 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for object registration, lookup by ID and events
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+#include "openpilot.h"
+#include "uavobjectsinit.h"
+}
+
+static const uint32_t all_ids[UAVOBJECTS_COUNT] = UAVOBJECTS_SORTED_IDS;
+
+/* Not in the generated table, so it can only be found by walking the list */
+#define UNLISTED_ID 0x00000010
+
+static UAVObjHandle seen_during_init;
+
+static void lookup_self_cb(UAVObjHandle obj_handle, uint16_t /* instId */)
+{
+  seen_during_init = UAVObjGetByID(UAVObjGetID(obj_handle));
+}
+
+/* Events seen by record_cb, in delivery order */
+#define MAX_RECORDED 16
+static UAVObjEvent recorded[MAX_RECORDED];
+static int num_recorded;
+
+static void record_cb(UAVObjEvent *ev, void * /* ctx */, void * /* obj */, int /* len */)
+{
+  if (num_recorded < MAX_RECORDED)
+    recorded[num_recorded] = *ev;
+  num_recorded++;
+}
+
+/* Updates instance 1 whenever instance 0 is delivered */
+static void update_next_instance_cb(UAVObjEvent *ev, void * /* ctx */, void * /* obj */, int /* len */)
+{
+  record_cb(ev, NULL, NULL, 0);
+
+  if (ev->instId == 0)
+    UAVObjInstanceUpdated(ev->obj, 1);
+}
+
+/* Raises the event being delivered again */
+static void update_self_cb(UAVObjEvent *ev, void * /* ctx */, void * /* obj */, int /* len */)
+{
+  record_cb(ev, NULL, NULL, 0);
+
+  UAVObjInstanceUpdated(ev->obj, ev->instId);
+}
+
+/* Sets the data of the instance that was manually updated */
+static void set_data_cb(UAVObjEvent *ev, void * /* ctx */, void * /* obj */, int /* len */)
+{
+  uint8_t data[8] = { 0 };
+
+  record_cb(ev, NULL, NULL, 0);
+
+  if (ev->event == EV_UPDATED_MANUAL)
+    UAVObjSetInstanceData(ev->obj, ev->instId, data);
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjManagerTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+  }
+
+  virtual void TearDown() {
+  }
+
+  /* Register every object in the generated table, alternating the kinds */
+  void RegisterAll() {
+    for (int i = 0; i < UAVOBJECTS_COUNT; i++) {
+      handles[i] = UAVObjRegister(all_ids[i], i % 3 != 0, i % 5 == 0,
+          4 + i % 16, NULL);
+      ASSERT_TRUE(handles[i] != NULL);
+    }
+  }
+
+  UAVObjHandle handles[UAVOBJECTS_COUNT];
+};
+
+TEST_F(UAVObjManagerTest, FindsEveryObject) {
+  RegisterAll();
+
+  for (int i = 0; i < UAVOBJECTS_COUNT; i++) {
+    UAVObjHandle obj = UAVObjGetByID(all_ids[i]);
+    EXPECT_EQ(handles[i], obj);
+    EXPECT_FALSE(UAVObjIsMetaobject(obj));
+
+    UAVObjHandle meta = UAVObjGetByID(all_ids[i] + 1);
+    ASSERT_TRUE(meta != NULL);
+    EXPECT_TRUE(UAVObjIsMetaobject(meta));
+    EXPECT_EQ(all_ids[i] + 1, UAVObjGetID(meta));
+  }
+}
+
+TEST_F(UAVObjManagerTest, UnknownIdsAreNotFound) {
+  /* Nothing is found before registration... */
+  EXPECT_TRUE(UAVObjGetByID(all_ids[0]) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(all_ids[0] + 1) == NULL);
+
+  RegisterAll();
+
+  /* ...nor afterwards for IDs that were never registered */
+  EXPECT_TRUE(UAVObjGetByID(UNLISTED_ID) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(UNLISTED_ID + 1) == NULL);
+  EXPECT_TRUE(UAVObjGetByID(all_ids[0] - 2) == NULL);
+}
+
+TEST_F(UAVObjManagerTest, RejectsDuplicates) {
+  RegisterAll();
+
+  EXPECT_TRUE(UAVObjRegister(all_ids[7], true, false, 8, NULL) == NULL);
+  EXPECT_EQ(handles[7], UAVObjGetByID(all_ids[7]));
+}
+
+TEST_F(UAVObjManagerTest, FindsObjectsOutsideTheTable) {
+  for (int i = 0; i < UAVOBJECTS_COUNT; i++)
+    ASSERT_NE((uint32_t) UNLISTED_ID, all_ids[i]);
+
+  RegisterAll();
+
+  UAVObjHandle obj = UAVObjRegister(UNLISTED_ID, true, false, 12, NULL);
+  ASSERT_TRUE(obj != NULL);
+
+  EXPECT_EQ(obj, UAVObjGetByID(UNLISTED_ID));
+
+  UAVObjHandle meta = UAVObjGetByID(UNLISTED_ID + 1);
+  ASSERT_TRUE(meta != NULL);
+  EXPECT_TRUE(UAVObjIsMetaobject(meta));
+}
+
+TEST_F(UAVObjManagerTest, NotPublishedUntilInitialized) {
+  seen_during_init = (UAVObjHandle) 1;
+
+  UAVObjHandle obj = UAVObjRegister(all_ids[3], true, true, 8, lookup_self_cb);
+  ASSERT_TRUE(obj != NULL);
+
+  /* The lock-free lookup must not hand out a half-built object */
+  EXPECT_TRUE(seen_during_init == NULL);
+  EXPECT_EQ(obj, UAVObjGetByID(all_ids[3]));
+}
+
+TEST_F(UAVObjManagerTest, DeliversEventsOfOtherInstances) {
+  UAVObjHandle obj = UAVObjRegister(all_ids[5], false, false, 8, NULL);
+  ASSERT_TRUE(obj != NULL);
+  ASSERT_EQ(1, UAVObjCreateInstance(obj, NULL));
+  ASSERT_EQ(0, UAVObjConnectCallback(obj, update_next_instance_cb, NULL, EV_MASK_ALL_UPDATES));
+
+  num_recorded = 0;
+  UAVObjClearStats();
+  UAVObjInstanceUpdated(obj, 0);
+
+  /* The instance 1 event raised while instance 0 is delivered is not lost */
+  ASSERT_EQ(2, num_recorded);
+  EXPECT_EQ(obj, recorded[0].obj);
+  EXPECT_EQ(0, recorded[0].instId);
+  EXPECT_EQ(obj, recorded[1].obj);
+  EXPECT_EQ(1, recorded[1].instId);
+  EXPECT_EQ(EV_UPDATED_MANUAL, recorded[1].event);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(0u, stats.eventsCoalesced);
+  EXPECT_EQ(0u, stats.eventCallbackErrors);
+}
+
+TEST_F(UAVObjManagerTest, DeliversEventsOfOtherTypes) {
+  UAVObjHandle obj = UAVObjRegister(all_ids[5], true, false, 8, NULL);
+  ASSERT_TRUE(obj != NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(obj, set_data_cb, NULL, EV_MASK_ALL_UPDATES));
+
+  num_recorded = 0;
+  UAVObjInstanceUpdated(obj, 0);
+
+  /* Setting the data from the callback is an update of its own */
+  ASSERT_EQ(2, num_recorded);
+  EXPECT_EQ(EV_UPDATED_MANUAL, recorded[0].event);
+  EXPECT_EQ(EV_UPDATED, recorded[1].event);
+  EXPECT_EQ(0, recorded[1].instId);
+}
+
+TEST_F(UAVObjManagerTest, FoldsTheEventBeingDelivered) {
+  UAVObjHandle obj = UAVObjRegister(all_ids[5], false, false, 8, NULL);
+  ASSERT_TRUE(obj != NULL);
+  ASSERT_EQ(0, UAVObjConnectCallback(obj, update_self_cb, NULL, EV_MASK_ALL_UPDATES));
+
+  num_recorded = 0;
+  UAVObjClearStats();
+  UAVObjInstanceUpdated(obj, 0);
+
+  /* Raising the same event again from its callback does not loop */
+  EXPECT_EQ(1, num_recorded);
+
+  UAVObjStats stats;
+  UAVObjGetStats(&stats);
+  EXPECT_EQ(1u, stats.eventsCoalesced);
+}
+
+TEST_F(UAVObjManagerTest, LookupTiming) {
+  const int rounds = 2000;
+  struct timespec start, end;
+  uint32_t found = 0;
+
+  RegisterAll();
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < UAVOBJECTS_COUNT; i++) {
+      found += UAVObjGetByID(all_ids[i]) != NULL;
+      found += UAVObjGetByID(all_ids[i] + 1) != NULL;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double table_ns = elapsed_ns(&start, &end);
+
+  /* Reference: the linear walk over every object the lookup used to do */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < UAVOBJECTS_COUNT; i++) {
+      for (int pass = 0; pass < 2; pass++) {
+        uint32_t id = all_ids[i] + pass;
+
+        for (int j = 0; j < UAVOBJECTS_COUNT; j++) {
+          if (all_ids[j] == id || all_ids[j] + 1 == id) {
+            found += handles[j] != NULL;
+            break;
+          }
+        }
+      }
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double walk_ns = elapsed_ns(&start, &end);
+
+  EXPECT_EQ((uint32_t) (4 * rounds * UAVOBJECTS_COUNT), found);
+
+  const double lookups = 2.0 * rounds * UAVOBJECTS_COUNT;
+  printf("UAVObjGetByID: %.1f ns per lookup over %d objects, list walk reference %.1f ns\n",
+      table_ns / lookups, UAVOBJECTS_COUNT, walk_ns / lookups);
+}
+
+/**
+ * @}
+ * @}
+ */
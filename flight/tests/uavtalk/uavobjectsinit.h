@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * @file       uavobjectsinit.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Stand-in for the generated object table
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTSINIT_H
+#define UAVOBJECTSINIT_H
+
+void UAVObjectsInitializeAll();
+
+/* The objects the test registers, sorted like the generated table */
+#define UAVOBJECTS_COUNT 2
+#define UAVOBJECTS_SORTED_IDS { 0x1A2B3C4E, 0x5D6E7F80 }
+
+/* Largest object, sizes the UAVTalk buffers */
+#define UAVOBJECTS_LARGEST 200
+
+#endif /* UAVOBJECTSINIT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,442 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for delta encoded UAVTalk packets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <map>			/* std::map */
+#include <vector>		/* std::vector */
+
+extern "C" {
+#include "openpilot.h"
+#include "uavtalk_priv.h"
+#include "uavtalk_delta.h"
+
+extern uint32_t unittest_systime;
+}
+
+static const uint32_t all_ids[UAVOBJECTS_COUNT] = UAVOBJECTS_SORTED_IDS;
+
+#define SMALL_SIZE 40
+#define LARGE_SIZE 150
+
+/* Everything written to the log */
+static std::vector<uint8_t> sent;
+
+/* Lose the next packet, as a log destination that is full does */
+static bool lose_next;
+
+static uint8_t reservation[UAVTALK_MAX_PACKET_LENGTH];
+static uint16_t reserved_length;
+static int reservations;
+
+static int32_t output_stream(uint8_t *data, int32_t length)
+{
+  if (lose_next)
+    lose_next = false;
+  else
+    sent.insert(sent.end(), data, data + length);
+
+  return length;
+}
+
+static uint8_t *reserve_tx(uint16_t length)
+{
+  reserved_length = length;
+  reservations++;
+
+  return reservation;
+}
+
+static int32_t commit_tx(uint16_t length)
+{
+  EXPECT_LE(length, reserved_length);
+
+  return output_stream(reservation, length);
+}
+
+//! An object update read back from the log
+struct Decoded {
+  uint32_t objId;
+  uint16_t instId;
+  bool delta;
+  std::vector<uint8_t> data;
+};
+
+/**
+ * Reads a log the way the ground readers do, rebuilding delta packets with
+ * the decoder they share from the keyframe and the deltas before them.
+ */
+class LogReader {
+public:
+  LogReader() : undecodable(0) {}
+
+  std::vector<Decoded> Read(const std::vector<uint8_t> &log) {
+    std::vector<Decoded> objects;
+    size_t pos = 0;
+
+    while (pos < log.size()) {
+      const uint8_t *frame = &log[pos];
+
+      EXPECT_EQ(UAVTALK_SYNC_VAL, frame[0]);
+      uint8_t type = frame[1];
+      uint16_t size = frame[2] | (frame[3] << 8);
+      uint32_t objId = frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t) frame[7] << 24);
+
+      UAVObjHandle obj = UAVObjGetByID(objId);
+      if (obj == NULL) {
+        ADD_FAILURE() << "Unknown object " << objId;
+        break;
+      }
+
+      int32_t dataOffset = 8;
+      uint16_t instId = 0;
+      if (!UAVObjIsSingleInstance(obj)) {
+        instId = frame[8] | (frame[9] << 8);
+        dataOffset += 2;
+      }
+      uint16_t stamp = frame[dataOffset] | (frame[dataOffset + 1] << 8);
+      dataOffset += 2;
+
+      int32_t length = size - dataOffset;
+      EXPECT_EQ(PIOS_CRC_updateCRC(0, frame, size), frame[size]);
+      pos += size + UAVTALK_CHECKSUM_LENGTH;
+
+      Ref &ref = refs[std::make_pair(objId, instId)];
+      Decoded object = { objId, instId, type == UAVTALK_TYPE_OBJ_DELTA_TS,
+        std::vector<uint8_t>() };
+
+      if (type == UAVTALK_TYPE_OBJ_TS) {
+        EXPECT_EQ((int32_t) UAVObjGetNumBytes(obj), length);
+        ref.data.assign(&frame[dataOffset], &frame[dataOffset + length]);
+        ref.stamp = stamp;
+        ref.seq = 0;
+        ref.valid = true;
+      } else if (type == UAVTALK_TYPE_OBJ_DELTA_TS) {
+        EXPECT_LT(length, (int32_t) UAVObjGetNumBytes(obj));
+        if (!ref.valid || !uavtalk_delta_follows(&frame[dataOffset], ref.stamp, ref.seq) ||
+            uavtalk_delta_apply(&ref.data[0], ref.data.size(), &frame[dataOffset], length) < 0) {
+          ref.valid = false;
+          undecodable++;
+          continue;
+        }
+        ref.seq++;
+      } else {
+        ADD_FAILURE() << "Unexpected packet type " << (int) type;
+        continue;
+      }
+
+      object.data = ref.data;
+      objects.push_back(object);
+    }
+
+    return objects;
+  }
+
+  int undecodable;
+
+private:
+  struct Ref {
+    Ref() : stamp(0), seq(0), valid(false) {}
+
+    std::vector<uint8_t> data;
+    uint16_t stamp;
+    uint8_t seq;
+    bool valid;
+  };
+
+  std::map<std::pair<uint32_t, uint16_t>, Ref> refs;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVTalkDeltaTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+
+    small = UAVObjRegister(all_ids[0], true, false, SMALL_SIZE, NULL);
+    ASSERT_TRUE(small != NULL);
+    large = UAVObjRegister(all_ids[1], false, false, LARGE_SIZE, NULL);
+    ASSERT_TRUE(large != NULL);
+    ASSERT_EQ(1, UAVObjCreateInstance(large, NULL));
+
+    con = UAVTalkInitialize(output_stream);
+    ASSERT_TRUE(con != NULL);
+
+    sent.clear();
+    lose_next = false;
+    reservations = 0;
+    unittest_systime = 1000;
+    seed = 0x2545F491;
+
+    memset(&smallRef, 0, sizeof(smallRef));
+    smallRef.data = smallRefData;
+    memset(&largeRef, 0, sizeof(largeRef));
+    largeRef.data = largeRefData;
+
+    for (int i = 0; i < SMALL_SIZE; i++)
+      smallData[i] = Random();
+    for (int i = 0; i < LARGE_SIZE; i++)
+      largeData[i] = Random();
+  }
+
+  virtual void TearDown() {
+  }
+
+  uint8_t Random() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+  }
+
+  /* Log the small object as it is now, remembering what was logged */
+  int32_t SendSmall(bool keyframe = false, bool lost = false) {
+    EXPECT_EQ(0, UAVObjSetData(small, smallData));
+    lose_next = lost;
+    unittest_systime += 10;
+
+    int32_t rc = UAVTalkSendObjectDeltaTimestamped(con, small, 0, &smallRef, keyframe);
+    if (!lost)
+      logged.push_back(std::vector<uint8_t>(smallData, smallData + SMALL_SIZE));
+    return rc;
+  }
+
+  /* Check that the reader rebuilds every update of the small object that
+   * was not lost, except the ones listed */
+  void ExpectRead(std::vector<int> skipped = std::vector<int>()) {
+    LogReader reader;
+    std::vector<Decoded> objects = reader.Read(sent);
+
+    std::vector<std::vector<uint8_t> > expected;
+    for (size_t i = 0; i < logged.size(); i++) {
+      bool skip = false;
+      for (size_t j = 0; j < skipped.size(); j++)
+        skip |= skipped[j] == (int) i;
+      if (!skip)
+        expected.push_back(logged[i]);
+    }
+
+    EXPECT_EQ((int) skipped.size(), reader.undecodable);
+    ASSERT_EQ(expected.size(), objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+      EXPECT_EQ(all_ids[0], objects[i].objId);
+      EXPECT_TRUE(expected[i] == objects[i].data) << "update " << i;
+    }
+  }
+
+  UAVTalkConnection con;
+  UAVObjHandle small;
+  UAVObjHandle large;
+  uint32_t seed;
+
+  uint8_t smallData[SMALL_SIZE];
+  uint8_t largeData[LARGE_SIZE];
+  uint8_t smallRefData[SMALL_SIZE];
+  uint8_t largeRefData[LARGE_SIZE];
+  UAVTalkDeltaRef smallRef;
+  UAVTalkDeltaRef largeRef;
+
+  /* Updates of the small object that made it to the log */
+  std::vector<std::vector<uint8_t> > logged;
+};
+
+TEST_F(UAVTalkDeltaTest, KeyframeThenDeltas) {
+  EXPECT_EQ(1, SendSmall(true));
+  size_t keyframe_length = sent.size();
+
+  smallData[0] ^= 0x01;
+  smallData[2] ^= 0x80;
+  smallData[SMALL_SIZE - 1] ^= 0x10;
+  EXPECT_EQ(0, SendSmall());
+  EXPECT_LT(sent.size() - keyframe_length, keyframe_length);
+  EXPECT_EQ(UAVTALK_TYPE_OBJ_DELTA_TS, sent[keyframe_length + 1]);
+
+  /* Unchanged data is a delta without runs */
+  size_t before = sent.size();
+  EXPECT_EQ(0, SendSmall());
+  EXPECT_EQ(8 + 2 + UAVTALK_DELTA_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH,
+      sent.size() - before);
+
+  /* A delta that would not be shorter is sent as a keyframe */
+  for (int i = 0; i < SMALL_SIZE; i++)
+    smallData[i] ^= 0x5A;
+  before = sent.size();
+  EXPECT_EQ(1, SendSmall());
+  EXPECT_EQ(UAVTALK_TYPE_OBJ_TS, sent[before + 1]);
+
+  smallData[7] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  ExpectRead();
+}
+
+TEST_F(UAVTalkDeltaTest, SequenceWrap) {
+  /* Start just before the 16 bit timestamps wrap as well */
+  unittest_systime = 0xFF00;
+
+  EXPECT_EQ(1, SendSmall(true));
+  for (int i = 1; i <= UINT8_MAX; i++) {
+    smallData[i % SMALL_SIZE] ^= i;
+    EXPECT_EQ(0, SendSmall()) << "delta " << i;
+  }
+
+  /* The sequence number would wrap */
+  smallData[0] ^= 0x01;
+  EXPECT_EQ(1, SendSmall());
+  smallData[1] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  ExpectRead();
+}
+
+TEST_F(UAVTalkDeltaTest, LostDelta) {
+  EXPECT_EQ(1, SendSmall(true));
+  smallData[3] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  smallData[4] ^= 0x01;
+  EXPECT_EQ(0, SendSmall(false, true));
+
+  /* Nothing can be decoded until the next keyframe */
+  smallData[5] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  smallData[6] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  EXPECT_EQ(1, SendSmall(true));
+  smallData[7] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  std::vector<int> skipped;
+  skipped.push_back(2);
+  skipped.push_back(3);
+  ExpectRead(skipped);
+}
+
+TEST_F(UAVTalkDeltaTest, LostKeyframe) {
+  EXPECT_EQ(1, SendSmall(true));
+
+  /* A keyframe straight after another, then lost */
+  smallData[3] ^= 0x01;
+  EXPECT_EQ(1, SendSmall(true, true));
+
+  /* Its first delta follows on from the keyframe before by sequence
+   * number, but must not be applied to it */
+  smallData[4] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  smallData[5] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  EXPECT_EQ(1, SendSmall(true));
+  smallData[6] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  std::vector<int> skipped;
+  skipped.push_back(1);
+  skipped.push_back(2);
+  ExpectRead(skipped);
+}
+
+TEST_F(UAVTalkDeltaTest, KeyframesWithTheSameStamp) {
+  EXPECT_EQ(1, SendSmall(true));
+
+  /* A second keyframe in the same millisecond can't be told apart from
+   * the first, so no delta may build on it */
+  smallData[3] ^= 0x01;
+  unittest_systime -= 10;
+  EXPECT_EQ(1, SendSmall(true, true));
+
+  smallData[4] ^= 0x01;
+  EXPECT_EQ(1, SendSmall());
+  smallData[5] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+
+  ExpectRead();
+}
+
+TEST_F(UAVTalkDeltaTest, LongRunsOfAnInstance) {
+  EXPECT_EQ(0, UAVObjSetInstanceData(large, 1, largeData));
+  EXPECT_EQ(1, UAVTalkSendObjectDeltaTimestamped(con, large, 1, &largeRef, true));
+
+  /* Skips and runs of 128 bytes or more take two byte varints */
+  for (int i = 4; i < 140; i++)
+    largeData[i] ^= 0x21;
+  EXPECT_EQ(0, UAVObjSetInstanceData(large, 1, largeData));
+  unittest_systime += 10;
+  EXPECT_EQ(0, UAVTalkSendObjectDeltaTimestamped(con, large, 1, &largeRef, false));
+
+  largeData[LARGE_SIZE - 1] ^= 0x01;
+  EXPECT_EQ(0, UAVObjSetInstanceData(large, 1, largeData));
+  unittest_systime += 10;
+  EXPECT_EQ(0, UAVTalkSendObjectDeltaTimestamped(con, large, 1, &largeRef, false));
+
+  LogReader reader;
+  std::vector<Decoded> objects = reader.Read(sent);
+
+  ASSERT_EQ(3u, objects.size());
+  EXPECT_EQ(0, reader.undecodable);
+  EXPECT_FALSE(objects[0].delta);
+  EXPECT_TRUE(objects[2].delta);
+  EXPECT_EQ(all_ids[1], objects[2].objId);
+  EXPECT_EQ(1, objects[2].instId);
+  EXPECT_TRUE(std::vector<uint8_t>(largeData, largeData + LARGE_SIZE) == objects[2].data);
+}
+
+TEST_F(UAVTalkDeltaTest, PackedInPlace) {
+  /* The same updates through the output stream... */
+  EXPECT_EQ(1, SendSmall(true));
+  smallData[9] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  EXPECT_EQ(0, SendSmall());
+  std::vector<uint8_t> streamed = sent;
+
+  /* ...and packed straight into a reservation */
+  sent.clear();
+  logged.clear();
+  unittest_systime = 1000;
+  memset(&smallRef, 0, sizeof(smallRef));
+  smallRef.data = smallRefData;
+  smallData[9] ^= 0x01;
+  ASSERT_EQ(0, UAVTalkSetTxReservation(con, reserve_tx, commit_tx));
+
+  EXPECT_EQ(1, SendSmall(true));
+  smallData[9] ^= 0x01;
+  EXPECT_EQ(0, SendSmall());
+  EXPECT_EQ(0, SendSmall());
+
+  EXPECT_EQ(3, reservations);
+  EXPECT_TRUE(streamed == sent);
+  ExpectRead();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,122 @@
+/**
+ ******************************************************************************
+ * @file       unittest_init.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Single threaded mocks of the PiOS services UAVTalk and the object
+ *        manager use
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+
+#include <stdlib.h>
+
+uintptr_t pios_uavo_settings_fs_id;
+
+/* The tests are single threaded, so the lock only has to exist */
+static uint32_t mutex_dummy;
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
+{
+	return (struct pios_recursive_mutex *) &mutex_dummy;
+}
+
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
+{
+	return true;
+}
+
+bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
+{
+	return true;
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+/* Nothing waits for an ack in the tests */
+static uint32_t semaphore_dummy;
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	return (struct pios_semaphore *) &semaphore_dummy;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	return false;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	return true;
+}
+
+/* No settings partition: every load fails and objects keep their defaults */
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return -1;
+}
+
+/* The clock packet timestamps are taken from, set by the tests */
+uint32_t unittest_systime;
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return unittest_systime;
+}
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+	return 0;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+	return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
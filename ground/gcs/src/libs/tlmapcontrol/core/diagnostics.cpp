@@ -27,6 +27,7 @@
 */
 #include "diagnostics.h"
 
-diagnostics::diagnostics():networkerrors(0),emptytiles(0),timeouts(0),runningThreads(0),tilesFromMem(0),tilesFromNet(0),tilesFromDB(0)
+diagnostics::diagnostics():networkerrors(0),emptytiles(0),timeouts(0),runningThreads(0),tilesFromMem(0),tilesFromNet(0),tilesFromDB(0),
+    memHits(0),memMisses(0),memEvictions(0),pixmapHits(0),pixmapMisses(0),pixmapEvictions(0),memUsedMB(0)
 {
 }
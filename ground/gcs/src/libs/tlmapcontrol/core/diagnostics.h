@@ -38,10 +38,18 @@ struct diagnostics
     int tilesFromMem;
     int tilesFromNet;
     int tilesFromDB;
+    // Memory cache counters, for downloaded and for decoded tiles
+    int memHits;
+    int memMisses;
+    int memEvictions;
+    int pixmapHits;
+    int pixmapMisses;
+    int pixmapEvictions;
+    double memUsedMB;
     QString toString()
     {
-        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB);
-       ;
+        return QString("Network errors:%1\nEmpty Tiles:%2\nTimeOuts:%3\nRunningThreads:%4\nTilesFromMem:%5\nTilesFromNet:%6\nTilesFromDB:%7").arg(networkerrors).arg(emptytiles).arg(timeouts).arg(runningThreads).arg(tilesFromMem).arg(tilesFromNet).arg(tilesFromDB)+
+                QString("\nMemCache hit/miss/evict:%1/%2/%3\nPixmapCache hit/miss/evict:%4/%5/%6\nMemCache used:%7MB").arg(memHits).arg(memMisses).arg(memEvictions).arg(pixmapHits).arg(pixmapMisses).arg(pixmapEvictions).arg(memUsedMB,0,'f',1);
     }
 };
 
@@ -26,45 +26,83 @@
 * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 */
 #include "kibertilecache.h"
+#include "pureimage.h"
 
-//TODO add readwrite lock
+// Shards of the downloaded tile cache, each with its own lock
+#define KIBERTILECACHE_SHARDS 8
+
+// Default capacity in MB
+#define KIBERTILECACHE_CAPACITY 128
 
 namespace core {
-    KiberTileCache::KiberTileCache()
+    // Decoded tiles are only made by the GUI thread, a single shard will do
+    KiberTileCache::KiberTileCache() :
+        tiles(KIBERTILECACHE_SHARDS),
+        pixmaps(1)
     {
-        memoryCacheSize = 0;
-        _MemoryCacheCapacity = 22;
+        setMemoryCacheCapacity(KIBERTILECACHE_CAPACITY);
     }
 
+    /**
+     * Sets the memory cache capacity in MB. Decoded tiles over their new
+     * budget are only dropped when the next tile is decoded, so pixmaps are
+     * never destroyed outside the GUI thread.
+     */
     void KiberTileCache::setMemoryCacheCapacity(const int &value)
     {
-        kiberCacheLock.lockForWrite();
-        _MemoryCacheCapacity=value;
-        kiberCacheLock.unlock();
+        qint64 bytes=(qint64)value*1048576;
+        _MemoryCacheCapacity.store(value);
+        tiles.setBudget(bytes-bytes/4);
+        pixmaps.setBudget(bytes/4);
+        tiles.trim();
     }
     int KiberTileCache::MemoryCacheCapacity()
     {
-        kiberCacheLock.lockForRead();
-        return _MemoryCacheCapacity;
-        kiberCacheLock.unlock();
+        return _MemoryCacheCapacity.load();
+    }
+    double KiberTileCache::MemoryCacheSize()
+    {
+        return (tiles.stats().bytes+pixmaps.stats().bytes)/1048576.0;
     }
 
     void KiberTileCache::RemoveMemoryOverload()
     {
-        while(MemoryCacheSize()>MemoryCacheCapacity())
-        {
-            if(cachequeue.count()>0 && list.count()>0)
-            {
+        // Tiles are evicted as they are added, this only matters after
+        // the capacity was lowered
+        tiles.trim();
 #ifdef DEBUG_MEMORY_CACHE
-                qDebug()<<"Cleaning Memory cache="<<" started with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
-#endif
-                RawTile first=list.dequeue();
-                memoryCacheSize-=cachequeue.value(first).size();
-                cachequeue.remove(first);
-            }
-        }
-#ifdef DEBUG_MEMORY_CACHE
-        qDebug()<<"Cleaning Memory cache="<<" ended with "<<cachequeue.count()<<" tile "<<"ocupying "<<memoryCacheSize<<" bytes";
+        Stats stats=tiles.stats();
+        qDebug()<<"Memory cache holds "<<stats.entries<<" tiles "<<"ocupying "<<stats.bytes<<" bytes";
 #endif
     }
+
+    QByteArray KiberTileCache::GetTile(const RawTile &tile)
+    {
+        QByteArray pic;
+        tiles.get(tile,pic);
+        return pic;
+    }
+    void KiberTileCache::AddTile(const RawTile &tile, const QByteArray &pic)
+    {
+        tiles.insert(tile,pic,pic.size());
+    }
+
+    /**
+     * Returns the decoded image for tile data, decoding it only when it is
+     * not cached. Tiles handed out by the memory cache share their data, so
+     * the data address identifies the tile. GUI thread only.
+     */
+    QPixmap KiberTileCache::GetPixmap(const QByteArray &pic)
+    {
+        quintptr key=(quintptr)pic.constData();
+        DecodedTile decoded;
+        if(pixmaps.get(key,decoded))
+            return decoded.pixmap;
+
+        decoded.source=pic;
+        decoded.pixmap=PureImageProxy::FromStream(pic);
+        qint64 cost=(qint64)decoded.pixmap.width()*decoded.pixmap.height()*decoded.pixmap.depth()/8+pic.size();
+        pixmaps.insert(key,decoded,cost);
+        return decoded.pixmap;
+    }
 }
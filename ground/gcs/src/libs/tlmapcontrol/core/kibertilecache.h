@@ -30,26 +30,227 @@
 
 #include "rawtile.h"
 #include <QMutex>
-#include <QReadWriteLock>
-#include <QQueue>
+#include <QMutexLocker>
+#include <QHash>
+#include <QPixmap>
+#include <QAtomicInt>
 #include <QDebug>
 #include "debugheader.h"
 namespace core {
+    struct LruTileCacheStats
+    {
+        qint64 bytes;
+        int entries;
+        int hits;
+        int misses;
+        int evictions;
+    };
+
+    /**
+     * Least recently used cache with a byte budget. Entries are spread over
+     * shards that are locked on their own, so the tile loader threads rarely
+     * wait on each other. Each shard gets an equal part of the budget.
+     */
+    template <typename Key, typename Value>
+    class LruTileCache
+    {
+    public:
+        explicit LruTileCache(int shardCount) : shardCount(shardCount) { shards = new Shard[shardCount]; }
+        ~LruTileCache() { clear(); delete[] shards; }
+
+        void setBudget(qint64 bytes)
+        {
+            for(int i = 0; i < shardCount; i++)
+            {
+                QMutexLocker locker(&shards[i].mutex);
+                shards[i].budget = bytes / shardCount;
+            }
+        }
+
+        bool get(const Key &key, Value &value)
+        {
+            Shard &shard = shardFor(key);
+            QMutexLocker locker(&shard.mutex);
+            Entry *entry = shard.entries.value(key);
+            if(!entry)
+            {
+                shard.misses++;
+                return false;
+            }
+            shard.hits++;
+            shard.unlink(entry);
+            shard.pushFront(entry);
+            value = entry->value;
+            return true;
+        }
+
+        void insert(const Key &key, const Value &value, qint64 cost)
+        {
+            Shard &shard = shardFor(key);
+            QMutexLocker locker(&shard.mutex);
+            Entry *entry = shard.entries.value(key);
+            if(entry)
+            {
+                shard.unlink(entry);
+                shard.bytes -= entry->cost;
+                entry->value = value;
+                entry->cost = cost;
+            }
+            else
+            {
+                entry = new Entry(key, value, cost);
+                shard.entries.insert(key, entry);
+            }
+            shard.bytes += cost;
+            shard.pushFront(entry);
+            shard.trim();
+        }
+
+        //! Evicts until every shard is within its budget again
+        void trim()
+        {
+            for(int i = 0; i < shardCount; i++)
+            {
+                QMutexLocker locker(&shards[i].mutex);
+                shards[i].trim();
+            }
+        }
+
+        void clear()
+        {
+            for(int i = 0; i < shardCount; i++)
+            {
+                QMutexLocker locker(&shards[i].mutex);
+                qDeleteAll(shards[i].entries);
+                shards[i].entries.clear();
+                shards[i].head = shards[i].tail = 0;
+                shards[i].bytes = 0;
+            }
+        }
+
+        LruTileCacheStats stats()
+        {
+            LruTileCacheStats total = { 0, 0, 0, 0, 0 };
+            for(int i = 0; i < shardCount; i++)
+            {
+                QMutexLocker locker(&shards[i].mutex);
+                total.bytes += shards[i].bytes;
+                total.entries += shards[i].entries.count();
+                total.hits += shards[i].hits;
+                total.misses += shards[i].misses;
+                total.evictions += shards[i].evictions;
+            }
+            return total;
+        }
+
+    private:
+        struct Entry
+        {
+            Entry(const Key &key, const Value &value, qint64 cost) :
+                key(key), value(value), cost(cost), prev(0), next(0) {}
+            Key key;
+            Value value;
+            qint64 cost;
+            Entry *prev;
+            Entry *next;
+        };
+
+        // Entries in a doubly linked list, most recently used at the head
+        struct Shard
+        {
+            Shard() : head(0), tail(0), bytes(0), budget(0), hits(0), misses(0), evictions(0) {}
+
+            void unlink(Entry *entry)
+            {
+                if(entry->prev)
+                    entry->prev->next = entry->next;
+                else
+                    head = entry->next;
+                if(entry->next)
+                    entry->next->prev = entry->prev;
+                else
+                    tail = entry->prev;
+                entry->prev = entry->next = 0;
+            }
+
+            void pushFront(Entry *entry)
+            {
+                entry->next = head;
+                if(head)
+                    head->prev = entry;
+                head = entry;
+                if(!tail)
+                    tail = entry;
+            }
+
+            // The newest entry stays even when it alone exceeds the budget
+            void trim()
+            {
+                while(bytes > budget && tail && tail != head)
+                {
+                    Entry *oldest = tail;
+                    unlink(oldest);
+                    entries.remove(oldest->key);
+                    bytes -= oldest->cost;
+                    evictions++;
+                    delete oldest;
+                }
+            }
+
+            QMutex mutex;
+            QHash<Key, Entry*> entries;
+            Entry *head;
+            Entry *tail;
+            qint64 bytes;
+            qint64 budget;
+            int hits;
+            int misses;
+            int evictions;
+        };
+
+        Shard &shardFor(const Key &key) { return shards[qHash(key) % shardCount]; }
+
+        LruTileCache(const LruTileCache &);
+        LruTileCache &operator=(const LruTileCache &);
+
+        Shard *shards;
+        int shardCount;
+    };
+
+    /**
+     * Memory cache of the map tiles, both as downloaded and decoded for
+     * drawing. A quarter of the capacity is set aside for decoded tiles.
+     */
     class KiberTileCache
     {
     public:
+        typedef LruTileCacheStats Stats;
+
         KiberTileCache();
 
         void setMemoryCacheCapacity(const int &value);
         int MemoryCacheCapacity();
-        double MemoryCacheSize(){return memoryCacheSize/1048576.0;}
+        double MemoryCacheSize();
         void RemoveMemoryOverload();
-        QReadWriteLock kiberCacheLock;
-        QHash <RawTile,QByteArray> cachequeue;
-        QQueue <RawTile> list;
-        long memoryCacheSize;
+
+        QByteArray GetTile(const RawTile &tile);
+        void AddTile(const RawTile &tile, const QByteArray &pic);
+        QPixmap GetPixmap(const QByteArray &pic);
+
+        Stats TileStats() { return tiles.stats(); }
+        Stats PixmapStats() { return pixmaps.stats(); }
     private:
-        int _MemoryCacheCapacity;
+        // Keeps the source bytes alive, so the address used as the key
+        // can't be reused by another tile while the entry exists
+        struct DecodedTile
+        {
+            QByteArray source;
+            QPixmap pixmap;
+        };
+
+        LruTileCache<RawTile,QByteArray> tiles;
+        LruTileCache<quintptr,DecodedTile> pixmaps;
+        QAtomicInt _MemoryCacheCapacity;
 
     };
 
@@ -32,15 +32,107 @@
 namespace core {
     qlonglong PureImageCache::ConnCounter=0;
 
-    PureImageCache::PureImageCache()
+    PureImageCache::PureImageCache() :
+        generation(0)
     {
 
     }
 
+    PureImageCache::Connection::Connection(const QString &name, const QString &file, int generation) :
+        generation(generation),
+        name(name),
+        open(false),
+        selectTile(0),
+        insertTile(0),
+        insertTileData(0)
+    {
+        QSqlDatabase cn = QSqlDatabase::addDatabase("QSQLITE",name);
+        cn.setDatabaseName(file);
+        cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+        if(!cn.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Connection: Unable to open"<<file<<cn.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+
+        // Caches created before the lookup index existed get it here
+        QSqlQuery(cn).exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+
+        selectTile=new QSqlQuery(cn);
+        insertTile=new QSqlQuery(cn);
+        insertTileData=new QSqlQuery(cn);
+        open=selectTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)") &&
+                insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type, Date) VALUES(?, ?, ?, ?, ?)") &&
+                insertTileData->prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+#ifdef DEBUG_PUREIMAGECACHE
+        if(!open)
+            qDebug()<<"Connection: Unable to prepare statements"<<cn.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+    }
+
+    PureImageCache::Connection::~Connection()
+    {
+        // The queries must be gone before the connection can be removed
+        delete selectTile;
+        delete insertTile;
+        delete insertTileData;
+        database().close();
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    QByteArray PureImageCache::Connection::get(MapType::Types type, const Point &pos, int zoom)
+    {
+        QByteArray ar;
+        selectTile->bindValue(0,pos.X());
+        selectTile->bindValue(1,pos.Y());
+        selectTile->bindValue(2,zoom);
+        selectTile->bindValue(3,(int)type);
+        if(selectTile->exec() && selectTile->next())
+            ar=selectTile->value(0).toByteArray();
+        selectTile->finish();
+        return ar;
+    }
+
+    bool PureImageCache::Connection::put(const QByteArray &tile, MapType::Types type, const Point &pos, int zoom, const QString &date)
+    {
+        insertTile->bindValue(0,pos.X());
+        insertTile->bindValue(1,pos.Y());
+        insertTile->bindValue(2,zoom);
+        insertTile->bindValue(3,(int)type);
+        insertTile->bindValue(4,date);
+        if(!insertTile->exec())
+            return false;
+        insertTileData->bindValue(0,insertTile->lastInsertId());
+        insertTileData->bindValue(1,tile);
+        return insertTileData->exec();
+    }
+
+    /**
+     * Returns the calling thread's connection to the cache, opening it on
+     * first use or when the cache moved. Must be called with the lock held.
+     */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        Connection *cn=connections.hasLocalData() ? connections.localData() : 0;
+        if(cn && cn->generation==generation && cn->isOpen())
+            return cn;
+
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        // Replacing the local data deletes the stale connection
+        cn=new Connection(QString::number(id),gtilecache+"Data.qmdb",generation);
+        connections.setLocalData(cn);
+        return cn->isOpen() ? cn : 0;
+    }
+
     void PureImageCache::setGtileCache(const QString &value)
     {
         lock.lockForWrite();
         gtilecache=value;
+        generation++;
         QDir d;
         if(!d.exists(gtilecache))
         {
@@ -163,6 +255,15 @@ namespace core {
             {
 #ifdef DEBUG_PUREIMAGECACHE
                 qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
+#endif //DEBUG_PUREIMAGECACHE
+                db.close();
+                return false;
+            }
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+            if(query.numRowsAffected()==-1)
+            {
+#ifdef DEBUG_PUREIMAGECACHE
+                qDebug()<<"CreateEmptyDB: "<<query.lastError().driverText();
 #endif //DEBUG_PUREIMAGECACHE
                 db.close();
                 return false;
@@ -174,86 +275,62 @@ namespace core {
     }
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
     {
+        CacheItemQueue item(type,pos,tile,zoom);
+        return PutImagesToCache(QList<CacheItemQueue*>()<<&item);
+    }
+    /**
+     * Stores a batch of tiles in a single transaction, which is far cheaper
+     * than committing every tile on its own.
+     */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
+    {
+        lock.lockForRead();
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return false;
-        lock.lockForRead();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        bool ret=false;
+        Connection *cn=connection();
+        if(cn)
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
+            QSqlDatabase db=cn->database();
+            QString date=QDateTime::currentDateTime().toString();
+            db.transaction();
+            ret=true;
+            foreach(CacheItemQueue *task,tiles)
             {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
+                // A failed tile doesn't keep the rest of the batch out
+                if(!cn->put(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom(),date))
+                    ret=false;
+            }
+            if(!db.commit())
+            {
+                db.rollback();
+                ret=false;
             }
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
         lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
+        {
+            lock.unlock();
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        }
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()<<","<<pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
-        {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
-        }
-        QSqlDatabase::removeDatabase(QString::number(id));
+        Connection *cn=connection();
+        if(cn)
+            ar=cn->get(type,pos,zoom);
         lock.unlock();
         return ar;
     }
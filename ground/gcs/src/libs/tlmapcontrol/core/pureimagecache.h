@@ -43,6 +43,8 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
     class PureImageCache
     {
@@ -51,13 +53,43 @@ namespace core {
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        /**
+         * A database connection and its prepared statements. QSqlDatabase
+         * connections may only be used by the thread that opened them, so
+         * every thread touching the cache keeps its own, open for as long
+         * as the thread lives.
+         */
+        class Connection
+        {
+        public:
+            Connection(const QString &name, const QString &file, int generation);
+            ~Connection();
+            bool isOpen() const { return open; }
+            QSqlDatabase database() const { return QSqlDatabase::database(name, false); }
+            QByteArray get(MapType::Types type, const core::Point &pos, int zoom);
+            bool put(const QByteArray &tile, MapType::Types type, const core::Point &pos, int zoom, const QString &date);
+
+            const int generation;
+        private:
+            QString name;
+            bool open;
+            QSqlQuery *selectTile;
+            QSqlQuery *insertTile;
+            QSqlQuery *insertTileData;
+        };
+
+        Connection *connection();
+
         QString gtilecache;
+        int generation;
+        QThreadStorage<Connection*> connections;
         QMutex Mcounter;
         QReadWriteLock lock;
         static qlonglong ConnCounter;
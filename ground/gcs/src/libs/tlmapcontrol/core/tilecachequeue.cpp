@@ -29,6 +29,9 @@
 
 
 //#define DEBUG_TILECACHEQUEUE
+
+// Most tiles written to the cache in one transaction
+#define TILECACHEQUEUE_BATCH 64
  
 namespace core {
 TileCacheQueue::TileCacheQueue()
@@ -80,21 +83,22 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
+        QList<CacheItemQueue*> batch;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"Cache";
 #endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
+        mutex.lock();
+        while(tileCacheQueue.count()>0 && batch.count()<TILECACHEQUEUE_BATCH)
+            batch.append(tileCacheQueue.dequeue());
+        mutex.unlock();
+        if(batch.count()>0)
         {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
-            mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+            qDebug()<<"Cache engine Put:"<<batch.count()<<"tiles";
 #endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
+            // The whole batch is committed in one transaction
+            Cache::Instance()->ImageCache.PutImagesToCache(batch);
+            qDeleteAll(batch);
         }
 
         else
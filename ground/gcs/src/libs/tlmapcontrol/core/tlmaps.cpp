@@ -545,6 +545,16 @@ namespace core {
         errorvars.lock();
         i=diag;
         errorvars.unlock();
+
+        KiberTileCache::Stats tiles=TilesInMemory.TileStats();
+        KiberTileCache::Stats pixmaps=TilesInMemory.PixmapStats();
+        i.memHits=tiles.hits;
+        i.memMisses=tiles.misses;
+        i.memEvictions=tiles.evictions;
+        i.pixmapHits=pixmaps.hits;
+        i.pixmapMisses=pixmaps.misses;
+        i.pixmapEvictions=pixmaps.evictions;
+        i.memUsedMB=(tiles.bytes+pixmaps.bytes)/1048576.0;
         return i;
     }
 }
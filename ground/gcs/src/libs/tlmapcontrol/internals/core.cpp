@@ -34,6 +34,9 @@ qlonglong internals::Core::debugcounter=0;
 
 using namespace projections;
 
+// Tiles around the centre whose next zoom level is prefetched
+#define CORE_PREFETCH_RADIUS 1
+
 namespace internals {
     Core::Core():started(false),MouseWheelZooming(false),currentPosition(0,0),currentPositionPixel(0,0),LastLocationInBounds(-1,-1),sizeOfMapArea(0,0)
             ,minOfTiles(0,0),maxOfTiles(0,0),zoom(0),isDragging(false),TooltipTextPadding(10,10),mapType(MapType::None),loaderLimit(5),maxzoom(21),runningThreads(0)
@@ -69,27 +72,22 @@ namespace internals {
 
         LoadTask task;
 
-        MtileLoadQueue.lock();
+        // The task is only picked once a loader is free, so that it is the
+        // most urgent one at that time
+        if(!loaderLimit.tryAcquire(1,TLMaps::Instance()->Timeout))
         {
-            if(tileLoadQueue.count() > 0)
-            {
-                task = tileLoadQueue.dequeue();
-                {
-
-                    last = (tileLoadQueue.count() == 0);
-#ifdef DEBUG_CORE
-                    qDebug()<<"TileLoadQueue: " << tileLoadQueue.count()<<" Point:"<<task.Pos.ToString()<<" ID="<<debug;;
-#endif //DEBUG_CORE
-                }
-            }
+            // Try again later, the task stays pending
+            ProcessLoadTaskCallback.start(this);
         }
-        MtileLoadQueue.unlock();
-
-        if(task.HasValue())
-            if(loaderLimit.tryAcquire(1,TLMaps::Instance()->Timeout))
-            {
+        else if(!tileScheduler.Next(task))
+        {
+            // The task was cancelled or taken by another loader
+            loaderLimit.release();
+        }
+        else
+        {
             MtileToload.lock();
-            --tilesToload;
+            tilesToload=tileScheduler.VisiblePending();
             MtileToload.unlock();
 #ifdef DEBUG_CORE
             qDebug()<<"loadLimit semaphore aquired "<<loaderLimit.available()<<" ID="<<debug<<" TASK="<<task.Pos.ToString()<<" "<<task.Zoom;
@@ -100,6 +98,11 @@ namespace internals {
 #ifdef DEBUG_CORE
                 qDebug()<<"task as value, begining get"<<" ID="<<debug;;
 #endif //DEBUG_CORE
+                if(task.Prefetch)
+                {
+                    PrefetchTile(task);
+                }
+                else
                 {
                     Tile* m = Matrix.TileAt(task.Pos);
 
@@ -114,6 +117,9 @@ namespace internals {
 
                         foreach(MapType::Types tl,layers)
                         {
+                            if(tileScheduler.IsObsolete(task))
+                                break;
+
                             int retry = 0;
 
                             do
@@ -164,7 +170,8 @@ namespace internals {
                             while(++retry < TLMaps::Instance()->RetryLoadTile);
                         }
 
-                        if(t->Overlays.count() > 0)
+                        // Tiles of an area or zoom level we left stay out of the matrix
+                        if(t->Overlays.count() > 0 && !tileScheduler.IsObsolete(task))
                         {
                             Matrix.SetTileAt(task.Pos,t);
                             emit OnNeedInvalidation();
@@ -188,13 +195,12 @@ namespace internals {
                 }
 
 
+                last=tileScheduler.Finished(task);
                 {
                     // last buddy cleans stuff ;}
                     if(last)
                     {
-                        TLMaps::Instance()->kiberCacheLock.lockForWrite();
                         TLMaps::Instance()->TilesInMemory.RemoveMemoryOverload();
-                        TLMaps::Instance()->kiberCacheLock.unlock();
 
                         MtileDrawingList.lock();
                         {
@@ -244,9 +250,7 @@ namespace internals {
             currentPositionPixel=Projection()->FromLatLngToPixel(currentPosition, value);
             if(started)
             {
-                MtileLoadQueue.lock();
-                tileLoadQueue.clear();
-                MtileLoadQueue.unlock();
+                tileScheduler.Clear();
                 MtileToload.lock();
                 tilesToload=0;
                 MtileToload.unlock();
@@ -531,11 +535,7 @@ namespace internals {
             qDebug()<<"------------------";
 #endif //DEBUG_CORE
 
-            MtileLoadQueue.lock();
-            {
-                tileLoadQueue.clear();
-            }
-            MtileLoadQueue.unlock();
+            tileScheduler.Clear();
             MtileToload.lock();
             tilesToload=0;
             MtileToload.unlock();
@@ -638,17 +638,12 @@ namespace internals {
     {
         if(started)
         {
+            // Cancel first, so the loaders still queued return right away
+            tileScheduler.Clear();
             ProcessLoadTaskCallback.waitForDone();
-            MtileLoadQueue.lock();
-            {
-                tileLoadQueue.clear();
-                //tilesToload=0;
-            }
-            MtileLoadQueue.unlock();
             MtileToload.lock();
             tilesToload=0;
             MtileToload.unlock();
-            //  ProcessLoadTaskCallback.waitForDone();
         }
     }
     void Core::UpdateBounds()
@@ -663,29 +658,21 @@ namespace internals {
 
             emit OnTileLoadStart();
 
+            QList<Point> prefetchList;
+            FindTilesToPrefetch(prefetchList);
+
+            // Tiles no longer in view are dropped, the rest reordered around the new centre
+            int added=tileScheduler.Schedule(tileDrawingList,prefetchList,Zoom(),centerTileXYLocation);
+
+            MtileToload.lock();
+            tilesToload=tileScheduler.VisiblePending();
+            MtileToload.unlock();
 
-            foreach(Point p,tileDrawingList)
-            {
-                LoadTask task = LoadTask(p, Zoom());
-                {
-                    MtileLoadQueue.lock();
-                    {
-                        if(!tileLoadQueue.contains(task))
-                        {
-                            MtileToload.lock();
-                            ++tilesToload;
-                            MtileToload.unlock();
-                            tileLoadQueue.enqueue(task);
 #ifdef DEBUG_CORE
-                            qDebug()<<"Core::UpdateBounds new Task"<<task.Pos.ToString();
+            qDebug()<<"Core::UpdateBounds"<<added<<"new tasks";
 #endif //DEBUG_CORE
-                            ProcessLoadTaskCallback.start(this);
-                        }
-                    }
-                    MtileLoadQueue.unlock();
-                }
-
-            }
+            for(int i=0;i<added;i++)
+                ProcessLoadTaskCallback.start(this);
         }
         MtileDrawingList.unlock();
         UpdateGroundResolution();
@@ -722,6 +709,60 @@ namespace internals {
         }
 
 
+    }
+    /**
+     * @brief Core::FindTilesToPrefetch Lists the tiles of the next zoom level
+     * under the centre of the view, which are loaded in the background
+     * @param list Tiles at Zoom() + 1
+     */
+    void Core::FindTilesToPrefetch(QList<Point> &list)
+    {
+        list.clear();
+
+        // Nothing would keep the prefetched tiles around
+        if(!TLMaps::Instance()->UseMemoryCache() && TLMaps::Instance()->GetAccessMode()==AccessMode::ServerOnly)
+            return;
+        if(Zoom() >= maxzoom)
+            return;
+
+        for(int i = -CORE_PREFETCH_RADIUS; i <= CORE_PREFETCH_RADIUS; i++)
+        {
+            for(int j = -CORE_PREFETCH_RADIUS; j <= CORE_PREFETCH_RADIUS; j++)
+            {
+                Point p = centerTileXYLocation;
+                p.SetX(p.X() + i);
+                p.SetY(p.Y() + j);
+
+                if(p.X() >= minOfTiles.Width() && p.Y() >= minOfTiles.Height() && p.X() <= maxOfTiles.Width() && p.Y() <= maxOfTiles.Height())
+                {
+                    // Each tile covers four at the next zoom level
+                    list.append(Point(p.X()*2, p.Y()*2));
+                    list.append(Point(p.X()*2+1, p.Y()*2));
+                    list.append(Point(p.X()*2, p.Y()*2+1));
+                    list.append(Point(p.X()*2+1, p.Y()*2+1));
+                }
+            }
+        }
+    }
+    /**
+     * @brief Core::PrefetchTile Loads a tile of the next zoom level into the
+     * caches, without showing it
+     */
+    void Core::PrefetchTile(const LoadTask &task)
+    {
+        QVector<MapType::Types> layers= TLMaps::Instance()->GetAllLayersOfType(GetMapType());
+
+        foreach(MapType::Types tl,layers)
+        {
+            if(tileScheduler.IsObsolete(task))
+                break;
+
+            // These depend on state of the current zoom level
+            if(tl == MapType::PergoTurkeyMap || tl == MapType::UserImage)
+                continue;
+
+            TLMaps::Instance()->GetImageFromServer(tl, task.Pos, task.Zoom);
+        }
     }
     void Core::UpdateGroundResolution()
     {
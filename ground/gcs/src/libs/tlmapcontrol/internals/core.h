@@ -41,6 +41,7 @@
 #include "tilematrix.h"
 #include <QQueue>
 #include "loadtask.h"
+#include "tileloadscheduler.h"
 #include "copyrightstrings.h"
 #include "rectlatlng.h"
 #include "projections/lks94projection.h"
@@ -189,6 +190,8 @@ namespace internals {
         void CancelAsyncTasks();
 
         void FindTilesAround(QList<core::Point> &list);
+        void FindTilesToPrefetch(QList<core::Point> &list);
+        void PrefetchTile(const LoadTask &task);
 
         void UpdateGroundResolution();
 
@@ -243,7 +246,7 @@ namespace internals {
 
         Rectangle CurrentRegion;
 
-        QQueue<LoadTask> tileLoadQueue;
+        TileLoadScheduler tileScheduler;
 
         int zoom;
 
@@ -251,8 +254,6 @@ namespace internals {
 
         bool isDragging;
 
-        QMutex MtileLoadQueue;
-
         QMutex Moverlays;
 
         QMutex MtileDrawingList;
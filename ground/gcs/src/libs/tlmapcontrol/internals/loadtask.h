@@ -40,17 +40,23 @@ struct LoadTask
   public:
     core::Point Pos; //Tile position in quadtile format
     int Zoom;        //Number of zoom levels, in quadtile format
+    int Generation;  //Scheduler generation the task belongs to
+    bool Prefetch;   //Only warms the caches, the tile isn't shown
 
 
-    LoadTask(Point pos, int zoom)
+    LoadTask(Point pos, int zoom, int generation = 0, bool prefetch = false)
      {
         Pos = pos;
         Zoom = zoom;
+        Generation = generation;
+        Prefetch = prefetch;
     }
     LoadTask()
     {
         Pos=core::Point(-1,-1);
         Zoom=-1;
+        Generation=0;
+        Prefetch=false;
     }
     bool HasValue()
     {
@@ -0,0 +1,192 @@
+/**
+******************************************************************************
+*
+* @file       tileloadscheduler.cpp
+* @author     dRonin, http://dRonin.org Copyright (C) 2016
+* @brief      Orders, deduplicates and cancels the tile loads of the map core
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tileloadscheduler.h"
+#include <QtAlgorithms>
+
+namespace internals {
+// Sort key of a task: visible tiles first, then by squared distance from the centre
+struct TaskOrder
+{
+    TaskOrder(const core::Point &center) : center(center) {}
+
+    qint64 Key(const LoadTask &task) const
+    {
+        // Prefetched tiles are one zoom level down, scale the centre to match
+        qint64 scale = task.Prefetch ? 2 : 1;
+        qint64 dx = task.Pos.X() - center.X() * scale;
+        qint64 dy = task.Pos.Y() - center.Y() * scale;
+        return dx * dx + dy * dy;
+    }
+
+    bool operator()(const LoadTask &lhs, const LoadTask &rhs) const
+    {
+        if(lhs.Prefetch != rhs.Prefetch)
+            return !lhs.Prefetch;
+        return Key(lhs) < Key(rhs);
+    }
+
+    core::Point center;
+};
+
+TileLoadScheduler::TileLoadScheduler():zoom(-1),generation(0),visiblePending(0)
+{
+}
+
+/**
+ * @brief TileLoadScheduler::Schedule Replaces the pending loads
+ * @param visible Tiles in view, at zoom
+ * @param prefetch Tiles to warm the caches with, at zoom + 1
+ * @param zoom Current zoom level
+ * @param center Tile in the centre of the view
+ * @return Number of pending loads added, that need a loader started
+ */
+int TileLoadScheduler::Schedule(const QList<core::Point> &visible, const QList<core::Point> &prefetch, int zoom, const core::Point &center)
+{
+    QMutexLocker locker(&mutex);
+
+    // Loads still running for another zoom level are of no use anymore
+    if(zoom != this->zoom)
+    {
+        this->zoom = zoom;
+        generation++;
+    }
+
+    int before = pending.count();
+
+    visibleWanted = visible.toSet();
+    prefetchWanted = prefetch.toSet();
+
+    pending.clear();
+    foreach(core::Point p, visibleWanted)
+    {
+        if(!IsInFlight(p, zoom))
+            pending.append(LoadTask(p, zoom, generation, false));
+    }
+    visiblePending = pending.count();
+    foreach(core::Point p, prefetchWanted)
+    {
+        if(!IsInFlight(p, zoom + 1))
+            pending.append(LoadTask(p, zoom + 1, generation, true));
+    }
+
+    qSort(pending.begin(), pending.end(), TaskOrder(center));
+
+    return qMax(0, pending.count() - before);
+}
+
+/**
+ * @brief TileLoadScheduler::Next Takes the most urgent pending load
+ * @param task Set to the load
+ * @return False when nothing is pending
+ */
+bool TileLoadScheduler::Next(LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+
+    if(pending.isEmpty())
+        return false;
+
+    task = pending.takeFirst();
+    inFlight.append(task);
+    if(!task.Prefetch)
+        visiblePending--;
+    return true;
+}
+
+/**
+ * @brief TileLoadScheduler::Finished Marks a load taken by Next() as done
+ * @return True when no other visible tile is pending or being loaded
+ */
+bool TileLoadScheduler::Finished(const LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+
+    for(int i = 0; i < inFlight.count(); i++)
+    {
+        const LoadTask &t = inFlight.at(i);
+        if(t == task && t.Generation == task.Generation && t.Prefetch == task.Prefetch)
+        {
+            inFlight.removeAt(i);
+            break;
+        }
+    }
+
+    if(task.Prefetch || task.Generation != generation || visiblePending > 0)
+        return false;
+
+    foreach(const LoadTask &t, inFlight)
+    {
+        if(!t.Prefetch && t.Generation == generation)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief TileLoadScheduler::IsObsolete Tells a loader to stop
+ * @return True when the zoom changed or the tile left the view since the
+ * load was scheduled
+ */
+bool TileLoadScheduler::IsObsolete(const LoadTask &task)
+{
+    QMutexLocker locker(&mutex);
+
+    if(task.Generation != generation)
+        return true;
+    return !(task.Prefetch ? prefetchWanted : visibleWanted).contains(task.Pos);
+}
+
+//! Drops every pending load and makes the running ones obsolete
+void TileLoadScheduler::Clear()
+{
+    QMutexLocker locker(&mutex);
+
+    pending.clear();
+    visibleWanted.clear();
+    prefetchWanted.clear();
+    visiblePending = 0;
+    zoom = -1;
+    generation++;
+}
+
+int TileLoadScheduler::VisiblePending()
+{
+    QMutexLocker locker(&mutex);
+    return visiblePending;
+}
+
+// Must be called with the mutex held
+bool TileLoadScheduler::IsInFlight(const core::Point &pos, int zoom)
+{
+    foreach(const LoadTask &task, inFlight)
+    {
+        if(task.Generation == generation && task.Zoom == zoom && task.Pos == pos)
+            return true;
+    }
+    return false;
+}
+}
@@ -0,0 +1,69 @@
+/**
+******************************************************************************
+*
+* @file       tileloadscheduler.h
+* @author     dRonin, http://dRonin.org Copyright (C) 2016
+* @brief      Orders, deduplicates and cancels the tile loads of the map core
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/* 
+* This program is free software; you can redistribute it and/or modify 
+* it under the terms of the GNU General Public License as published by 
+* the Free Software Foundation; either version 3 of the License, or 
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful, but 
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+* for more details.
+* 
+* You should have received a copy of the GNU General Public License along 
+* with this program; if not, write to the Free Software Foundation, Inc., 
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILELOADSCHEDULER_H
+#define TILELOADSCHEDULER_H
+
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include "loadtask.h"
+#include "../core/point.h"
+
+namespace internals {
+/**
+ * Tile load queue of the map core. Loads are handed out nearest to the
+ * viewport centre first, with prefetches of the next zoom level only after
+ * every visible tile. Every call to Schedule() replaces the wanted set, so
+ * tiles that scrolled out of view are dropped before they are loaded, and
+ * the loaders can ask whether the tile they are busy with is still wanted.
+ */
+class TileLoadScheduler
+{
+public:
+    TileLoadScheduler();
+
+    int Schedule(const QList<core::Point> &visible, const QList<core::Point> &prefetch, int zoom, const core::Point &center);
+    bool Next(LoadTask &task);
+    bool Finished(const LoadTask &task);
+    bool IsObsolete(const LoadTask &task);
+    void Clear();
+    int VisiblePending();
+
+private:
+    bool IsInFlight(const core::Point &pos, int zoom);
+
+    QMutex mutex;
+    QList<LoadTask> pending;
+    QList<LoadTask> inFlight;
+    QSet<core::Point> visibleWanted;
+    QSet<core::Point> prefetchWanted;
+    int zoom;
+    int generation;
+    int visiblePending;
+};
+}
+#endif // TILELOADSCHEDULER_H
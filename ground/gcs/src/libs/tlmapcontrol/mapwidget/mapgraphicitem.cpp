@@ -385,7 +385,7 @@ namespace mapcontrol
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),TLMaps::Instance()->TilesInMemory.GetPixmap(img));
                                         }
                                     }
                                 }
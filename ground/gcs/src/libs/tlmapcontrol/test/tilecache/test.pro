@@ -0,0 +1,23 @@
+include(../../../../../gcs.pri)
+
+QT += testlib sql widgets
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = tst_tilecache
+TEMPLATE = app
+
+# Build the cache straight from the library sources, its classes are not
+# exported
+CORE = $$PWD/../../core
+INCLUDEPATH *= $$CORE
+DEFINES += TLMAPWIDGET_LIBRARY
+
+SOURCES += tst_tilecache.cpp \
+    $$CORE/pureimagecache.cpp \
+    $$CORE/cacheitemqueue.cpp \
+    $$CORE/point.cpp \
+    $$CORE/size.cpp
+
+HEADERS += $$CORE/maptype.h
@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_tilecache.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Fills a tile cache database and reads it back
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QObject>
+#include <QtCore/QTemporaryDir>
+
+#include "pureimagecache.h"
+
+using namespace core;
+
+// A 100 x 100 tile region
+#define REGION_SIZE 100
+#define TILE_ZOOM 15
+#define TILE_BYTES 2048
+
+// Tiles per transaction, as the TileCacheQueue writer batches them
+#define BATCH_SIZE 64
+
+class tst_TileCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void putTiles();
+    void getTiles();
+    void missingTiles();
+
+private:
+    QByteArray tileData(int x, int y);
+
+    QTemporaryDir *m_dir;
+    PureImageCache *m_cache;
+    QList<CacheItemQueue *> m_tiles;
+};
+
+/**
+ * Tile content that differs for every position
+ */
+QByteArray tst_TileCache::tileData(int x, int y)
+{
+    QByteArray data(TILE_BYTES, 0);
+    quint32 seed = x * REGION_SIZE + y + 1;
+    for (int i = 0; i < data.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (seed >> 16) & 0xFF;
+    }
+    return data;
+}
+
+void tst_TileCache::initTestCase()
+{
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+
+    m_cache = new PureImageCache;
+    m_cache->setGtileCache(m_dir->path() + "/");
+    QVERIFY(QFileInfo(m_dir->path() + "/Data.qmdb").exists());
+
+    for (int x = 0; x < REGION_SIZE; x++) {
+        for (int y = 0; y < REGION_SIZE; y++)
+            m_tiles << new CacheItemQueue(MapType::GoogleSatellite, Point(x, y), tileData(x, y), TILE_ZOOM);
+    }
+}
+
+void tst_TileCache::cleanupTestCase()
+{
+    delete m_cache;
+    qDeleteAll(m_tiles);
+    delete m_dir;
+}
+
+void tst_TileCache::putTiles()
+{
+    // Once only: every run would add the tiles again
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < m_tiles.size(); i += BATCH_SIZE)
+            QVERIFY(m_cache->PutImagesToCache(m_tiles.mid(i, BATCH_SIZE)));
+    }
+}
+
+void tst_TileCache::getTiles()
+{
+    foreach (CacheItemQueue *tile, m_tiles)
+        QCOMPARE(m_cache->GetImageFromCache(tile->GetMapType(), tile->GetPosition(), tile->GetZoom()), tile->GetImg());
+
+    QBENCHMARK {
+        foreach (CacheItemQueue *tile, m_tiles)
+            m_cache->GetImageFromCache(tile->GetMapType(), tile->GetPosition(), tile->GetZoom());
+    }
+}
+
+void tst_TileCache::missingTiles()
+{
+    QVERIFY(m_cache->GetImageFromCache(MapType::GoogleSatellite, Point(REGION_SIZE, 0), TILE_ZOOM).isEmpty());
+    QVERIFY(m_cache->GetImageFromCache(MapType::GoogleSatellite, Point(0, 0), TILE_ZOOM + 1).isEmpty());
+    QVERIFY(m_cache->GetImageFromCache(MapType::GoogleMap, Point(0, 0), TILE_ZOOM).isEmpty());
+}
+
+QTEST_MAIN(tst_TileCache)
+
+#include "tst_tilecache.moc"
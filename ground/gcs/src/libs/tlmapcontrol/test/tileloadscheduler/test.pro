@@ -0,0 +1,22 @@
+include(../../../../../gcs.pri)
+
+QT += testlib
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = tst_tileloadscheduler
+TEMPLATE = app
+
+# Build the scheduler straight from the library sources, its classes are not
+# exported
+CORE = $$PWD/../../core
+INTERNALS = $$PWD/../../internals
+INCLUDEPATH *= $$CORE $$INTERNALS
+DEFINES += TLMAPWIDGET_LIBRARY
+
+SOURCES += tst_tileloadscheduler.cpp \
+    $$INTERNALS/tileloadscheduler.cpp \
+    $$INTERNALS/loadtask.cpp \
+    $$CORE/point.cpp \
+    $$CORE/size.cpp
@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_tileloadscheduler.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Checks the order and lifetime of the map tile loads
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QObject>
+
+#include "tileloadscheduler.h"
+
+using namespace core;
+using namespace internals;
+
+#define TILE_ZOOM 12
+
+class tst_TileLoadScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void distanceOrder();
+    void inFlightDedup();
+    void obsoleteOnPan();
+    void dropOnPan();
+    void obsoleteOnZoom();
+    void prefetchAfterVisible();
+    void clear();
+
+private:
+    static QList<Point> region(int x, int y, int width, int height);
+    static QList<LoadTask> takeAll(TileLoadScheduler &scheduler);
+    static qint64 distance(const Point &p, const Point &center);
+};
+
+/**
+ * Every tile of a rectangle
+ */
+QList<Point> tst_TileLoadScheduler::region(int x, int y, int width, int height)
+{
+    QList<Point> tiles;
+    for (int i = x; i < x + width; i++) {
+        for (int j = y; j < y + height; j++)
+            tiles << Point(i, j);
+    }
+    return tiles;
+}
+
+/**
+ * Takes the pending loads in the order they are handed out
+ */
+QList<LoadTask> tst_TileLoadScheduler::takeAll(TileLoadScheduler &scheduler)
+{
+    QList<LoadTask> tasks;
+    LoadTask task;
+    while (scheduler.Next(task))
+        tasks << task;
+    return tasks;
+}
+
+qint64 tst_TileLoadScheduler::distance(const Point &p, const Point &center)
+{
+    qint64 dx = p.X() - center.X();
+    qint64 dy = p.Y() - center.Y();
+    return dx * dx + dy * dy;
+}
+
+void tst_TileLoadScheduler::distanceOrder()
+{
+    TileLoadScheduler scheduler;
+    Point center(12, 7);
+
+    // The view is off centre, so the order can't come from the list order
+    QCOMPARE(scheduler.Schedule(region(5, 4, 10, 6), QList<Point>(), TILE_ZOOM, center), 60);
+    QCOMPARE(scheduler.VisiblePending(), 60);
+
+    QList<LoadTask> tasks = takeAll(scheduler);
+    QCOMPARE(tasks.count(), 60);
+    QVERIFY(tasks.first().Pos == center);
+    for (int i = 1; i < tasks.count(); i++)
+        QVERIFY(distance(tasks.at(i - 1).Pos, center) <= distance(tasks.at(i).Pos, center));
+
+    foreach (const LoadTask &task, tasks) {
+        QCOMPARE(task.Zoom, TILE_ZOOM);
+        QVERIFY(!task.Prefetch);
+    }
+    QCOMPARE(scheduler.VisiblePending(), 0);
+}
+
+void tst_TileLoadScheduler::inFlightDedup()
+{
+    TileLoadScheduler scheduler;
+    QList<Point> visible = region(0, 0, 3, 3);
+    Point center(1, 1);
+
+    QCOMPARE(scheduler.Schedule(visible, QList<Point>(), TILE_ZOOM, center), 9);
+
+    LoadTask first;
+    QVERIFY(scheduler.Next(first));
+    QVERIFY(first.Pos == center);
+
+    // Scheduling the same view again must not load the running tile twice
+    QCOMPARE(scheduler.Schedule(visible, QList<Point>(), TILE_ZOOM, center), 0);
+    QCOMPARE(scheduler.VisiblePending(), 8);
+    QVERIFY(!scheduler.IsObsolete(first));
+
+    QList<LoadTask> rest = takeAll(scheduler);
+    QCOMPARE(rest.count(), 8);
+    foreach (const LoadTask &task, rest)
+        QVERIFY(task.Pos != first.Pos);
+
+    // Once it is done, the tile can be scheduled again
+    scheduler.Finished(first);
+    foreach (const LoadTask &task, rest)
+        scheduler.Finished(task);
+    QCOMPARE(scheduler.Schedule(visible, QList<Point>(), TILE_ZOOM, center), 9);
+}
+
+void tst_TileLoadScheduler::obsoleteOnPan()
+{
+    TileLoadScheduler scheduler;
+    QList<Point> before = region(0, 0, 4, 4);
+    QList<Point> after = region(2, 0, 4, 4);
+
+    scheduler.Schedule(before, QList<Point>(), TILE_ZOOM, Point(2, 0));
+    QList<LoadTask> running = takeAll(scheduler);
+    QCOMPARE(running.count(), 16);
+    foreach (const LoadTask &task, running)
+        QVERIFY(!scheduler.IsObsolete(task));
+
+    // Pan by two tiles: only the loads that left the view are obsolete, the
+    // ones still in it are not scheduled a second time
+    QCOMPARE(scheduler.Schedule(after, QList<Point>(), TILE_ZOOM, Point(4, 0)), 8);
+    foreach (const LoadTask &task, running)
+        QCOMPARE(scheduler.IsObsolete(task), !after.contains(task.Pos));
+
+    foreach (const LoadTask &task, takeAll(scheduler))
+        QVERIFY(task.Pos.X() >= 4);
+}
+
+void tst_TileLoadScheduler::dropOnPan()
+{
+    TileLoadScheduler scheduler;
+
+    // Tiles that scrolled out are dropped before they are loaded
+    scheduler.Schedule(region(0, 0, 4, 4), QList<Point>(), TILE_ZOOM, Point(2, 0));
+    scheduler.Schedule(region(2, 0, 4, 4), QList<Point>(), TILE_ZOOM, Point(4, 0));
+    QCOMPARE(scheduler.VisiblePending(), 16);
+
+    QList<LoadTask> tasks = takeAll(scheduler);
+    QCOMPARE(tasks.count(), 16);
+    foreach (const LoadTask &task, tasks) {
+        QVERIFY(task.Pos.X() >= 2);
+        QVERIFY(!scheduler.IsObsolete(task));
+    }
+}
+
+void tst_TileLoadScheduler::obsoleteOnZoom()
+{
+    TileLoadScheduler scheduler;
+    QList<Point> visible = region(0, 0, 2, 2);
+
+    scheduler.Schedule(visible, QList<Point>(), TILE_ZOOM, Point(0, 0));
+
+    LoadTask old;
+    QVERIFY(scheduler.Next(old));
+    QVERIFY(!scheduler.IsObsolete(old));
+
+    // Same tile positions one level down: the running load is of no use
+    QCOMPARE(scheduler.Schedule(visible, QList<Point>(), TILE_ZOOM + 1, Point(0, 0)), 1);
+    QVERIFY(scheduler.IsObsolete(old));
+
+    // The position is loaded again for the new zoom level
+    QList<LoadTask> tasks = takeAll(scheduler);
+    QCOMPARE(tasks.count(), 4);
+    foreach (const LoadTask &task, tasks) {
+        QCOMPARE(task.Zoom, TILE_ZOOM + 1);
+        QVERIFY(task.Generation != old.Generation);
+    }
+
+    // An obsolete load finishing says nothing about the current view
+    QVERIFY(!scheduler.Finished(old));
+}
+
+void tst_TileLoadScheduler::prefetchAfterVisible()
+{
+    TileLoadScheduler scheduler;
+    Point center(5, 5);
+    QList<Point> visible = region(4, 4, 3, 3);
+    // The next zoom level has twice the tiles per side
+    QList<Point> prefetch = region(8, 8, 6, 6);
+
+    QCOMPARE(scheduler.Schedule(visible, prefetch, TILE_ZOOM, center), 9 + 36);
+    QCOMPARE(scheduler.VisiblePending(), 9);
+
+    QList<LoadTask> tasks = takeAll(scheduler);
+    QCOMPARE(tasks.count(), 9 + 36);
+
+    for (int i = 0; i < tasks.count(); i++) {
+        const LoadTask &task = tasks.at(i);
+        if (i < 9) {
+            QVERIFY(!task.Prefetch);
+            QCOMPARE(task.Zoom, TILE_ZOOM);
+        } else {
+            QVERIFY(task.Prefetch);
+            QCOMPARE(task.Zoom, TILE_ZOOM + 1);
+        }
+    }
+
+    // Prefetches are ordered around the centre scaled to their zoom level
+    Point prefetchCenter(center.X() * 2, center.Y() * 2);
+    for (int i = 10; i < tasks.count(); i++)
+        QVERIFY(distance(tasks.at(i - 1).Pos, prefetchCenter) <= distance(tasks.at(i).Pos, prefetchCenter));
+
+    // The view is complete with the last visible tile, whatever the
+    // prefetches are doing
+    for (int i = 0; i < 8; i++)
+        QVERIFY(!scheduler.Finished(tasks.at(i)));
+    QVERIFY(scheduler.Finished(tasks.at(8)));
+    for (int i = 9; i < tasks.count(); i++)
+        QVERIFY(!scheduler.Finished(tasks.at(i)));
+}
+
+void tst_TileLoadScheduler::clear()
+{
+    TileLoadScheduler scheduler;
+
+    scheduler.Schedule(region(0, 0, 3, 3), region(0, 0, 6, 6), TILE_ZOOM, Point(1, 1));
+
+    LoadTask task;
+    QVERIFY(scheduler.Next(task));
+
+    scheduler.Clear();
+    QCOMPARE(scheduler.VisiblePending(), 0);
+    QVERIFY(!scheduler.Next(task));
+    QVERIFY(scheduler.IsObsolete(task));
+    QVERIFY(!scheduler.Finished(task));
+}
+
+QTEST_MAIN(tst_TileLoadScheduler)
+
+#include "tst_tileloadscheduler.moc"
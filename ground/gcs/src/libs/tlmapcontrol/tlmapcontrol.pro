@@ -43,6 +43,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     internals/sizelatlng.cpp \
     internals/pointlatlng.cpp \
     internals/loadtask.cpp \
+    internals/tileloadscheduler.cpp \
     internals/mousewheelzoomtype.cpp \
     internals/projections/lks94projection.cpp \
     internals/projections/mercatorprojection.cpp \
@@ -96,6 +97,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     internals/tile.h \
     internals/tilematrix.h \
     internals/loadtask.h \
+    internals/tileloadscheduler.h \
     internals/copyrightstrings.h \
     internals/pureprojection.h \
     internals/pointlatlng.h \
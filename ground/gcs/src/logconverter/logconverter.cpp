@@ -0,0 +1,476 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logconverter.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Decodes a GCS .drlog file into per-object columnar tables
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QtEndian>
+
+#include "uavobjectmanager.h"
+#include "uavobjects/uavobjectsinit.h"
+
+#include "logconverter.h"
+
+// Log records are a 32 bit timestamp followed by a 64 bit packet size
+#define RECORD_HEADER_SIZE (sizeof(quint32) + sizeof(qint64))
+
+// Header/body separator written by LogFile::open()
+#define HEADER_SEPARATOR "\n##\n"
+#define HEADER_SEARCH_LENGTH 1024
+
+// Spilled binary rows are a timestamp and an instance id before the object data
+#define SPILL_ROW_HEADER_SIZE (sizeof(quint32) + sizeof(quint16))
+#define COLUMN_CHUNK_SIZE (64 * 1024)
+
+const char LogConverter::BINARY_MAGIC[8] = { 'D', 'R', 'C', 'O', 'L', 'S', '0', '1' };
+
+LogConverter::LogConverter(QFile* log, UAVObjectManager* objMngr) :
+    UAVTalk(log, objMngr),
+    logFile(log),
+    currentTimestamp(0),
+    packetCount(0),
+    outputFormat(FORMAT_CSV),
+    writeFailed(false)
+{
+}
+
+LogConverter::~LogConverter()
+{
+    foreach (ObjectTable* table, tables) {
+        delete table->csv;
+        delete table->file;
+    }
+    qDeleteAll(tables);
+}
+
+/**
+ * Decode the whole log and write one table per object type.
+ * \param[in] outputPath Directory that receives the tables, created if needed
+ * \param[in] format Output file format
+ * \return Success (true), Failure (false)
+ */
+bool LogConverter::convert(const QString& outputPath, OutputFormat format)
+{
+    if (!logFile->isOpen() && !logFile->open(QIODevice::ReadOnly)) {
+        errorString = logFile->errorString();
+        return false;
+    }
+
+    if (!QDir().mkpath(outputPath)) {
+        errorString = QString("Cannot create output directory %1").arg(outputPath);
+        return false;
+    }
+
+    outputDir = QDir(outputPath);
+    outputFormat = format;
+    writeFailed = false;
+
+    qint64 fileSize = logFile->size();
+    uchar* map = logFile->map(0, fileSize);
+    if (map == NULL) {
+        errorString = logFile->errorString();
+        return false;
+    }
+
+    qint64 pos = findDataStart(map, fileSize);
+    while (!writeFailed && pos + (qint64) RECORD_HEADER_SIZE <= fileSize) {
+        quint32 timeStamp;
+        qint64 dataSize;
+
+        memcpy(&timeStamp, map + pos, sizeof(timeStamp));
+        memcpy(&dataSize, map + pos + sizeof(timeStamp), sizeof(dataSize));
+
+        // Same resync rule as the replay path in LogFile::buildIndex()
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0 || dataSize < 1) {
+            pos++;
+            continue;
+        }
+
+        if (pos + (qint64) RECORD_HEADER_SIZE + dataSize > fileSize)
+            break;
+
+        currentTimestamp = timeStamp;
+        processInputBlock(map + pos + RECORD_HEADER_SIZE, dataSize);
+
+        pos += RECORD_HEADER_SIZE + dataSize;
+    }
+
+    logFile->unmap(map);
+
+    // Close every table, also after a failure, so no spill file is left behind
+    bool ok = !writeFailed;
+    foreach (ObjectTable* table, tables) {
+        if (!closeTable(table))
+            ok = false;
+    }
+
+    return ok;
+}
+
+/**
+ * Write a received object to its table. Objects are never unpacked,
+ * the raw payload goes straight to the output.
+ */
+bool LogConverter::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length)
+{
+    if (type != TYPE_OBJ && type != TYPE_OBJ_ACK)
+        return true;
+    if (instId == ALL_INSTANCES)
+        return false;
+    if (writeFailed)
+        return true;
+
+    ObjectTable* table = tables.value(objId, NULL);
+    if (table == NULL) {
+        UAVObject* obj = objMngr->getObject(objId);
+        if (obj == NULL)
+            return false;
+        table = createTable(obj);
+        tables.insert(objId, table);
+
+        if (!openTable(table)) {
+            writeFailed = true;
+            return true;
+        }
+    }
+
+    if (length != (qint32) table->obj->getNumBytes())
+        return false;
+
+    writeRow(table, instId, data);
+
+    packetCount++;
+    return true;
+}
+
+/**
+ * Locate the first log record, skipping the text header if there is one.
+ */
+qint64 LogConverter::findDataStart(const uchar* map, qint64 size)
+{
+    QByteArray head = QByteArray::fromRawData((const char*) map, qMin(size, (qint64) HEADER_SEARCH_LENGTH));
+    int separator = head.indexOf(HEADER_SEPARATOR);
+
+    if (separator < 0) {
+        qWarning() << logFile->fileName() << ": no header separator, decoding from the start of the file";
+        return 0;
+    }
+
+    return separator + strlen(HEADER_SEPARATOR);
+}
+
+/**
+ * Build the column layout of an object: one column per field element,
+ * strings and bitfields are kept whole.
+ */
+LogConverter::ObjectTable* LogConverter::createTable(UAVObject* obj)
+{
+    ObjectTable* table = new ObjectTable;
+    table->obj = obj;
+    table->rows = 0;
+    table->file = NULL;
+    table->csv = NULL;
+
+    foreach (UAVObjectField* field, obj->getFields()) {
+        Column column;
+        column.type = field->getType();
+        column.offset = field->getDataOffset();
+
+        quint32 numElements = field->getNumElements();
+        if (column.type == UAVObjectField::STRING ||
+                column.type == UAVObjectField::BITFIELD ||
+                numElements == 1) {
+            column.name = field->getName();
+            column.size = field->getNumBytes();
+            table->columns.append(column);
+            continue;
+        }
+
+        QStringList elementNames = field->getElementNames();
+        column.size = field->getNumBytes() / numElements;
+        for (quint32 i = 0; i < numElements; i++) {
+            column.name = field->getName() + "." + elementNames.value(i, QString::number(i));
+            table->columns.append(column);
+            column.offset += column.size;
+        }
+    }
+
+    return table;
+}
+
+/**
+ * Open the output of a table. CSV tables get their header line, binary
+ * tables collect their rows in a spill file next to the output, which
+ * is turned into columns when the table is closed.
+ */
+bool LogConverter::openTable(ObjectTable* table)
+{
+    QString name = table->obj->getName();
+    QIODevice::OpenMode mode;
+
+    if (outputFormat == FORMAT_CSV) {
+        table->path = outputDir.filePath(name + ".csv");
+        table->file = new QFile(table->path);
+        mode = QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text;
+    } else {
+        table->path = outputDir.filePath(name + ".col");
+        table->file = new QFile(table->path + ".rows");
+        mode = QIODevice::ReadWrite | QIODevice::Truncate;
+    }
+
+    if (!table->file->open(mode)) {
+        errorString = QString("%1: %2").arg(table->file->fileName()).arg(table->file->errorString());
+        return false;
+    }
+
+    if (outputFormat == FORMAT_CSV) {
+        table->csv = new QTextStream(table->file);
+
+        QTextStream& out = *table->csv;
+        out << "Timestamp";
+        if (!table->obj->isSingleInstance())
+            out << ",Instance";
+        foreach (const Column& column, table->columns)
+            out << "," << column.name;
+        out << "\n";
+    }
+
+    return true;
+}
+
+/**
+ * Write one received packet: a CSV line, or a raw row of the spill file.
+ */
+void LogConverter::writeRow(ObjectTable* table, quint16 instId, const quint8* data)
+{
+    if (outputFormat == FORMAT_CSV) {
+        QTextStream& out = *table->csv;
+
+        out << currentTimestamp;
+        if (!table->obj->isSingleInstance())
+            out << "," << instId;
+        foreach (const Column& column, table->columns)
+            out << "," << formatElement(column, (const char*) data + column.offset);
+        out << "\n";
+    } else {
+        uchar header[SPILL_ROW_HEADER_SIZE];
+        qToLittleEndian<quint32>(currentTimestamp, header);
+        qToLittleEndian<quint16>(instId, header + sizeof(quint32));
+
+        table->file->write((const char*) header, sizeof(header));
+        table->file->write((const char*) data, table->obj->getNumBytes());
+    }
+
+    table->rows++;
+}
+
+/**
+ * Finish the output of a table and release its files.
+ */
+bool LogConverter::closeTable(ObjectTable* table)
+{
+    if (table->file == NULL || !table->file->isOpen())
+        return false;
+
+    bool ok;
+    if (outputFormat == FORMAT_CSV) {
+        table->csv->flush();
+        ok = table->file->error() == QFile::NoError;
+        if (!ok)
+            errorString = QString("%1: %2").arg(table->path).arg(table->file->errorString());
+        table->file->close();
+    } else {
+        ok = writeBinary(table);
+        table->file->remove();
+    }
+
+    return ok;
+}
+
+/**
+ * Render one raw little endian element as text.
+ */
+QString LogConverter::formatElement(const Column& column, const char* raw)
+{
+    const uchar* p = (const uchar*) raw;
+
+    switch (column.type) {
+    case UAVObjectField::INT8:
+        return QString::number((qint8) p[0]);
+    case UAVObjectField::INT16:
+        return QString::number(qFromLittleEndian<qint16>(p));
+    case UAVObjectField::INT32:
+        return QString::number(qFromLittleEndian<qint32>(p));
+    case UAVObjectField::UINT16:
+        return QString::number(qFromLittleEndian<quint16>(p));
+    case UAVObjectField::UINT32:
+        return QString::number(qFromLittleEndian<quint32>(p));
+    case UAVObjectField::FLOAT32: {
+        quint32 bits = qFromLittleEndian<quint32>(p);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return QString::number(value, 'g', 9);
+    }
+    case UAVObjectField::STRING: {
+        QString text = QString::fromUtf8(raw, qstrnlen(raw, column.size));
+        text.replace("\"", "\"\"");
+        return "\"" + text + "\"";
+    }
+    case UAVObjectField::UINT8:
+    case UAVObjectField::ENUM:
+    case UAVObjectField::BITFIELD:
+    default:
+        return QString::number(p[0]);
+    }
+}
+
+/**
+ * Write a table in the binary column format:
+ *
+ *  char[8]  magic "DRCOLS01"
+ *  u32      number of rows
+ *  u32      number of columns
+ *  per column: u16 name length, name (UTF-8), u8 UAVObjectField::FieldType, u16 element size
+ *  per column: rows * element size bytes of little endian data
+ *
+ * The first two columns are always the log timestamp (u32) and the
+ * instance id (u16). The header is only written at close, once the
+ * number of rows is known, and the columns are gathered from the rows
+ * in the spill file.
+ */
+bool LogConverter::writeBinary(ObjectTable* table)
+{
+    QFile* spill = table->file;
+    if (!spill->flush() || spill->error() != QFile::NoError) {
+        errorString = QString("%1: %2").arg(spill->fileName()).arg(spill->errorString());
+        return false;
+    }
+
+    QFile file(table->path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorString = QString("%1: %2").arg(table->path).arg(file.errorString());
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out.writeRawData(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    out << table->rows << (quint32) (table->columns.size() + 2);
+
+    // Column offsets within a spilled row
+    QVector<Column> header;
+    Column timestampColumn = { "Timestamp", UAVObjectField::UINT32, 0, sizeof(quint32) };
+    Column instanceColumn = { "Instance", UAVObjectField::UINT16, sizeof(quint32), sizeof(quint16) };
+    header << timestampColumn << instanceColumn;
+    foreach (Column column, table->columns) {
+        column.offset += SPILL_ROW_HEADER_SIZE;
+        header << column;
+    }
+
+    foreach (const Column& column, header) {
+        QByteArray name = column.name.toUtf8();
+        out << (quint16) name.size();
+        out.writeRawData(name.constData(), name.size());
+        out << (quint8) column.type << column.size;
+    }
+
+    // Transpose the spilled rows one column at a time, through the page cache
+    const qint64 rowSize = SPILL_ROW_HEADER_SIZE + table->obj->getNumBytes();
+    const uchar* rows = NULL;
+    if (table->rows > 0) {
+        rows = spill->map(0, table->rows * rowSize);
+        if (rows == NULL) {
+            errorString = QString("%1: %2").arg(spill->fileName()).arg(spill->errorString());
+            return false;
+        }
+    }
+
+    QByteArray chunk;
+    chunk.reserve(COLUMN_CHUNK_SIZE);
+    foreach (const Column& column, header) {
+        for (quint32 row = 0; row < table->rows; row++) {
+            chunk.append((const char*) rows + row * rowSize + column.offset, column.size);
+            if (chunk.size() >= COLUMN_CHUNK_SIZE) {
+                out.writeRawData(chunk.constData(), chunk.size());
+                chunk.resize(0);
+            }
+        }
+        out.writeRawData(chunk.constData(), chunk.size());
+        chunk.resize(0);
+    }
+
+    if (rows != NULL)
+        spill->unmap((uchar*) rows);
+
+    if (out.status() != QDataStream::Ok) {
+        errorString = QString("%1: %2").arg(table->path).arg(file.errorString());
+        return false;
+    }
+    return true;
+}
+
+LogConverterTask::LogConverterTask(const QString& logPath, const QString& outputDir, LogConverter::OutputFormat format) :
+    logPath(logPath),
+    outputDir(outputDir),
+    format(format),
+    success(false)
+{
+    setAutoDelete(false);
+}
+
+void LogConverterTask::run()
+{
+    // Object registration touches the global QML type registry
+    static QMutex initMutex;
+
+    UAVObjectManager objMngr;
+    {
+        QMutexLocker locker(&initMutex);
+        UAVObjectsInitialize(&objMngr);
+    }
+
+    QFile log(logPath);
+    if (!log.open(QIODevice::ReadOnly)) {
+        qWarning() << logPath << ":" << log.errorString();
+    } else {
+        QString dir = QDir(outputDir).filePath(QFileInfo(logPath).completeBaseName());
+        LogConverter converter(&log, &objMngr);
+
+        success = converter.convert(dir, format);
+        if (success)
+            qDebug() << logPath << ":" << converter.getPacketCount() << "packets written to" << dir;
+        else
+            qWarning() << logPath << ":" << converter.getErrorString();
+    }
+
+    // The object manager does not own the objects it indexes
+    foreach (const QVector<UAVObject*>& instances, objMngr.getObjectsVector())
+        qDeleteAll(instances);
+}
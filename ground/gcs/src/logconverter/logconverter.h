@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logconverter.h
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Decodes a GCS .drlog file into per-object columnar tables
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGCONVERTER_H
+#define LOGCONVERTER_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QRunnable>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+
+#include "uavtalk.h"
+#include "uavobjectfield.h"
+
+/**
+ * UAVTalk receiver that, instead of updating objects, writes every
+ * received object packet as a row of the table for its type. The log
+ * is decoded in a single streaming pass and rows go to disk as they are
+ * decoded, so memory use does not grow with the length of the log.
+ */
+class LogConverter : public UAVTalk
+{
+public:
+    typedef enum { FORMAT_CSV, FORMAT_BINARY } OutputFormat;
+
+    LogConverter(QFile* log, UAVObjectManager* objMngr);
+    ~LogConverter();
+
+    bool convert(const QString& outputPath, OutputFormat format);
+    QString getErrorString() { return errorString; }
+    quint32 getPacketCount() { return packetCount; }
+
+protected:
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
+
+private:
+    typedef struct {
+        QString name;
+        UAVObjectField::FieldType type;
+        quint16 offset;
+        quint16 size;
+    } Column;
+
+    typedef struct {
+        UAVObject* obj;
+        QVector<Column> columns;
+        quint32 rows;
+        QString path;
+        QFile* file;        // The CSV output, or the raw rows spilled for the binary output
+        QTextStream* csv;
+    } ObjectTable;
+
+    static const char BINARY_MAGIC[8];
+
+    QFile* logFile;
+    quint32 currentTimestamp;
+    quint32 packetCount;
+    QString errorString;
+    QDir outputDir;
+    OutputFormat outputFormat;
+    bool writeFailed;
+    QHash<quint32, ObjectTable*> tables;
+
+    qint64 findDataStart(const uchar* map, qint64 size);
+    ObjectTable* createTable(UAVObject* obj);
+    bool openTable(ObjectTable* table);
+    void writeRow(ObjectTable* table, quint16 instId, const quint8* data);
+    bool closeTable(ObjectTable* table);
+    bool writeBinary(ObjectTable* table);
+    static QString formatElement(const Column& column, const char* raw);
+};
+
+/**
+ * Converts one log file on a worker thread. Each task owns its own
+ * object manager so that files can be processed in parallel.
+ */
+class LogConverterTask : public QRunnable
+{
+public:
+    LogConverterTask(const QString& logPath, const QString& outputDir, LogConverter::OutputFormat format);
+    void run();
+    bool succeeded() { return success; }
+
+private:
+    QString logPath;
+    QString outputDir;
+    LogConverter::OutputFormat format;
+    bool success;
+};
+
+#endif // LOGCONVERTER_H
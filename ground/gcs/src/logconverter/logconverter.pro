@@ -0,0 +1,30 @@
+include(../../gcs.pri)
+include(../rpath.pri)
+
+QT += core network qml
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = logconverter
+TEMPLATE = app
+DESTDIR = $$GCS_APP_PATH
+macx {
+DESTDIR = $$GCS_BIN_PATH
+}
+
+# The UAVObjects and UAVTalk libraries live with the plugins
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+linux-* {
+    QMAKE_LFLAGS += \'-Wl,-rpath,\$\$ORIGIN/../$$GCS_LIBRARY_BASENAME/$$GCS_PROJECT_BRANDING/plugins/dRonin\'
+}
+
+include(../plugins/uavtalk/uavtalk.pri)
+
+SOURCES += main.cpp \
+    logconverter.cpp
+
+HEADERS += logconverter.h
+
+SOURCES += $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp
@@ -0,0 +1,97 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Command line batch converter for GCS .drlog files
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QThread>
+#include <QThreadPool>
+
+#include "logconverter.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("logconverter");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Exports GCS .drlog files to one table per UAVObject");
+    parser.addHelpOption();
+
+    QCommandLineOption formatOption(QStringList() << "f" << "format",
+            "Output format, csv or binary.", "format", "csv");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+            "Output directory, one subdirectory is created per log.", "directory", ".");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs",
+            "Number of logs converted in parallel.", "jobs",
+            QString::number(QThread::idealThreadCount()));
+
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.addPositionalArgument("logs", "Log files to convert.", "logs...");
+    parser.process(app);
+
+    QStringList logs = parser.positionalArguments();
+    if (logs.isEmpty())
+        parser.showHelp(1);
+
+    LogConverter::OutputFormat format;
+    QString formatName = parser.value(formatOption);
+    if (formatName == "csv") {
+        format = LogConverter::FORMAT_CSV;
+    } else if (formatName == "binary") {
+        format = LogConverter::FORMAT_BINARY;
+    } else {
+        qCritical("Unknown output format %s", qPrintable(formatName));
+        return 1;
+    }
+
+    bool ok;
+    int jobs = parser.value(jobsOption).toInt(&ok);
+    if (!ok || jobs < 1) {
+        qCritical("Invalid number of jobs %s", qPrintable(parser.value(jobsOption)));
+        return 1;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+
+    QList<LogConverterTask*> tasks;
+    foreach (const QString& log, logs) {
+        LogConverterTask* task = new LogConverterTask(log, parser.value(outputOption), format);
+        tasks.append(task);
+        pool.start(task);
+    }
+    pool.waitForDone();
+
+    int failures = 0;
+    foreach (LogConverterTask* task, tasks) {
+        if (!task->succeeded())
+            failures++;
+    }
+    qDeleteAll(tasks);
+
+    return failures ? 1 : 0;
+}
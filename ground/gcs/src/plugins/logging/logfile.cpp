@@ -26,16 +26,29 @@
  */
 
 #include "logfile.h"
+#include <algorithm>
 #include <QDebug>
 #include <QtGlobal>
 #include <QTextStream>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
 
 #include <coreplugin/coreconstants.h>
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    lastPlayTime(0),
+    lastPlayTimeOffset(0),
+    playbackSpeed(1),
+    mappedFile(NULL),
+    dataStart(0),
+    pendingData(NULL),
+    pendingSize(0),
+    timestampBufferIdx(0),
+    firstTimestamp(0),
+    fastReplay(false)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -130,7 +143,9 @@ bool LogFile::open(OpenMode mode) {
     // Must call parent function for QIODevice to pass calls to writeData
     // We always open ReadWrite, because otherwise we will get tons of warnings
     // during a logfile replay. Read nature is checked upon write ops below.
-    QIODevice::open(QIODevice::ReadWrite);
+    // Replayed packets come straight from the mapped file, so there is no
+    // point in QIODevice buffering them a second time.
+    QIODevice::open(QIODevice::ReadWrite | QIODevice::Unbuffered);
 
     return true;
 }
@@ -141,6 +156,12 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+    pendingData = NULL;
+    pendingSize = 0;
+    if (mappedFile) {
+        file.unmap(mappedFile);
+        mappedFile = NULL;
+    }
     file.close();
     QIODevice::close();
 }
@@ -162,147 +183,219 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
 }
 
 qint64 LogFile::readData(char * data, qint64 maxSize) {
-    QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
+    qint64 toRead = qMin(maxSize, pendingSize);
+    memcpy(data, pendingData, toRead);
+    pendingData += toRead;
+    pendingSize -= toRead;
     return toRead;
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return pendingSize + QIODevice::bytesAvailable();
 }
 
+/**
+ * Offer the packets that are due to the reader. Each packet is handed
+ * out straight from the mapped file; the next one is only offered once
+ * the previous one has been read completely.
+ */
 void LogFile::timerFired()
 {
-    qint64 dataSize;
+    int time = myTime.elapsed();
 
-    if(file.bytesAvailable() > 4)
+    if (!fastReplay)
+        lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
+
+    int sent = 0;
+    while (timestampBufferIdx < timestampBuffer.size() && pendingSize == 0)
     {
+        if (fastReplay) {
+            if (sent >= FAST_REPLAY_BATCH)
+                break;
+        } else if (timestampBuffer[timestampBufferIdx] - firstTimestamp > lastPlayTime) {
+            break;
+        }
 
-        int time;
-        time = myTime.elapsed();
-
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
-
-            file.read((char *) &dataSize, sizeof(dataSize));
-
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
-
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
-
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
-
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
-
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+        const uchar *record = mappedFile + timestampPos[timestampBufferIdx];
+        qint64 dataSize;
+        memcpy(&dataSize, record + sizeof(quint32), sizeof(dataSize));
 
-        }
-    } else {
-        stopReplay();
+        pendingData = (const char *) record + RECORD_HEADER_SIZE;
+        pendingSize = dataSize;
+        timestampBufferIdx++;
+        sent++;
+
+        emit readyRead();
     }
 
+    if (fastReplay && timestampBufferIdx > 0)
+        lastPlayTime = timestampBuffer[timestampBufferIdx - 1] - firstTimestamp;
+
+    if (timestampBufferIdx >= timestampBuffer.size() && pendingSize == 0)
+        stopReplay();
 }
 
 bool LogFile::startReplay() {
-    dataBuffer.clear();
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
     playbackSpeed = 1;
+    pendingData = NULL;
+    pendingSize = 0;
+    timestampBufferIdx = 0;
+
+    dataStart = file.pos();
+    mappedFile = file.map(0, file.size());
+    if (mappedFile == NULL) {
+        QMessageBox msgBox;
+        msgBox.setText("Unable to read logfile.");
+        msgBox.setInformativeText(file.errorString());
+        msgBox.exec();
+
+        stopReplay();
+        return false;
+    }
+
+    // Reuse the index from a previous replay when it is still valid
+    if (!loadIndex()) {
+        if (!buildIndex()) {
+            stopReplay();
+            return false;
+        }
+        saveIndex();
+    }
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
+    //Check if any timestamps were successfully read
+    if (timestampBuffer.size() == 0){
+        QMessageBox msgBox;
+        msgBox.setText("Empty logfile.");
+        msgBox.setInformativeText("No log data can be found.");
+        msgBox.exec();
+
+        stopReplay();
+        return false;
+    }
+
+    firstTimestamp = timestampBuffer[0];
+
+    timer.setInterval(fastReplay ? 0 : 10);
+    timer.start();
+    emit replayStarted();
+    return true;
+}
+
+/**
+ * Scan the mapped log and record the timestamp and position of every packet.
+ * @return false if the file turned out to be unusable
+ */
+bool LogFile::buildIndex()
+{
+    bool warnedSequence = false;
+    qint64 fileSize = file.size();
+    qint64 pos = dataStart;
+
+    timestampBuffer.clear();
     timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
 
-    while (!file.atEnd()){
+    while (pos + RECORD_HEADER_SIZE <= fileSize) {
+        quint32 timeStamp;
         qint64 dataSize;
 
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
         //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
+        memcpy(&timeStamp, mappedFile + pos, sizeof(timeStamp));
+        memcpy(&dataSize, mappedFile + pos + sizeof(timeStamp), sizeof(dataSize));
 
         //Check if dataSize sync bytes are correct.
         //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0 || dataSize < 1) {
+            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos, 0, 16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16) << ", but expected 0x""00"".";
+            pos++;
             continue;
         }
 
+        // Drop a packet that was cut short at the end of the file
+        if (pos + RECORD_HEADER_SIZE + dataSize > fileSize)
+            break;
+
         //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
+        if (!timestampBuffer.isEmpty() && timeStamp < timestampBuffer.last() && !warnedSequence) {
             QMessageBox msgBox;
             msgBox.setText("Corrupted file.");
             msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
             msgBox.exec();
 
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
+            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << timeStamp;
+            warnedSequence = true;
         }
 
-        timestampBuffer.append(lastTimeStamp);
+        timestampBuffer.append(timeStamp);
+        timestampPos.append(pos);
 
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+        pos += RECORD_HEADER_SIZE + dataSize;
     }
 
-    //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
-        QMessageBox msgBox;
-        msgBox.setText("Empty logfile.");
-        msgBox.setInformativeText("No log data can be found.");
-        msgBox.exec();
+    return true;
+}
 
-        stopReplay();
+/**
+ * Load the sidecar index written by a previous replay of the same file.
+ * @return true if an index matching the current file was loaded
+ */
+bool LogFile::loadIndex()
+{
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::ReadOnly))
         return false;
-    }
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    QFileInfo info(file);
+    QDataStream in(&indexFile);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint64 fileSize, modified, start;
+    in >> magic >> version >> fileSize >> modified >> start;
+
+    if (in.status() != QDataStream::Ok || magic != INDEX_MAGIC ||
+            version != INDEX_VERSION || fileSize != info.size() ||
+            modified != info.lastModified().toMSecsSinceEpoch() ||
+            start != dataStart)
+        return false;
+
+    in >> timestampBuffer >> timestampPos;
+
+    if (in.status() != QDataStream::Ok ||
+            timestampBuffer.size() != timestampPos.size()) {
+        timestampBuffer.clear();
+        timestampPos.clear();
+        return false;
+    }
 
-    timer.setInterval(10);
-    timer.start();
-    emit replayStarted();
     return true;
 }
 
+/**
+ * Write the index next to the log so the next replay can skip the scan.
+ * Failing to write it is not an error, the log is just rescanned next time.
+ */
+void LogFile::saveIndex()
+{
+    QFile indexFile(indexFileName());
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Unable to write logfile index" << indexFile.fileName();
+        return;
+    }
+
+    QFileInfo info(file);
+    QDataStream out(&indexFile);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << INDEX_MAGIC << INDEX_VERSION << (qint64) info.size() <<
+           (qint64) info.lastModified().toMSecsSinceEpoch() << dataStart <<
+           timestampBuffer << timestampPos;
+}
+
 bool LogFile::stopReplay() {
     close();
     emit replayFinished();
@@ -322,21 +415,35 @@ void LogFile::resumeReplay()
 
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in seconds from the start of the log
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
-    }
+    if (timestampBuffer.isEmpty())
+        return;
+
+    // First packet at or after the requested time
+    quint32 target = firstTimestamp + val * 1000;
+    timestampBufferIdx = std::lower_bound(timestampBuffer.constBegin(),
+            timestampBuffer.constEnd(), target) - timestampBuffer.constBegin();
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    // Drop whatever was left of the packet from the old position
+    pendingSize = 0;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = target - firstTimestamp;
 
-    qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
+    qDebug() << "Replaying at: " << lastPlayTime << ", but requestion at" << val*1000;
 }
 
+/**
+ * @brief LogFile::setFastReplay, replays the log as fast as the reader
+ * consumes it instead of following the timestamps
+ * @param enabled, true to replay as fast as possible
+ */
+void LogFile::setFastReplay(bool enabled)
+{
+    fastReplay = enabled;
+    lastPlayTimeOffset = myTime.elapsed();
+    timer.setInterval(fastReplay ? 0 : 10);
+}
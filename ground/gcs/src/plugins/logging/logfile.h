@@ -31,9 +31,9 @@
 #include <QIODevice>
 #include <QTime>
 #include <QTimer>
-#include <QMutexLocker>
 #include <QDebug>
-#include <QBuffer>
+#include <QFile>
+#include <QVector>
 #include "uavobjectmanager.h"
 #include <math.h>
 
@@ -56,6 +56,7 @@ public:
 public slots:
     void setReplaySpeed(double val) { playbackSpeed = val; qDebug() << "New playback speed: " << playbackSpeed; }
     void setReplayTime(double val);
+    void setFastReplay(bool enabled);
     void pauseReplay();
     void resumeReplay();
 
@@ -68,24 +69,40 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
     QTimer timer;
     QTime myTime;
     QFile file;
-    quint32 lastTimeStamp;
-    quint32 lastPlayTime;
-    QMutex mutex;
-
+    double lastPlayTime;
 
     int lastPlayTimeOffset;
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    //! Record header: quint32 timestamp followed by qint64 packet size
+    static const int RECORD_HEADER_SIZE = sizeof(quint32) + sizeof(qint64);
+    //! Packets sent per timer tick when replaying as fast as possible
+    static const int FAST_REPLAY_BATCH = 500;
+    //! Sidecar index file identification
+    static const quint32 INDEX_MAGIC = 0x494c5244;
+    static const quint32 INDEX_VERSION = 1;
+
+    QString indexFileName() const { return file.fileName() + ".idx"; }
+    bool loadIndex();
+    bool buildIndex();
+    void saveIndex();
+
+    uchar *mappedFile;
+    qint64 dataStart;
+
+    // Packet currently offered to the reader, points into mappedFile
+    const char *pendingData;
+    qint64 pendingSize;
+
+    QVector<quint32> timestampBuffer;
+    QVector<qint64> timestampPos;
+    int timestampBufferIdx;
     quint32 firstTimestamp;
+    bool fastReplay;
 };
 
 #endif // LOGFILE_H
@@ -41,7 +41,6 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
     dataUpdated(false)
 {
     uavObjectName = p_uavObject;
@@ -61,12 +60,10 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
+    mathFunctionType = MATH_NONE;
     correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
@@ -100,14 +97,10 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    zData = new QVector<double>();
-    zDataHistory = new QVector<double>();
-    timeDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
+    mathFunctionType = MATH_NONE;
     correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
@@ -124,8 +117,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
@@ -135,12 +126,24 @@ Plot3dData::~Plot3dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (zData != NULL)
-        delete zData;
-    if (zDataHistory != NULL)
-        delete zDataHistory;
-    if (timeDataHistory != NULL)
-        delete timeDataHistory;
+}
+
+
+/**
+ * @brief PlotData::parseMathFunction Resolve a math function name, as stored
+ * in the configuration, so that it need not be compared on every sample
+ * @param name Math function name
+ * @return The matching math function, MATH_NONE if unknown
+ */
+PlotData::MathFunction PlotData::parseMathFunction(const QString &name)
+{
+    if (name == "Boxcar average")
+        return MATH_BOXCAR_AVERAGE;
+    if (name == "Standard deviation")
+        return MATH_STANDARD_DEVIATION;
+    if (name == "FFT")
+        return MATH_FFT;
+    return MATH_NONE;
 }
 
 
@@ -155,13 +158,10 @@ Plot3dData::~Plot3dData()
 double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
 {
     Q_UNUSED(obj);
-    QVariant value;
 
     if(haveSubField){
         int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
+        return field->getDouble(indexOfSubField);
     }else
-        value = field->getValue();
-
-    return value.toDouble();
+        return field->getDouble();
 }
@@ -46,6 +46,18 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * @brief The MathFunction enum Math performed on the samples before plotting.
+     */
+    enum MathFunction {
+        MATH_NONE,
+        MATH_BOXCAR_AVERAGE,
+        MATH_STANDARD_DEVIATION,
+        MATH_FFT
+    };
+
+    static MathFunction parseMathFunction(const QString &name);
+
     double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
 
     //Setter functions
@@ -56,7 +68,7 @@ public:
     void setXWindowSize(double val){m_xWindowSize=val;}
     void setScalePower(int val){scalePower = val;}
     void setMeanSamples(int val){meanSamples = val;}
-    void setMathFunction(QString val){mathFunction = val;}
+    void setMathFunction(QString val){mathFunction = val; mathFunctionType = parseMathFunction(val);}
 
     //Getter functions
     double getXMinimum(){return xMinimum;}
@@ -73,6 +85,7 @@ public:
     int getScalePower(){return scalePower;}
     int getMeanSamples(){return meanSamples;}
     QString getMathFunction(){return mathFunction;}
+    MathFunction getMathFunctionType(){return mathFunctionType;}
 
     QVector<double>* getXData(){return xData;}
     QVector<double>* getYData(){return yData;}
@@ -105,9 +118,8 @@ protected:
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
+    MathFunction mathFunctionType;
 
-    double correctionSum;
     int correctionCount;
 
 private:
@@ -10,9 +10,11 @@ HEADERS += scopeplugin.h \
     scopes2d/histogramplotdata.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
+    scopes2d/plotringbuffer.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
     scopes3d/spectrogramscopeconfig.h \
+    scopes3d/spectrumengine.h \
     scopes2d/plotdata2d.h \
     scopes2d/scopes2dconfig.h \
     scopes3d/plotdata3d.h \
@@ -32,6 +34,7 @@ SOURCES += scopeplugin.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
+    scopes3d/spectrumengine.cpp \
     plotdata.cpp
 SOURCES += scopegadgetoptionspage.cpp
 SOURCES += scopegadgetconfiguration.cpp
@@ -87,6 +87,10 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     options_page->cmbColorMapSpectrogram->addItem("Standard", ColorMap::STANDARD);
     options_page->cmbColorMapSpectrogram->addItem("Jet", ColorMap::JET);
 
+    // Populate FFT window combobox.
+    options_page->cmbWindowFunctionSpectrogram->addItem("Hann", SpectrumEngine::WINDOW_HANN);
+    options_page->cmbWindowFunctionSpectrogram->addItem("Blackman-Harris", SpectrumEngine::WINDOW_BLACKMAN_HARRIS);
+
     // Fills the combo boxes for the UAVObjects
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -0,0 +1,256 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotringbuffer.h
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Circular sample storage and decimation for the scatterplot curves
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PLOTRINGBUFFER_H
+#define PLOTRINGBUFFER_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QVector>
+#include <math.h>
+
+
+/**
+ * @brief The PlotRingBuffer class Circular buffer of samples. Appending
+ * and removing the oldest sample are O(1). The buffer doubles its
+ * capacity when an append finds it full, so callers that evict old
+ * samples themselves never pay for a reallocation after warm-up.
+ */
+template <typename T>
+class PlotRingBuffer
+{
+public:
+    explicit PlotRingBuffer(int capacity = 0) : head(0), count(0) { buffer.resize(capacity); }
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    const T &at(int i) const { return buffer.at(indexOf(i)); }
+    const T &first() const { return at(0); }
+    const T &last() const { return at(count - 1); }
+    T &first() { return buffer[indexOf(0)]; }
+    T &last() { return buffer[indexOf(count - 1)]; }
+
+    void append(const T &value)
+    {
+        if (count == buffer.size())
+            grow();
+
+        buffer[indexOf(count)] = value;
+        count++;
+    }
+
+    void removeFirst()
+    {
+        if (count == 0)
+            return;
+        if (++head == buffer.size())
+            head = 0;
+        count--;
+    }
+
+    void clear() { head = 0; count = 0; }
+
+private:
+    int indexOf(int i) const
+    {
+        int index = head + i;
+        if (index >= buffer.size())
+            index -= buffer.size();
+        return index;
+    }
+
+    void grow()
+    {
+        QVector<T> larger(qMax(16, buffer.size() * 2));
+        for (int i = 0; i < count; i++)
+            larger[i] = at(i);
+        buffer.swap(larger);
+        head = 0;
+    }
+
+    QVector<T> buffer;
+    int head;
+    int count;
+};
+
+
+/**
+ * @brief The PlotDecimator class Level of detail stage for long curves. Samples
+ * are grouped into buckets one pixel column wide, and each bucket only keeps
+ * its first, minimum, maximum and last sample. The buckets are updated as
+ * samples arrive and leave, so a repaint never needs more than four points
+ * per pixel column regardless of how many samples the window holds.
+ *
+ * Buckets are keyed on absolute x values so they stay valid while the window
+ * scrolls. The minimum and maximum of the oldest bucket can outlive the
+ * samples they came from by at most one column.
+ */
+class PlotDecimator
+{
+public:
+    PlotDecimator() : bucketWidth(0), pointsValid(false) {}
+
+    bool isEnabled() const { return bucketWidth > 0; }
+    double getBucketWidth() const { return bucketWidth; }
+
+    //! Sets the bucket width in x units, 0 disables decimation. Drops all buckets.
+    void setBucketWidth(double width) { bucketWidth = width; clear(); }
+
+    void clear() { buckets.clear(); pointsValid = false; }
+
+    void append(double x, double y)
+    {
+        qint64 key = (qint64) floor(x / bucketWidth);
+        QPointF point(x, y);
+
+        pointsValid = false;
+        if (buckets.isEmpty() || buckets.last().key != key) {
+            Bucket bucket = { key, 1, point, point, point, point };
+            buckets.append(bucket);
+            return;
+        }
+
+        Bucket &bucket = buckets.last();
+        bucket.count++;
+        bucket.last = point;
+        if (y < bucket.min.y())
+            bucket.min = point;
+        if (y > bucket.max.y())
+            bucket.max = point;
+    }
+
+    //! Drops the oldest sample, newFirst is the oldest sample still stored
+    void removeFirst(const QPointF &newFirst)
+    {
+        if (buckets.isEmpty())
+            return;
+
+        pointsValid = false;
+        if (--buckets.first().count == 0)
+            buckets.removeFirst();
+        else
+            buckets.first().first = newFirst;
+    }
+
+    /**
+     * Returns the decimated curve. The x values are shifted by -xOffset.
+     * Only rebuilt when samples changed, O(number of buckets).
+     */
+    const QVector<QPointF> &getPoints(double xOffset)
+    {
+        if (pointsValid && xOffset == pointsOffset)
+            return points;
+
+        points.resize(0);
+        for (int i = 0; i < buckets.size(); i++) {
+            const Bucket &bucket = buckets.at(i);
+
+            points.append(bucket.first);
+            if (bucket.count > 1) {
+                if (bucket.min.x() < bucket.max.x()) {
+                    points.append(bucket.min);
+                    points.append(bucket.max);
+                } else {
+                    points.append(bucket.max);
+                    points.append(bucket.min);
+                }
+                points.append(bucket.last);
+            }
+        }
+
+        if (xOffset != 0) {
+            for (int i = 0; i < points.size(); i++)
+                points[i].rx() -= xOffset;
+        }
+
+        pointsOffset = xOffset;
+        pointsValid = true;
+        return points;
+    }
+
+private:
+    typedef struct {
+        qint64 key;
+        int count;
+        QPointF first;
+        QPointF last;
+        QPointF min;
+        QPointF max;
+    } Bucket;
+
+    double bucketWidth;
+    PlotRingBuffer<Bucket> buckets;
+
+    QVector<QPointF> points;
+    double pointsOffset;
+    bool pointsValid;
+};
+
+
+/**
+ * @brief The PlotRingBufferData class Hands a pair of ring buffers to a
+ * QwtPlotCurve without copying. When no x buffer is given the sample
+ * index is used as the x value. A decimated point set can be swapped
+ * in when there are more samples than the plot can show.
+ */
+class PlotRingBufferData : public QwtSeriesData<QPointF>
+{
+public:
+    PlotRingBufferData(const PlotRingBuffer<double> *xData, const PlotRingBuffer<double> *yData) :
+        xData(xData), yData(yData), decimated(0) {}
+
+    virtual size_t size() const { return decimated ? decimated->size() : yData->size(); }
+
+    virtual QPointF sample(size_t i) const
+    {
+        if (decimated)
+            return decimated->at(i);
+        return QPointF(xData ? xData->at(i) : (double) i, yData->at(i));
+    }
+
+    virtual QRectF boundingRect() const
+    {
+        if (d_boundingRect.width() < 0.0)
+            d_boundingRect = qwtBoundingRect(*this);
+        return d_boundingRect;
+    }
+
+    //! Plot these points instead of the raw samples, NULL to plot all samples
+    void setDecimated(const QVector<QPointF> *points) { decimated = points; }
+
+    //! Must be called whenever the underlying buffers change
+    void invalidate() { d_boundingRect = QRectF(0.0, 0.0, -1.0, -1.0); }
+
+private:
+    const PlotRingBuffer<double> *xData;
+    const PlotRingBuffer<double> *yData;
+    const QVector<QPointF> *decimated;
+};
+
+#endif // PLOTRINGBUFFER_H
@@ -38,6 +38,181 @@
 #include "qwt/src/qwt_plot.h"
 #include "qwt/src/qwt_plot_curve.h"
 
+//Curves are decimated once they hold more than this many samples per pixel column
+#define DECIMATION_SAMPLES_PER_COLUMN 4
+
+
+/**
+ * @brief ScatterplotData::ScatterplotData Default scatterplot constructor
+ * @param uavObject The plotted UAVO name
+ * @param uavField The plotted UAVO field name
+ */
+ScatterplotData::ScatterplotData(QString uavObject, QString uavField):
+    Plot2dData(uavObject, uavField),
+    curve(0),
+    curveData(0),
+    indexedX(false),
+    totalSamples(0),
+    historyMean(0),
+    historyM2(0)
+{
+}
+
+
+/**
+ * @brief ScatterplotData::setCurve Attach the sample buffers to the curve. The
+ * curve reads straight from the ring buffers, nothing is copied on replot.
+ * @param val Curve that plots this data
+ */
+void ScatterplotData::setCurve(QwtPlotCurve *val)
+{
+    curve = val;
+    curveData = new PlotRingBufferData(indexedX ? NULL : &xSamples, &ySamples);
+    curve->setData(curveData);
+}
+
+
+/**
+ * @brief ScatterplotData::appendSample Store a new sample
+ * @param x Sample x value, ignored when plotting against the sample index
+ * @param y Sample y value
+ */
+void ScatterplotData::appendSample(double x, double y)
+{
+    if (indexedX)
+        x = totalSamples;
+    else
+        xSamples.append(x);
+    ySamples.append(y);
+    totalSamples++;
+
+    if (decimator.isEnabled())
+        decimator.append(x, y);
+}
+
+
+/**
+ * @brief ScatterplotData::removeOldestSample Drop the oldest stored sample
+ */
+void ScatterplotData::removeOldestSample()
+{
+    ySamples.removeFirst();
+    if (!indexedX)
+        xSamples.removeFirst();
+
+    if (ySamples.isEmpty())
+        decimator.clear();
+    else if (decimator.isEnabled())
+        decimator.removeFirst(QPointF(sampleX(0), ySamples.first()));
+}
+
+
+/**
+ * @brief ScatterplotData::sampleX The x value of a stored sample. For indexed
+ * plots this is the absolute sample number, which does not change as the
+ * window scrolls.
+ * @param i Index into the stored samples
+ */
+double ScatterplotData::sampleX(int i)
+{
+    if (indexedX)
+        return totalSamples - ySamples.size() + i;
+    return xSamples.at(i);
+}
+
+
+/**
+ * @brief ScatterplotData::updateCurve Tell the curve its samples have changed.
+ * When the window holds many more samples than there are pixel columns the
+ * curve is handed the decimated points instead of every sample.
+ * @param canvasWidth Width of the plot canvas in pixels
+ */
+void ScatterplotData::updateCurve(int canvasWidth)
+{
+    double bucketWidth = canvasWidth > 0 ? getXWindowSize() / canvasWidth : 0;
+
+    if (bucketWidth > 0 && ySamples.size() > DECIMATION_SAMPLES_PER_COLUMN * canvasWidth) {
+        //Rebuild the buckets when the plot was resized or the window changed
+        if (bucketWidth != decimator.getBucketWidth()) {
+            decimator.setBucketWidth(bucketWidth);
+            for (int i = 0; i < ySamples.size(); i++)
+                decimator.append(sampleX(i), ySamples.at(i));
+        }
+
+        double xOffset = indexedX ? sampleX(0) : 0;
+        curveData->setDecimated(&decimator.getPoints(xOffset));
+    } else {
+        curveData->setDecimated(NULL);
+    }
+
+    curveData->invalidate();
+    curve->itemChanged();
+}
+
+
+/**
+ * @brief ScatterplotData::applyMathFunction Apply the configured math function
+ * to a new sample. The mean and variance over the last meanSamples values are
+ * updated in O(1) with Welford's method.
+ * @param currentValue New sample
+ * @return Value to plot
+ */
+double ScatterplotData::applyMathFunction(double currentValue)
+{
+    if (mathFunctionType != MATH_BOXCAR_AVERAGE && mathFunctionType != MATH_STANDARD_DEVIATION)
+        return currentValue;
+
+    int windowSize = qMax(1u, meanSamples);
+
+    //Remove the oldest value from the window...
+    if (yHistory.size() >= windowSize) {
+        double oldestValue = yHistory.first();
+        yHistory.removeFirst();
+
+        int n = yHistory.size();
+        if (n == 0) {
+            historyMean = 0;
+            historyM2 = 0;
+        } else {
+            double delta = oldestValue - historyMean;
+            historyMean -= delta / n;
+            historyM2 -= delta * (oldestValue - historyMean);
+        }
+    }
+
+    //...and add the new one
+    yHistory.append(currentValue);
+    int n = yHistory.size();
+    double delta = currentValue - historyMean;
+    historyMean += delta / n;
+    historyM2 += delta * (currentValue - historyMean);
+
+    // make sure to recompute the statistics every meanSamples steps to prevent them
+    // from running away due to floating point rounding errors
+    if (++correctionCount >= windowSize) {
+        double sum = 0;
+        for (int i = 0; i < n; i++)
+            sum += yHistory.at(i);
+        historyMean = sum / n;
+
+        historyM2 = 0;
+        for (int i = 0; i < n; i++) {
+            double deviation = yHistory.at(i) - historyMean;
+            historyM2 += deviation * deviation;
+        }
+        correctionCount = 0;
+    }
+
+    if (mathFunctionType == MATH_STANDARD_DEVIATION) {
+        //Sample standard deviation, with Bessel's correction
+        if (n < 2)
+            return 0;
+        return sqrt(qMax(0.0, historyM2 / (n - 1)));
+    }
+
+    return historyMean;
+}
+
 
 /**
  * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
@@ -51,7 +226,7 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 
     //Plot new data
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        updateCurve(scopeGadgetWidget->canvas()->width());
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -73,7 +248,7 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 
     //Plot new data
     if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+        updateCurve(scopeGadgetWidget->canvas()->width());
 }
 
 
@@ -94,48 +269,11 @@ bool SeriesPlotData::append(UAVObject* obj)
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
             //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+            appendSample(0, applyMathFunction(currentValue));
+
+            //If new data overflows the window, remove old data
+            if (ySamples.size() > getXWindowSize())
+                removeOldestSample();
 
             return true;
         }
@@ -161,45 +299,8 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
             double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
             //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
             double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+            appendSample(valueX, applyMathFunction(currentValue));
 
             //Remove stale data
             removeStaleData();
@@ -217,22 +318,8 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
-
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    while (!xSamples.isEmpty() && xSamples.last() - xSamples.first() > getXWindowSize())
+        removeOldestSample();
 }
 
 
@@ -262,6 +349,12 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    ySamples.clear();
+    xSamples.clear();
+    decimator.clear();
+    totalSamples = 0;
+    yHistory.clear();
+    historyMean = 0;
+    historyM2 = 0;
+    correctionCount = 0;
 }
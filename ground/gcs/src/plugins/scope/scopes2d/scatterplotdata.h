@@ -29,6 +29,7 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/plotringbuffer.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -44,17 +45,35 @@ class ScatterplotData : public Plot2dData
 {
     Q_OBJECT
 public:
-    ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
+    ScatterplotData(QString uavObject, QString uavField);
     ~ScatterplotData(){}
 
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    void setCurve(QwtPlotCurve *val);
 
 protected:
+    double applyMathFunction(double currentValue);
+    void appendSample(double x, double y);
+    void removeOldestSample();
+    double sampleX(int i);
+    void updateCurve(int canvasWidth);
+
     QwtPlotCurve* curve;
+    PlotRingBufferData* curveData; //Owned by the curve
+
+    PlotRingBuffer<double> xSamples;
+    PlotRingBuffer<double> ySamples;
+    bool indexedX; //Plot against the sample index instead of xSamples
+    qint64 totalSamples;
+
+    PlotDecimator decimator;
+
+    //Sliding window statistics for the math functions
+    PlotRingBuffer<double> yHistory;
+    double historyMean;
+    double historyM2;
 };
 
 
@@ -68,7 +87,7 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField) {indexedX = true;}
     ~SeriesPlotData() {}
 
     /*!
@@ -46,10 +46,6 @@ public:
     Plot3dData(QString uavObject, QString uavField);
     ~Plot3dData();
 
-    QVector<double>* zData;
-    QVector<double>* zDataHistory;
-    QVector<double>* timeDataHistory;
-
     void setZMinimum(double val){zMinimum=val;}
     void setZMaximum(double val){zMaximum=val;}
 
@@ -27,6 +27,7 @@
 
 #include <QDebug>
 #include <math.h>
+#include <string.h>
 
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
@@ -36,12 +37,148 @@
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_color_map.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 
-#define PI 3.1415926535897932384626433832795
+/**
+ * @brief SpectrogramRasterData::SpectrogramRasterData Empty raster
+ */
+SpectrogramRasterData::SpectrogramRasterData() :
+    columns(0),
+    capacity(0),
+    head(0),
+    rows(0)
+{
+}
+
+
+/**
+ * @brief SpectrogramRasterData::setColumns Change the row width, dropping all rows
+ * @param columns Number of values in a row
+ */
+void SpectrogramRasterData::setColumns(int columns)
+{
+    this->columns = columns;
+    cells.resize(capacity * columns);
+    clear();
+}
+
+
+int SpectrogramRasterData::slotOf(int row) const
+{
+    int slot = head + row;
+    if (slot >= capacity)
+        slot -= capacity;
+    return slot;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::grow Double the row capacity. Only happens
+ * while the time horizon fills up.
+ */
+void SpectrogramRasterData::grow()
+{
+    int newCapacity = qMax(16, capacity * 2);
+    QVector<float> newCells(newCapacity * columns);
+    QVector<double> newTimestamps(newCapacity);
+
+    for (int i = 0; i < rows; i++) {
+        int slot = slotOf(i);
+        memcpy(newCells.data() + i * columns, cells.constData() + slot * columns, columns * sizeof(float));
+        newTimestamps[i] = timestamps.at(slot);
+    }
+
+    cells.swap(newCells);
+    timestamps.swap(newTimestamps);
+    capacity = newCapacity;
+    head = 0;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::appendRow Add a row at the top of the raster
+ * @param values getColumns() values, NULL for a row of zeros
+ * @param timestamp Time of the row
+ */
+void SpectrogramRasterData::appendRow(const float *values, double timestamp)
+{
+    if (rows == capacity)
+        grow();
+
+    int slot = slotOf(rows);
+    float *row = cells.data() + slot * columns;
+    if (values)
+        memcpy(row, values, columns * sizeof(float));
+    else
+        memset(row, 0, columns * sizeof(float));
+    timestamps[slot] = timestamp;
+    rows++;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::removeRowsBefore Drop the rows older than a given time
+ * @param timestamp Oldest time kept
+ */
+void SpectrogramRasterData::removeRowsBefore(double timestamp)
+{
+    while (rows > 0 && timestamps.at(head) < timestamp) {
+        if (++head == capacity)
+            head = 0;
+        rows--;
+    }
+}
+
+
+void SpectrogramRasterData::clear()
+{
+    head = 0;
+    rows = 0;
+}
+
+
+/**
+ * @brief SpectrogramRasterData::value Nearest neighbour lookup, the rows are
+ * spread over the y interval and the columns over the x interval
+ */
+double SpectrogramRasterData::value(double x, double y) const
+{
+    if (rows == 0 || columns == 0)
+        return 0;
+
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+
+    int column = (int) ((x - xInterval.minValue()) / xInterval.width() * columns);
+    int row = (int) ((y - yInterval.minValue()) / yInterval.width() * rows);
+
+    column = qBound(0, column, columns - 1);
+    row = qBound(0, row, rows - 1);
+
+    return cells.at(slotOf(row) * columns + column);
+}
+
+
+/**
+ * @brief SpectrogramRasterData::pixelHint One cell, so the spectrogram does
+ * not render at a finer resolution than the data has
+ */
+QRectF SpectrogramRasterData::pixelHint(const QRectF &area) const
+{
+    Q_UNUSED(area);
+
+    if (rows == 0 || columns == 0)
+        return QRectF();
+
+    const QwtInterval xInterval = interval(Qt::XAxis);
+    const QwtInterval yInterval = interval(Qt::YAxis);
+
+    return QRectF(xInterval.minValue(), yInterval.minValue(),
+                  xInterval.width() / columns, yInterval.width() / rows);
+}
+
 
 /**
  * @brief SpectrogramData
@@ -55,27 +192,37 @@ SpectrogramData::SpectrogramData(QString uavObject, QString uavField, double sam
         : Plot3dData(uavObject, uavField),
           spectrogram(0),
           rasterData(0),
-          fft_object(0)
+          objManager(0),
+          windowFunction(SpectrumEngine::WINDOW_HANN),
+          spectrumAverages(1),
+          spectrumOverlap(false),
+          dataFieldIndex(-1),
+          scaleFieldIndex(-1),
+          indexFieldIndex(-1),
+          samplesFieldIndex(-1)
 {
     this->samplingFrequency = samplingFrequency;
     this->timeHorizon = timeHorizon;
     autoscaleValueUpdated = 0;
 
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    Q_ASSERT(pm != NULL);
+    objManager = pm->getObject<UAVObjectManager>();
+    Q_ASSERT(objManager != NULL);
+
     // Create raster data
-    rasterData = new QwtMatrixRasterData();
-    
-    if(mathFunction == "FFT") {
-        fft_object = new ffft::FFTReal<double>(windowWidth);
+    rasterData = new SpectrogramRasterData();
+
+    if(mathFunctionType == MATH_FFT) {
         windowWidth /= 2;
     }
 
     this->windowWidth = windowWidth;
 
-    rasterData->setValueMatrix( *zDataHistory, windowWidth );
+    resetRaster();
 
     // Set the ranges for the plot
     resetAxisRanges();
-    plotData.clear();
     lastInstanceIndex = -1; // To keep track of missing instances. We assume communications keep packet order
 }
 
@@ -100,6 +247,20 @@ void SpectrogramData::setZMaximum(double val)
     resetAxisRanges();
 }
 
+/**
+ * @brief SpectrogramData::resetRaster Start over with a blank time horizon,
+ * one row per second, so that the raster scrolls in as data arrives
+ */
+void SpectrogramData::resetRaster()
+{
+    rasterData->setColumns(windowWidth);
+
+    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
+    double now = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+    for (int i = (int) timeHorizon - 1; i >= 0; i--)
+        rasterData->appendRow(NULL, now - i);
+}
+
 void SpectrogramData::resetAxisRanges()
 {
     rasterData->setInterval( Qt::XAxis, QwtInterval(xMinimum, xMaximum));
@@ -108,6 +269,24 @@ void SpectrogramData::resetAxisRanges()
 }
 
 
+/**
+ * @brief SpectrogramData::setSpectrumOptions Configure the FFT math function
+ * @param window Window function applied before the transform
+ * @param averages Number of spectra averaged into each row
+ * @param overlap Also transform the half overlapping segment between two windows
+ */
+void SpectrogramData::setSpectrumOptions(SpectrumEngine::WindowFunction window, int averages, bool overlap)
+{
+    windowFunction = window;
+    spectrumAverages = averages;
+    spectrumOverlap = overlap;
+
+    // A running engine is reconfigured now, otherwise it is set up on the first window
+    if (spectrumEngine.getLength() > 0)
+        spectrumEngine.configure(spectrumEngine.getLength(), windowFunction, spectrumAverages, spectrumOverlap);
+}
+
+
 /**
  * @brief SpectrogramScopeConfig::plotNewData Update plot with new data
  * @param scopeGadgetWidget
@@ -120,8 +299,9 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 
     // Check for new data
     if (readAndResetUpdatedFlag() == true){
-        // Plot new data
-        rasterData->setValueMatrix(*zDataHistory, windowWidth);
+        // The raster reads straight from the row buffer, only the cached image needs refreshing
+        spectrogram->invalidateCache();
+        spectrogram->itemChanged();
 
         // Check autoscale. (For some reason, QwtSpectrogram doesn't support autoscale)
         if (zMaximum == 0){
@@ -135,6 +315,34 @@ void SpectrogramData::plotNewData(PlotData *plot3dData, ScopeConfig *scopeConfig
 }
 
 
+/**
+ * @brief SpectrogramData::resolveFields Find the data field and the optional
+ * scale, index and samples fields. All instances share the same layout, so
+ * this is only done once.
+ * @param obj Any instance of the plotted UAVO
+ * @return true if the data field exists
+ */
+bool SpectrogramData::resolveFields(UAVObject *obj)
+{
+    QList<UAVObjectField*> fieldList = obj->getFields();
+
+    for (int i = 0; i < fieldList.size(); i++) {
+        UAVObjectField *field = fieldList.at(i);
+
+        if (field->getName() == uavFieldName)
+            dataFieldIndex = i;
+        else if (field->getType() == UAVObjectField::FLOAT32 && field->getName() == "scale")
+            scaleFieldIndex = i;
+        else if (field->getType() == UAVObjectField::INT16 && field->getName() == "index")
+            indexFieldIndex = i;
+        else if (field->getType() == UAVObjectField::INT16 && field->getName() == "samples")
+            samplesFieldIndex = i;
+    }
+
+    return dataFieldIndex >= 0;
+}
+
+
 /**
  * @brief SpectrogramData::append Appends data to spectrogram
  * @param obj UAVO with new data
@@ -145,182 +353,130 @@ bool SpectrogramData::append(UAVObject* multiObj)
     QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
 
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    if (uavObjectName != multiObj->getName())
+        return false;
 
-        // Only run on UAVOs that have multiple instances
-        if (multiObj->isSingleInstance()) {
-            return false;
-        }
+    // Only run on UAVOs that have multiple instances
+    if (multiObj->isSingleInstance())
+        return false;
 
-        //Instantiate object manager
-        UAVObjectManager *objManager;
+    if (dataFieldIndex < 0 && !resolveFields(multiObj))
+        return false;
 
-        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-        Q_ASSERT(pm != NULL);
-        objManager = pm->getObject<UAVObjectManager>();
-        Q_ASSERT(objManager != NULL);
+    // Get list of object instances
+    const QVector<UAVObject*> &list = objManager->getObjectInstancesVector(multiObj->getObjID());
+    if (list.isEmpty())
+        return false;
 
+    QList<UAVObjectField*> multiFields = multiObj->getFields();
+    uint16_t newWindowWidth = list.size() * multiFields.at(dataFieldIndex)->getNumElements();
 
-        // Get list of object instances
-        QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
+    /* Check if the instance has a samples field as this will override the windowWidth
+    *  Field can be used in objects that have dynamic size
+    *  like the case of the Vibration Analysis modeule
+    */
+    if (samplesFieldIndex >= 0)
+        newWindowWidth = multiFields.at(samplesFieldIndex)->getDouble();
 
-        uint16_t newWindowWidth = list.size() * list.front()->getField(uavFieldName)->getNumElements();
+    uint16_t valuesToProcess = newWindowWidth; // Store the number of samples expected
 
-        /* Check if the instance has a samples field as this will override the windowWidth
-        *  Field can be used in objects that have dynamic size 
-        *  like the case of the Vibration Analysis modeule
-        */
-        QList<UAVObjectField*> fieldList = multiObj->getFields();
-        foreach (UAVObjectField* field, fieldList) {
-            if (field->getType() == UAVObjectField::INT16 && field->getName() == "samples") {
-                newWindowWidth = field->getValue().toDouble();
-                break;
-            }
-        }
-
-        uint16_t valuesToProcess = newWindowWidth; // Store the number of samples expected
-
-        // Can happen when changing the FFTP Window Width
-        if (mathFunction == "FFT") {
-            if (! ((valuesToProcess != 0) && ((valuesToProcess & (valuesToProcess - 1)) == 0))) {
-                return false;
-            }
-            newWindowWidth /= 2; // FFT Output is half
+    // Can happen when changing the FFTP Window Width
+    if (mathFunctionType == MATH_FFT) {
+        if (! ((valuesToProcess != 0) && ((valuesToProcess & (valuesToProcess - 1)) == 0))) {
+            return false;
         }
+        newWindowWidth /= 2; // FFT Output is half
+    }
 
-        // Check that there is a full window worth of data. While GCS is starting up, the size of
-        // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
-        // the flight controller board has had time to initialize the UAVO size.
-
-        if (newWindowWidth != windowWidth) {
-            windowWidth = newWindowWidth;
-            clearPlots();
+    // Check that there is a full window worth of data. While GCS is starting up, the size of
+    // multiple instance UAVOs is 1, so it's possible for spurious data to come in before
+    // the flight controller board has had time to initialize the UAVO size.
 
-            plotData.clear();
-            rasterData->setValueMatrix(*zDataHistory, windowWidth);
+    if (newWindowWidth != windowWidth) {
+        windowWidth = newWindowWidth;
+        clearPlots();
 
-            qDebug() << "Spectrogram width adjusted to " << windowWidth;
-        }
+        qDebug() << "Spectrogram width adjusted to " << windowWidth;
+    }
 
-        UAVObjectField* multiField = multiObj->getField(uavFieldName);
-        Q_ASSERT(multiField);
-        if (multiField ) {
-
-            // Get the field of interest
-            foreach (UAVObject *obj, list) {
-                UAVObjectField* field = obj->getField(uavFieldName);
-                int numElements = field->getNumElements();
-
-                double scale = 1;
-                QList<UAVObjectField*> fieldList = obj->getFields();
-                foreach (UAVObjectField* field, fieldList) {
-                    // Check if the instance has a scale field
-                    if(field->getType() == UAVObjectField::FLOAT32 && field->getName() == "scale"){
-                        scale = field->getValue().toDouble();
-                        break;
-                    }
-
-                    // Check if data is ordered. If not, just discard everything
-                    if (field->getType() == UAVObjectField::INT16 && field->getName() == "index") {
-                        int currentIndex = field->getValue().toDouble();
-                        if (currentIndex != (lastInstanceIndex + 1)) {
-                            fprintf(stderr, "Out of order index. Got %d expected %d\n", currentIndex, lastInstanceIndex + 1);
-                            plotData.clear();
-                            lastInstanceIndex = -1; // Next index will be 0
-                            return false;
-                        }
-
-                        lastInstanceIndex++;
-                    }
-                }
-
-                for (int i = 0; i < numElements; i++) {
-                    double currentValue = field->getValue(i).toDouble() / scale;  // Get the value and scale it
-
-                    //Normally some math would go here, modifying currentValue before appending it to values
-                    // .
-                    // .
-                    // .
-
-                    // Last step, assign value to vector
-                    plotData += currentValue;
-                }
-
-                // Check if we got enough values
-                // The object instance can temporarily have more values than required
-                if (plotData.size() == valuesToProcess ) {
-                    break;
-                }
-            }
+    // Check if the spectrum engine was already set up or needs to be updated
+    // May happen if settings change after the spectrogram was created
+    float *values;
+    if (mathFunctionType == MATH_FFT) {
+        if (spectrumEngine.getLength() != valuesToProcess)
+            spectrumEngine.configure(valuesToProcess, windowFunction, spectrumAverages, spectrumOverlap);
+        values = spectrumEngine.getInput();
+    } else {
+        plotData.resize(valuesToProcess);
+        values = plotData.data();
+    }
 
-            // If some instances are still missing
-            if (plotData.size() != valuesToProcess) {
+    // Get the field of interest
+    int valueCount = 0;
+    foreach (UAVObject *obj, list) {
+        QList<UAVObjectField*> fieldList = obj->getFields();
+        UAVObjectField* field = fieldList.at(dataFieldIndex);
+        int numElements = field->getNumElements();
+
+        // Check if the instance has a scale field
+        double scale = 1;
+        if (scaleFieldIndex >= 0)
+            scale = fieldList.at(scaleFieldIndex)->getDouble();
+
+        // Check if data is ordered. If not, just discard everything
+        if (indexFieldIndex >= 0) {
+            int currentIndex = fieldList.at(indexFieldIndex)->getDouble();
+            if (currentIndex != (lastInstanceIndex + 1)) {
+                fprintf(stderr, "Out of order index. Got %d expected %d\n", currentIndex, lastInstanceIndex + 1);
+                lastInstanceIndex = -1; // Next index will be 0
                 return false;
             }
 
-            // Check if the FFT needs to be calculated
-            // Because this function is optional we will calculate the FFT and then
-            // update the original vector. This will allow using the same code
-            // to display the information.
-            if (mathFunction == "FFT") {
-
-                // Check if the fft_object was already created or needs to be updated
-                // May happen if settings change after the spectrogram was created
-                if (fft_object == NULL || fft_object->get_length() != valuesToProcess) {
-                    if (fft_object != NULL)
-                        delete fft_object;
-
-                    fft_object = new ffft::FFTReal<double>(valuesToProcess);
-                }
-
-                // Hanning Window
-                for (int i = 0; i < valuesToProcess; i++) {
-                    plotData[i] *= pow(sin(PI*i/(valuesToProcess - 1) ), 2);
-                }
-
-                QVector<double> fftout(valuesToProcess);
-
-                fft_object->do_fft(&fftout[0], plotData.data()); // Do FFT
-                plotData.clear();  // Clear vector
-
-                // Lets get the magnitude and scale it.
-                // mag = X * sqrt(re^2 + im^2)/n
-                // X (4.2) is chosen so that the magnitude presented is similar to the acceleration registered
-                // although this is not 100% correct, it helps users understanding the spectrogram.
-                for (unsigned int i = 0; i < valuesToProcess/2; i++) {
-                    plotData << 4.2*sqrt(pow(fftout[i], 2) + pow(fftout[valuesToProcess/2 + i], 2)) / valuesToProcess;
-                }
-            }
-            
-            // Apply autoscale if enabled
-            if (zMaximum == 0) {
-				for (unsigned int i = 0; i < windowWidth; i++) {
-	                 // See if autoscale is turned on and if the value exceeds the maximum for the scope.
-	                if (plotData[i] > rasterData->interval(Qt::ZAxis).maxValue()){
-	                    // Change scope maximum and color depth
-	                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, plotData[i]) );
-	                    autoscaleValueUpdated = plotData[i];
-                	}
-            	}
+            lastInstanceIndex++;
+        }
 
+        // The object instance can temporarily have more values than required
+        for (int i = 0; i < numElements && valueCount < valuesToProcess; i++)
+            values[valueCount++] = field->getDouble(i) / scale;  // Get the value and scale it
 
-            }
+        // Check if we got enough values
+        if (valueCount == valuesToProcess)
+            break;
+    }
 
-            timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon) {
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
+    lastInstanceIndex = -1; // Next index will be 0
+
+    // If some instances are still missing
+    if (valueCount != valuesToProcess)
+        return false;
+
+    // Check if the FFT needs to be calculated
+    // Because this function is optional we will calculate the FFT and then
+    // use its output instead of the original values. This will allow using
+    // the same code to display the information.
+    const float *row = values;
+    if (mathFunctionType == MATH_FFT)
+        row = spectrumEngine.processInput();
+
+    // Apply autoscale if enabled
+    if (zMaximum == 0) {
+        double zMax = rasterData->interval(Qt::ZAxis).maxValue();
+        for (unsigned int i = 0; i < windowWidth; i++) {
+            // See if autoscale is turned on and if the value exceeds the maximum for the scope.
+            if (row[i] > zMax){
+                // Change scope maximum and color depth
+                zMax = row[i];
+                rasterData->setInterval(Qt::ZAxis, QwtInterval(0, zMax) );
+                autoscaleValueUpdated = zMax;
             }
-            
-            *zDataHistory << plotData;
-            plotData.clear();
-            lastInstanceIndex = -1; // Next index will be 0
-
-            return true;
         }
     }
 
-    return false;
+    double timestamp = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+    rasterData->appendRow(row, timestamp);
+    rasterData->removeRowsBefore(timestamp - timeHorizon);
+
+    return true;
 }
 
 
@@ -345,8 +501,8 @@ void SpectrogramData::deletePlots(PlotData *spectrogramData)
  */
 void SpectrogramData::clearPlots()
 {
-    timeDataHistory->clear();
-    zDataHistory->clear();
+    resetRaster();
+    spectrumEngine.reset();
 
     resetAxisRanges();
 }
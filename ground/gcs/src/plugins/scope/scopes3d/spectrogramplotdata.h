@@ -29,15 +29,52 @@
 #define SPECTROGRAMDATA_H
 
 #include "scopes3d/plotdata3d.h"
+#include "scopes3d/spectrumengine.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_spectrogram.h"
-#include "qwt/src/qwt_matrix_raster_data.h"
+#include "qwt/src/qwt_raster_data.h"
 
 #include <QTimer>
 #include <QTime>
 #include <QVector>
 
-#include "ffft/FFTReal.h"
+class UAVObjectManager;
+
+
+/**
+ * @brief The SpectrogramRasterData class Scrolling raster of spectrogram rows.
+ * Rows live in a circular buffer, so adding a row and dropping the oldest
+ * ones never copies the matrix. Row 0 is the oldest and is drawn at the
+ * bottom of the y interval.
+ */
+class SpectrogramRasterData : public QwtRasterData
+{
+public:
+    SpectrogramRasterData();
+
+    void setColumns(int columns);
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+
+    void appendRow(const float *values, double timestamp);
+    void removeRowsBefore(double timestamp);
+    void clear();
+
+    virtual double value(double x, double y) const;
+    virtual QRectF pixelHint(const QRectF &area) const;
+
+private:
+    int slotOf(int row) const;
+    void grow();
+
+    QVector<float> cells;
+    QVector<double> timestamps;
+    int columns;
+    int capacity;
+    int head;
+    int rows;
+};
+
 
 /**
  * @brief The SpectrogramData class The spectrogram plot has a fixed size
@@ -73,23 +110,37 @@ public:
     virtual void setZMaximum(double val);
     void clearPlots();
 
+    void setSpectrumOptions(SpectrumEngine::WindowFunction window, int averages, bool overlap);
 
-    QwtMatrixRasterData *getRasterData(){return rasterData;}
+    QwtRasterData *getRasterData(){return rasterData;}
     void setSpectrogram(QwtPlotSpectrogram *val){spectrogram = val;}
 
 private:
     void resetAxisRanges();
+    void resetRaster();
+    bool resolveFields(UAVObject *obj);
 
     QwtPlotSpectrogram *spectrogram;
-    QwtMatrixRasterData *rasterData;
+    SpectrogramRasterData *rasterData;
+    UAVObjectManager *objManager;
 
     double samplingFrequency;
     double timeHorizon;
     unsigned int windowWidth;
     double autoscaleValueUpdated;
-    ffft::FFTReal <double> *fft_object;
-    QVector<double> plotData;
+
+    SpectrumEngine spectrumEngine;
+    SpectrumEngine::WindowFunction windowFunction;
+    int spectrumAverages;
+    bool spectrumOverlap;
+    QVector<float> plotData;
     int lastInstanceIndex;
+
+    // Positions in the field list, resolved on the first update
+    int dataFieldIndex;
+    int scaleFieldIndex;
+    int indexFieldIndex;
+    int samplesFieldIndex;
 };
 
 #endif // SPECTROGRAMDATA_H
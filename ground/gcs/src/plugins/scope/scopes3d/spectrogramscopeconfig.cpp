@@ -50,6 +50,9 @@ SpectrogramScopeConfig::SpectrogramScopeConfig()
     windowWidth = 64;
     zMaximum = 120;
     colorMapType = ColorMap::STANDARD;
+    windowFunction = SpectrumEngine::WINDOW_HANN;
+    spectrumAverages = 1;
+    spectrumOverlap = false;
 }
 
 
@@ -64,6 +67,9 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(QSettings *qSettings)
     windowWidth       = qSettings->value("windowWidth").toInt();
     zMaximum = qSettings->value("zMaximum").toDouble();
     colorMapType = (ColorMap::ColorMapType) qSettings->value("colorMap").toInt();
+    windowFunction = (SpectrumEngine::WindowFunction) qSettings->value("windowFunction", SpectrumEngine::WINDOW_HANN).toInt();
+    spectrumAverages = qSettings->value("spectrumAverages", 1).toInt();
+    spectrumOverlap = qSettings->value("spectrumOverlap", false).toBool();
 
     int plot3dCurveCount = qSettings->value("dataSourceCount").toInt();
 
@@ -101,6 +107,9 @@ SpectrogramScopeConfig::SpectrogramScopeConfig(Ui::ScopeGadgetOptionsPage *optio
     timeHorizon = options_page->sbSpectrogramTimeHorizon->value();
     zMaximum = options_page->spnMaxSpectrogramZ->value();
     colorMapType = (ColorMap::ColorMapType) options_page->cmbColorMapSpectrogram->itemData(options_page->cmbColorMapSpectrogram->currentIndex()).toInt();
+    windowFunction = (SpectrumEngine::WindowFunction) options_page->cmbWindowFunctionSpectrogram->itemData(options_page->cmbWindowFunctionSpectrogram->currentIndex()).toInt();
+    spectrumAverages = options_page->spnSpectrumAveragesSpectrogram->value();
+    spectrumOverlap = options_page->chkSpectrumOverlapSpectrogram->isChecked();
 
     Plot3dCurveConfiguration* newPlotCurveConfigs = new Plot3dCurveConfiguration();
     newPlotCurveConfigs->uavObjectName = options_page->cmbUAVObjectsSpectrogram->currentText();
@@ -138,6 +147,9 @@ ScopeConfig* SpectrogramScopeConfig::cloneScope(ScopeConfig *originalScope)
 
     cloneObj->timeHorizon = originalSpectrogramScopeConfig->timeHorizon;
     cloneObj->colorMapType = originalSpectrogramScopeConfig->colorMapType;
+    cloneObj->windowFunction = originalSpectrogramScopeConfig->windowFunction;
+    cloneObj->spectrumAverages = originalSpectrogramScopeConfig->spectrumAverages;
+    cloneObj->spectrumOverlap = originalSpectrogramScopeConfig->spectrumOverlap;
 
     int plotCurveCount = originalSpectrogramScopeConfig->m_spectrogramSourceConfigs.size();
 
@@ -178,6 +190,9 @@ void SpectrogramScopeConfig::saveConfiguration(QSettings* qSettings)
     qSettings->setValue("timeHorizon", timeHorizon);
     qSettings->setValue("windowWidth", windowWidth);
     qSettings->setValue("zMaximum",  zMaximum);
+    qSettings->setValue("windowFunction", windowFunction);
+    qSettings->setValue("spectrumAverages", spectrumAverages);
+    qSettings->setValue("spectrumOverlap", spectrumOverlap);
 
     for(int i = 0; i < plot3dCurveCount; i++){
         Plot3dCurveConfiguration *plotCurveConf = m_spectrogramSourceConfigs.at(i);
@@ -230,6 +245,13 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     // Get and store the units
     units = getUavObjectFieldUnits(uavObjectName, uavFieldName);
 
+    // The spectrogram data allocates the initial raster, one row per second
+    if (((double) windowWidth) * timeHorizon >= (double) 10000000.0 * sizeof(float)){ //Don't exceed 10MB for memory
+        qDebug() << "For some reason, we're trying to allocate a gigantic spectrogram. This probably represents a problem in the configuration file. TimeHorizion: "<< timeHorizon << ", windowWidth: "<< windowWidth;
+        Q_ASSERT(0);
+        return;
+    }
+
     SpectrogramData* spectrogramData = new SpectrogramData(uavObjectName, uavFieldName, samplingFrequency, windowWidth, timeHorizon);
     spectrogramData->setXMinimum(0);
     spectrogramData->setXMaximum(samplingFrequency/2);
@@ -239,6 +261,7 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     spectrogramData->setScalePower(spectrogramSourceConfigs->yScalePower);
     spectrogramData->setMeanSamples(spectrogramSourceConfigs->yMeanSamples);
     spectrogramData->setMathFunction(spectrogramSourceConfigs->mathFunction);
+    spectrogramData->setSpectrumOptions(windowFunction, spectrumAverages, spectrumOverlap);
 
     //Generate the waterfall name
     QString waterfallName = (spectrogramData->getUavoName()) + "." + (spectrogramData->getUavoFieldName());
@@ -270,24 +293,6 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
     plotSpectrogram->setRenderHint(QwtPlotItem::RenderAntialiased);
     plotSpectrogram->setColorMap(new ColorMap(colorMapType) );
 
-    // Initial raster data
-
-    QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
-    for ( uint i = 0; i < timeHorizon; i++ ){
-        spectrogramData->timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0 + i);
-    }
-
-    if (((double) windowWidth) * timeHorizon < (double) 10000000.0 * sizeof(spectrogramData->zDataHistory->front())){ //Don't exceed 10MB for memory
-        for ( uint i = 0; i < windowWidth*timeHorizon; i++ ){
-            spectrogramData->zDataHistory->append(0);
-        }
-    }
-    else{
-        qDebug() << "For some reason, we're trying to allocate a gigantic spectrogram. This probably represents a problem in the configuration file. TimeHorizion: "<< timeHorizon << ", windowWidth: "<< windowWidth;
-        Q_ASSERT(0);
-        return;
-    }
-
     //Set up colorbar on right axis
     spectrogramData->rightAxis = scopeGadgetWidget->axisWidget( QwtPlot::yRight );
     spectrogramData->rightAxis->setTitle( "Intensity" );
@@ -328,6 +333,9 @@ void SpectrogramScopeConfig::setGuiConfiguration(Ui::ScopeGadgetOptionsPage *opt
     options_page->sbSpectrogramFrequency->setValue(samplingFrequency);
     options_page->spnMaxSpectrogramZ->setValue(zMaximum);
     options_page->cmbColorMapSpectrogram->setCurrentIndex(options_page->cmbColorMapSpectrogram->findData(colorMapType));
+    options_page->cmbWindowFunctionSpectrogram->setCurrentIndex(options_page->cmbWindowFunctionSpectrogram->findData(windowFunction));
+    options_page->spnSpectrumAveragesSpectrogram->setValue(spectrumAverages);
+    options_page->chkSpectrumOverlapSpectrogram->setChecked(spectrumOverlap);
 
     foreach (Plot3dCurveConfiguration* plot3dData,  m_spectrogramSourceConfigs) {
         int uavoIdx= options_page->cmbUAVObjectsSpectrogram->findText(plot3dData->uavObjectName);
@@ -29,6 +29,7 @@
 #define SPECTROGRAMSCOPECONFIG_H
 
 #include "scopes3d/scopes3dconfig.h"
+#include "scopes3d/spectrumengine.h"
 
 
 /**
@@ -96,6 +97,10 @@ private:
     double zMaximum;
 
     ColorMap::ColorMapType colorMapType;
+
+    SpectrumEngine::WindowFunction windowFunction;
+    int spectrumAverages;
+    bool spectrumOverlap;
 };
 
 #endif // SPECTROGRAMSCOPECONFIG_H
@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumengine.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Windowed, averaged magnitude spectrum for the spectrogram scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtGlobal>
+#include <math.h>
+#include <string.h>
+
+#include "scopes3d/spectrumengine.h"
+
+#define PI 3.1415926535897932384626433832795
+
+// Alignment of the sample buffers, enough for AVX loads
+#define SPECTRUM_BUFFER_ALIGNMENT 32
+
+// Scale chosen so that, with the Hann window, the magnitude is
+// 4.2 * |X| / n as the spectrogram has always shown. 4.2 was picked so that
+// the magnitude is similar to the acceleration registered. Dividing by the
+// window sum instead of n keeps other windows on the same scale.
+#define SPECTRUM_MAGNITUDE_GAIN 2.1f
+
+static float *allocBuffer(int length)
+{
+    float *buffer = (float *) qMallocAligned(length * sizeof(float), SPECTRUM_BUFFER_ALIGNMENT);
+    memset(buffer, 0, length * sizeof(float));
+    return buffer;
+}
+
+SpectrumEngine::SpectrumEngine() :
+    length(0),
+    window(WINDOW_HANN),
+    averages(1),
+    overlap(false),
+    fft(0),
+    input(0),
+    previous(0),
+    windowed(0),
+    fftOut(0),
+    coefficients(0),
+    history(0),
+    powerSum(0),
+    magnitude(0),
+    havePrevious(false),
+    historySlot(0),
+    historyCount(0),
+    magnitudeScale(0)
+{
+}
+
+SpectrumEngine::~SpectrumEngine()
+{
+    release();
+}
+
+void SpectrumEngine::release()
+{
+    delete fft;
+    fft = 0;
+
+    qFreeAligned(input);
+    qFreeAligned(previous);
+    qFreeAligned(windowed);
+    qFreeAligned(fftOut);
+    qFreeAligned(coefficients);
+    qFreeAligned(history);
+    qFreeAligned(powerSum);
+    qFreeAligned(magnitude);
+    input = previous = windowed = fftOut = coefficients = history = powerSum = magnitude = 0;
+}
+
+/**
+ * @brief SpectrumEngine::configure Allocate the buffers and precompute the window
+ * @param length Segment length, must be a power of two
+ * @param window Window function applied to each segment
+ * @param averages Number of segment spectra averaged into each output
+ * @param overlap Add a half overlapping segment between consecutive blocks
+ */
+void SpectrumEngine::configure(int length, WindowFunction window, int averages, bool overlap)
+{
+    Q_ASSERT(length >= 2 && (length & (length - 1)) == 0);
+
+    release();
+
+    this->length = length;
+    this->window = window;
+    this->averages = qMax(1, averages);
+    this->overlap = overlap;
+
+    int bins = getBins();
+
+    fft = new ffft::FFTReal<float>(length);
+    input = allocBuffer(length);
+    previous = allocBuffer(length);
+    windowed = allocBuffer(length);
+    fftOut = allocBuffer(length);
+    coefficients = allocBuffer(length);
+    history = allocBuffer(this->averages * bins);
+    powerSum = allocBuffer(bins);
+    magnitude = allocBuffer(bins);
+
+    double windowSum = 0;
+    for (int i = 0; i < length; i++) {
+        double phase = 2 * PI * i / (length - 1);
+        double w;
+
+        switch (window) {
+        case WINDOW_BLACKMAN_HARRIS:
+            w = 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2 * phase) - 0.01168 * cos(3 * phase);
+            break;
+        case WINDOW_HANN:
+        default:
+            w = pow(sin(PI * i / (length - 1)), 2);
+            break;
+        }
+
+        coefficients[i] = w;
+        windowSum += w;
+    }
+
+    magnitudeScale = SPECTRUM_MAGNITUDE_GAIN / windowSum;
+
+    reset();
+}
+
+/**
+ * @brief SpectrumEngine::reset Forget the averaged history and the previous block
+ */
+void SpectrumEngine::reset()
+{
+    int bins = getBins();
+
+    if (history)
+        memset(history, 0, averages * bins * sizeof(float));
+    if (powerSum)
+        memset(powerSum, 0, bins * sizeof(float));
+
+    havePrevious = false;
+    historySlot = 0;
+    historyCount = 0;
+}
+
+/**
+ * @brief SpectrumEngine::accumulateSegment Window one segment, transform it and
+ * replace the oldest power spectrum in the averaging history with it
+ * @param segment getLength() samples
+ */
+void SpectrumEngine::accumulateSegment(const float *segment)
+{
+    const int bins = getBins();
+    const int half = length / 2;
+
+    for (int i = 0; i < length; i++)
+        windowed[i] = segment[i] * coefficients[i];
+
+    fft->do_fft(fftOut, windowed);
+
+    // Real parts are in [0, n/2], imaginary parts of bins 1..n/2-1 in [n/2 + 1, n)
+    float *power = history + historySlot * bins;
+    power[0] = fftOut[0] * fftOut[0];
+    for (int i = 1; i < bins; i++)
+        power[i] = fftOut[i] * fftOut[i] + fftOut[half + i] * fftOut[half + i];
+
+    if (++historySlot == averages)
+        historySlot = 0;
+    if (historyCount < averages)
+        historyCount++;
+
+    // Sum the history afresh rather than keeping a running sum, which
+    // would drift in single precision. This is a handful of adds per bin.
+    memcpy(powerSum, history, bins * sizeof(float));
+    for (int j = 1; j < historyCount; j++) {
+        const float *p = history + j * bins;
+        for (int i = 0; i < bins; i++)
+            powerSum[i] += p[i];
+    }
+}
+
+/**
+ * @brief SpectrumEngine::processInput Transform the block in getInput()
+ * @return getBins() magnitudes, valid until the next call
+ */
+const float *SpectrumEngine::processInput()
+{
+    const int bins = getBins();
+    const int half = length / 2;
+
+    if (overlap && havePrevious) {
+        // The segment straddling the previous block and this one
+        memcpy(windowed, previous + half, half * sizeof(float));
+        memcpy(windowed + half, input, half * sizeof(float));
+        memcpy(previous, windowed, length * sizeof(float));
+        accumulateSegment(previous);
+    }
+
+    accumulateSegment(input);
+
+    if (overlap) {
+        memcpy(previous, input, length * sizeof(float));
+        havePrevious = true;
+    }
+
+    const float scale = magnitudeScale;
+    const float count = historyCount;
+    for (int i = 0; i < bins; i++)
+        magnitude[i] = scale * sqrtf(powerSum[i] / count);
+
+    return magnitude;
+}
@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumengine.h
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Windowed, averaged magnitude spectrum for the spectrogram scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUMENGINE_H
+#define SPECTRUMENGINE_H
+
+#include "ffft/FFTReal.h"
+
+/**
+ * @brief The SpectrumEngine class Turns blocks of samples into magnitude
+ * spectra. All buffers are allocated, aligned, when the engine is
+ * configured and reused for every block, so the per-block cost is the
+ * FFT plus a few straight float loops.
+ *
+ * Consecutive spectra can be averaged (Welch's method) and, with overlap
+ * enabled, an extra segment straddling two consecutive blocks is added
+ * so that samples at the window edges are not lost to the taper.
+ */
+class SpectrumEngine
+{
+public:
+    /**
+     * @brief The WindowFunction enum Taper applied to each segment.
+     */
+    enum WindowFunction {
+        WINDOW_HANN,
+        WINDOW_BLACKMAN_HARRIS
+    };
+
+    SpectrumEngine();
+    ~SpectrumEngine();
+
+    void configure(int length, WindowFunction window, int averages, bool overlap);
+    void reset();
+
+    int getLength() const { return length; }
+    int getBins() const { return length / 2; }
+    WindowFunction getWindowFunction() const { return window; }
+    int getAverages() const { return averages; }
+    bool getOverlap() const { return overlap; }
+
+    //! Buffer the caller fills with getLength() samples before calling processInput()
+    float *getInput() { return input; }
+    const float *processInput();
+
+private:
+    void release();
+    void accumulateSegment(const float *segment);
+
+    int length;
+    WindowFunction window;
+    int averages;
+    bool overlap;
+
+    ffft::FFTReal<float> *fft;
+
+    float *input;
+    float *previous;     // Last block, for the overlapping segment
+    float *windowed;
+    float *fftOut;
+    float *coefficients; // Window function
+    float *history;      // Power of the last `averages` segments
+    float *powerSum;     // Sum over history
+    float *magnitude;    // Output
+
+    bool havePrevious;
+    int historySlot;
+    int historyCount;
+    float magnitudeScale;
+};
+
+#endif // SPECTRUMENGINE_H
@@ -92,6 +92,8 @@ void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
+    m_model->setExpanded(item, true);
+
     //Check if current tree index is the child of the top tree item
     if (top)
     {
@@ -152,6 +154,8 @@ void UAVObjectBrowserWidget::onTreeItemCollapsed(QModelIndex currentProxyIndex)
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
+    m_model->setExpanded(item, false);
+
     //Check if current tree index is the child of the top tree item
     if (top)
     {
@@ -367,6 +371,9 @@ void UAVObjectBrowserWidget::sendUpdate()
        return;
     }
 
+    // Values updated while the object was collapsed are read lazily
+    m_model->refreshObject(objItem);
+
     UAVDataObject * dataObj=qobject_cast<UAVDataObject *>(objItem->object());
     if(dataObj && dataObj->isSettings())
         objItem->setUpdatedOnly(true);
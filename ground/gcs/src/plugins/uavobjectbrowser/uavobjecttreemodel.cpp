@@ -49,6 +49,9 @@
 
 #include <QApplication>
 
+// Rate, in Hz, at which object updates are applied to the tree
+#define MODEL_REFRESH_RATE 20
+
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotation) :
     QAbstractItemModel(parent),
     m_rootItem(NULL),
@@ -74,6 +77,10 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
                                                                                  // out. In any case, never go faster than 10ms.
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
 
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(1000 / MODEL_REFRESH_RATE);
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(refreshDirtyItems()));
+
     QFont font;
     m_defaultValueFont = font;
     font.setWeight(QFont::Bold);
@@ -103,6 +110,11 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
         delete m_highlightManager;
+        m_refreshTimer.stop();
+        m_dirtyObjects.clear();
+        m_staleObjects.clear();
+        m_changedItems.clear();
+        m_expandedItems.clear();
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
@@ -164,6 +176,7 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                forgetItem(inst);
                 inst->parent()->removeChild(inst);
                 inst->deleteLater();
             }
@@ -531,20 +544,134 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
+/**
+ * @brief UAVObjectTreeModel::highlightUpdatedObject Notes that an object was
+ * updated. The tree is brought up to date by refreshDirtyItems(), so an object
+ * updating many times between two refreshes costs a single refresh.
+ */
 void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
 {
     Q_ASSERT(obj);
     ObjectTreeItem *item = findObjectTreeItem(obj);
     Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
+    m_dirtyObjects.insert(item);
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+}
+
+/**
+ * @brief UAVObjectTreeModel::refreshDirtyItems Applies the object updates
+ * received since the last refresh, and tells the view about the rows that
+ * changed with one ranged dataChanged per parent.
+ *
+ * Field values are only read for objects whose fields are in sight. Other
+ * objects are remembered as stale and read when they are expanded.
+ */
+void UAVObjectTreeModel::refreshDirtyItems()
+{
+    foreach (ObjectTreeItem *item, m_dirtyObjects) {
+        if (!m_onlyHighlightChangedValues) {
+            item->setHighlight(true);
+            m_changedItems.insert(item);
+        }
+        // Only highlighting changed values needs the values to tell
+        if (m_onlyHighlightChangedValues || (m_expandedItems.contains(item) && isVisible(item))) {
+            m_staleObjects.remove(item);
+            item->update();
+        } else {
+            m_staleObjects.insert(item);
+        }
+    }
+    m_dirtyObjects.clear();
+
+    QHash<TreeItem*, QPair<int, int> > ranges;
+    foreach (TreeItem *item, m_changedItems) {
+        if (!item->parent() || !isVisible(item))
+            continue;
+        int row = item->row();
+        QHash<TreeItem*, QPair<int, int> >::iterator range = ranges.find(item->parent());
+        if (range == ranges.end()) {
+            ranges.insert(item->parent(), qMakePair(row, row));
+        } else {
+            range->first = qMin(range->first, row);
+            range->second = qMax(range->second, row);
+        }
+    }
+    m_changedItems.clear();
+    m_refreshTimer.stop();
+
+    QHash<TreeItem*, QPair<int, int> >::const_iterator range;
+    for (range = ranges.constBegin(); range != ranges.constEnd(); ++range) {
+        TreeItem *parent = range.key();
+        emit dataChanged(createIndex(range->first, 0, parent->getChild(range->first)),
+                         createIndex(range->second, TreeItem::dataColumn, parent->getChild(range->second)));
     }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+}
+
+/**
+ * @brief UAVObjectTreeModel::setExpanded Tracks which items the view shows
+ * the children of, so that updates out of sight are not read or repainted.
+ * @param item The item expanded or collapsed in the view
+ * @param expanded true if it was expanded
+ */
+void UAVObjectTreeModel::setExpanded(TreeItem *item, bool expanded)
+{
+    if (!expanded) {
+        m_expandedItems.remove(item);
+        return;
+    }
+    m_expandedItems.insert(item);
+
+    // Catch up on the objects whose fields just came into sight
+    foreach (ObjectTreeItem *obj, m_staleObjects) {
+        if (m_expandedItems.contains(obj) && isVisible(obj))
+            refreshObject(obj);
+    }
+}
+
+/**
+ * @brief UAVObjectTreeModel::refreshObject Reads the field values of an object
+ * updated while it was collapsed. Must be done before the tree values of the
+ * object are used, e.g. before applying them.
+ * @param item The object, or one of its instances
+ */
+void UAVObjectTreeModel::refreshObject(ObjectTreeItem *item)
+{
+    // Instances are updated through the object holding them
+    if (dynamic_cast<InstanceTreeItem*>(item))
+        item = static_cast<ObjectTreeItem*>(item->parent());
+    if (m_staleObjects.remove(item))
+        item->update();
+}
+
+/**
+ * @brief UAVObjectTreeModel::isVisible Whether the view can show the row of
+ * an item, i.e. all of its ancestors are expanded.
+ */
+bool UAVObjectTreeModel::isVisible(TreeItem *item)
+{
+    for (TreeItem *parent = item->parent(); parent && parent != m_rootItem; parent = parent->parent()) {
+        if (!m_expandedItems.contains(parent))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief UAVObjectTreeModel::forgetItem Drops an item about to be deleted,
+ * and its children, from the pending refresh.
+ */
+void UAVObjectTreeModel::forgetItem(TreeItem *item)
+{
+    foreach (TreeItem *child, item->treeChildren())
+        forgetItem(child);
+    ObjectTreeItem *obj = dynamic_cast<ObjectTreeItem*>(item);
+    if (obj) {
+        m_dirtyObjects.remove(obj);
+        m_staleObjects.remove(obj);
     }
+    m_changedItems.remove(item);
+    m_expandedItems.remove(item);
 }
 
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
@@ -579,9 +706,10 @@ MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
+    // Repainted with the next refresh
+    m_changedItems.insert(item);
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
 }
 
 
@@ -40,6 +40,7 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
 #include <QColor>
 #include <QFont>
 
@@ -89,6 +90,9 @@ public:
 
     QModelIndex getIndex(int indexRow, int indexCol, TopTreeItem *topTreeItem){return createIndex(indexRow, indexCol, topTreeItem);}
 
+    void setExpanded(TreeItem *item, bool expanded);
+    void refreshObject(ObjectTreeItem *item);
+
 signals:
     void presentOnHardwareChanged();
 public slots:
@@ -99,6 +103,7 @@ private slots:
     void highlightUpdatedObject(UAVObject *obj);
     void updateHighlight(TreeItem*);
     void updateCurrentTime();
+    void refreshDirtyItems();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
 private:
@@ -116,6 +121,8 @@ private:
     ObjectTreeItem *findObjectTreeItem(UAVObject *obj);
     DataObjectTreeItem *findDataObjectTreeItem(UAVDataObject *obj);
     MetaObjectTreeItem *findMetaObjectTreeItem(UAVMetaObject *obj);
+    bool isVisible(TreeItem *item);
+    void forgetItem(TreeItem *item);
 
     TreeItem *m_rootItem;
     TopTreeItem *m_settingsTree;
@@ -138,6 +145,17 @@ private:
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
     bool isInitialized;
+
+    // Object updates are only noted as they arrive, and applied to the
+    // tree at most every m_refreshTimer interval
+    QTimer m_refreshTimer;
+    QSet<ObjectTreeItem*> m_dirtyObjects;
+    // Objects updated while their fields were out of sight, whose field
+    // items still hold old values
+    QSet<ObjectTreeItem*> m_staleObjects;
+    // Items whose rows need repainting on the next refresh
+    QSet<TreeItem*> m_changedItems;
+    QSet<TreeItem*> m_expandedItems;
 };
 
 #endif // UAVOBJECTTREEMODEL_H
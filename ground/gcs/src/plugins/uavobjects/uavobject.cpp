@@ -35,6 +35,7 @@
  */
 
 #include "uavobject.h"
+#include <algorithm>
 #include <QtEndian>
 #include <QDebug>
 #include <QJsonArray>
@@ -79,8 +80,11 @@ void UAVObject::initialize(quint32 instID)
  * @param fields List of fields held by the object
  * @param data Pointer to that actual object data, this is needed by the fields to access the data
  * @param numBytes Number of bytes in the object (total, including all fields)
+ * @param layout Generated layout of the fields, derived from the fields if NULL
+ * @param layoutLength Number of entries in layout
  */
-void UAVObject::initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes)
+void UAVObject::initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes,
+                                 const FieldLayout* layout, int layoutLength)
 {
     this->numBytes = numBytes;
     this->data = data;
@@ -93,6 +97,63 @@ void UAVObject::initializeFields(QList<UAVObjectField*>& fields, quint8* data, q
         offset += fields[n]->getNumBytes();
         connect(fields[n], SIGNAL(fieldUpdated(UAVObjectField*)), this, SLOT(fieldUpdated(UAVObjectField*)));
     }
+    Q_ASSERT(offset == numBytes);
+
+    // Precompute the layout used by pack() and unpack()
+    if (layout != NULL)
+    {
+        Q_ASSERT(layoutLength == fields.length());
+        fieldLayout = QVector<FieldLayout>(layoutLength);
+        std::copy(layout, layout + layoutLength, fieldLayout.begin());
+    }
+    else
+    {
+        fieldLayout.resize(fields.length());
+        for (int n = 0; n < fields.length(); ++n)
+        {
+            FieldLayout &entry = fieldLayout[n];
+            entry.offset = fields[n]->getDataOffset();
+            entry.numElements = fields[n]->getNumElements();
+            switch (fields[n]->getType())
+            {
+            case UAVObjectField::INT16:
+            case UAVObjectField::UINT16:
+                entry.elementSize = 2;
+                break;
+            case UAVObjectField::INT32:
+            case UAVObjectField::UINT32:
+            case UAVObjectField::FLOAT32:
+                entry.elementSize = 4;
+                break;
+            default:
+                // Byte sized elements, bitfields are packed 8 to a byte
+                entry.numElements = fields[n]->getNumBytes();
+                entry.elementSize = 1;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Convert the multi-byte elements of a packed object between host and
+ * little endian order in place. Does nothing on little endian hosts.
+ */
+static inline void swapPackedElements(quint8* buf, const QVector<UAVObject::FieldLayout>& layout)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    Q_UNUSED(buf);
+    Q_UNUSED(layout);
+#else
+    foreach (const UAVObject::FieldLayout &entry, layout)
+    {
+        if (entry.elementSize == 1)
+            continue;
+        quint8 *element = &buf[entry.offset];
+        for (quint32 n = 0; n < entry.numElements; ++n, element += entry.elementSize)
+            std::reverse(element, element + entry.elementSize);
+    }
+#endif
 }
 
 /**
@@ -274,13 +335,10 @@ UAVObjectField* UAVObject::getField(const QString& name)
  */
 qint32 UAVObject::pack(quint8* dataOut)
 {
-    qint32 offset = 0;
-    for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
-    {
-        UAVObjectField *field = *iter;
-        field->pack(&dataOut[offset]);
-        offset += field->getNumBytes();
-    }
+    // The object data is stored packed in wire order, so this is a single
+    // copy (plus a byte swap on big endian hosts)
+    memcpy(dataOut, data, numBytes);
+    swapPackedElements(dataOut, fieldLayout);
     return numBytes;
 }
 
@@ -290,13 +348,8 @@ qint32 UAVObject::pack(quint8* dataOut)
  */
 qint32 UAVObject::unpack(const quint8* dataIn)
 {
-    qint32 offset = 0;
-    for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
-    {
-        UAVObjectField *field = *iter;
-        field->unpack(&dataIn[offset]);
-        offset += field->getNumBytes();
-    }
+    memcpy(data, dataIn, numBytes);
+    swapPackedElements(data, fieldLayout);
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
 
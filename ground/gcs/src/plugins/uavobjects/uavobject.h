@@ -43,6 +43,7 @@
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <QVector>
 #include <QFile>
 #include <qglobal.h>
 #include "uavobjectfield.h"
@@ -110,6 +111,16 @@ public:
         quint16 loggingUpdatePeriod; /** Update period used by the logging module (only if logging mode is PERIODIC) */
      }) Metadata;
 
+    /**
+     * Position of one field in the packed object data. The generator emits
+     * a table of these for every object, in the same order as the fields.
+     */
+    typedef struct {
+        quint16 offset; /** Byte offset of the first element */
+        quint16 numElements; /** Number of elements in the field */
+        quint8 elementSize; /** Size of a single element in bytes */
+    } FieldLayout;
+
 
     UAVObject(quint32 objID, bool isSingleInst, const QString& name);
     void initialize(quint32 instID);
@@ -245,7 +256,9 @@ protected:
     quint32 numBytes;
     quint8* data;
     QList<UAVObjectField*> fields;
-    void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
+    QVector<FieldLayout> fieldLayout;
+    void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes,
+                          const FieldLayout* layout = NULL, int layoutLength = 0);
     void setDescription(const QString& description);
     void setCategory(const QString& category);
 
@@ -1063,14 +1063,115 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     }
 }
 
+/**
+ * Get an element as a double. Numeric types are read straight from the
+ * object data without going through a QVariant.
+ */
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    // Check that index is not out of bounds
+    if ( index >= numElements )
+    {
+        return 0;
+    }
+
+    const quint8 *element = &data[offset + numBytesPerElement*index];
+    switch (type)
+    {
+    case INT8:
+        return *(const qint8 *)element;
+    case INT16:
+    {
+        qint16 tmpint16;
+        memcpy(&tmpint16, element, sizeof(tmpint16));
+        return tmpint16;
+    }
+    case INT32:
+    {
+        qint32 tmpint32;
+        memcpy(&tmpint32, element, sizeof(tmpint32));
+        return tmpint32;
+    }
+    case UINT8:
+        return *element;
+    case UINT16:
+    {
+        quint16 tmpuint16;
+        memcpy(&tmpuint16, element, sizeof(tmpuint16));
+        return tmpuint16;
+    }
+    case UINT32:
+    {
+        quint32 tmpuint32;
+        memcpy(&tmpuint32, element, sizeof(tmpuint32));
+        return tmpuint32;
+    }
+    case FLOAT32:
+    {
+        float tmpfloat;
+        memcpy(&tmpfloat, element, sizeof(tmpfloat));
+        return tmpfloat;
+    }
+    case BITFIELD:
+        return (data[offset + numBytesPerElement*((quint32)(index/8))] >> (index % 8)) & 1;
+    default:
+        // Enums and strings are converted from their text
+        return getValue(index).toDouble();
+    }
 }
 
+/**
+ * Set an element from a double. Numeric types are written straight to the
+ * object data without going through a QVariant; integers are rounded.
+ */
 void UAVObjectField::setDouble(double value, quint32 index)
 {
-    setValue(QVariant(value), index);
+    // Check that index is not out of bounds
+    if ( index >= numElements )
+    {
+        return;
+    }
+
+    // Update value if the access mode permits
+    if ( UAVObject::GetGcsAccess(obj->getMetadata()) != UAVObject::ACCESS_READWRITE )
+    {
+        return;
+    }
+
+    quint8 *element = &data[offset + numBytesPerElement*index];
+    switch (type)
+    {
+    case INT8:
+    case UINT8:
+    {
+        quint8 tmpuint8 = qRound64(value);
+        *element = tmpuint8;
+        break;
+    }
+    case INT16:
+    case UINT16:
+    {
+        quint16 tmpuint16 = qRound64(value);
+        memcpy(element, &tmpuint16, sizeof(tmpuint16));
+        break;
+    }
+    case INT32:
+    case UINT32:
+    {
+        quint32 tmpuint32 = qRound64(value);
+        memcpy(element, &tmpuint32, sizeof(tmpuint32));
+        break;
+    }
+    case FLOAT32:
+    {
+        float tmpfloat = value;
+        memcpy(element, &tmpfloat, sizeof(tmpfloat));
+        break;
+    }
+    default:
+        setValue(QVariant(value), index);
+        break;
+    }
 }
 
 QString UAVObjectField::getDescription()
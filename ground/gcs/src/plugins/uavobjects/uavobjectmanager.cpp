@@ -40,6 +40,12 @@
  */
 UAVObjectManager::UAVObjectManager()
 {
+    objects.reserve(EXPECTED_OBJECTS);
+    dataObjects.reserve(EXPECTED_OBJECTS / 2);
+    metaObjects.reserve(EXPECTED_OBJECTS / 2);
+    objectIndex.reserve(EXPECTED_OBJECTS);
+    dataObjectIndex.reserve(EXPECTED_OBJECTS / 2);
+    nameIndex.reserve(EXPECTED_OBJECTS);
 }
 
 UAVObjectManager::~UAVObjectManager()
@@ -56,43 +62,34 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
 {
     // Check if this object type is already in the list
     quint32 objID = obj->getObjID();
-    if (objects.contains(objID))//Known object ID
+    int index = indexOf(objID);
+    if (index >= 0)//Known object ID
     {
-        if (objects.value(objID).contains(obj->getInstID()))//Instance already present
+        const QVector<UAVObject*> &instances = objects.at(index);
+        quint32 numInstances = instances.size();
+        if (obj->getInstID() < numInstances)//Instance already present
             return false;
         if (obj->isSingleInstance())
             return false;
         if (obj->getInstID() >= MAX_INSTANCES)
             return false;
-        UAVDataObject* refObj = dynamic_cast<UAVDataObject*>(objects.value(objID).first());
+        if (instances.isEmpty())
+            return false;
+        UAVDataObject* refObj = dynamic_cast<UAVDataObject*>(instances.first());
         if (refObj == NULL)
         {
             return false;
         }
         UAVMetaObject* mobj = refObj->getMetaObject();
-        if (objects.value(objID).last()->getInstID() < obj->getInstID())//Space between last existent instance and new one, lets fill the gaps
+        // Instances are kept contiguous, fill any gap up to the new one
+        for (quint32 instidx = numInstances; instidx < obj->getInstID(); ++instidx)
         {
-            for (quint32 instidx = objects.value(objID).last()->getInstID() + 1 ; instidx < obj->getInstID(); ++instidx)
-            {
-                UAVDataObject* cobj = obj->clone(instidx);
-                cobj->initialize(instidx,mobj);
-                QMap<quint32,UAVObject*> ppp;
-                ppp.insert(instidx,cobj);
-                objects[objID].insert(instidx,cobj);
-                getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
-                emit newInstance(cobj);
-            }
-        }
-        else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
-        else
-        {
-            return false;
+            UAVDataObject* cobj = obj->clone(instidx);
+            cobj->initialize(instidx,mobj);
+            addInstance(cobj);
         }
         // Add the actual object instance in the list
-        objects[objID].insert(obj->getInstID(),obj);
-        getObject(objID)->emitNewInstance(obj);
-        emit newInstance(obj);
+        addInstance(obj);
         return true;
     }
     else
@@ -123,164 +120,179 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
     quint32 objID = obj->getObjID();
     if(obj->isSingleInstance())
         return false;
-    quint32 instances = (quint32)objects.value(obj->getObjID()).count();
+    int index = indexOf(objID);
+    if (index < 0)
+        return true;
+    quint32 instances = (quint32)objects.at(index).size();
     for(quint32 x = obj->getInstID(); x < instances; ++x)
     {
-        getObject(objects.value(objID).value(x)->getObjID())->emitInstanceRemoved(objects.value(objID).value(x));
-        emit instanceRemoved(objects.value(objID).value(x));
-        objects[objID].remove(x);
+        UAVObject *inst = objects.at(index).at(x);
+        getObject(objID)->emitInstanceRemoved(inst);
+        emit instanceRemoved(inst);
+    }
+    if (obj->getInstID() < instances)
+    {
+        objects[index].resize(obj->getInstID());
+        dataObjects[dataObjectIndex.value(objID)].resize(obj->getInstID());
     }
     return true;
 }
 
+/**
+ * Add a new object type, obj becomes its first instance
+ */
 void UAVObjectManager::addObject(UAVObject* obj)
 {
     // Add to list
-    QMap<quint32,UAVObject*> list;
-    list.insert(obj->getInstID(),obj);
-    objects.insert(obj->getObjID(),list);
+    int index = objects.size();
+    objects.append(QVector<UAVObject*>() << obj);
+    objectIndex.insert(obj->getObjID(), index);
+    nameIndex.insert(obj->getName(), index);
 
-    objectsByName.insert(obj->getName(), list);
+    UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
+    UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(obj);
+    if (dobj)
+    {
+        dataObjectIndex.insert(obj->getObjID(), dataObjects.size());
+        dataObjects.append(QVector<UAVDataObject*>() << dobj);
+    }
+    else if (mobj)
+    {
+        metaObjects.append(QVector<UAVMetaObject*>() << mobj);
+    }
 
     emit newObject(obj);
 }
 
 /**
- * Get all objects. A two dimentional QVector is returned. Objects are grouped by
- * instances of the same object type.
+ * Append an instance to an already known object type
  */
-QVector< QVector<UAVObject*> > UAVObjectManager::getObjectsVector()
+void UAVObjectManager::addInstance(UAVDataObject* obj)
 {
-    QVector< QVector<UAVObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
-    {
-        QVector<UAVObject*> vec = map.values().toVector();
-        vector.append(vec);
-    }
-    return vector;
+    objects[objectIndex.value(obj->getObjID())].append(obj);
+    dataObjects[dataObjectIndex.value(obj->getObjID())].append(obj);
+
+    getObject(obj->getObjID())->emitNewInstance(obj);
+    emit newInstance(obj);
 }
 
-QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
+/**
+ * Position of an object type in the object vectors
+ * @returns The index or -1 if the object is not known
+ */
+int UAVObjectManager::indexOf(quint32 objId) const
 {
-    return objects;
+    QHash<quint32, int>::const_iterator it = objectIndex.constFind(objId);
+    if (it == objectIndex.constEnd())
+        return -1;
+    return it.value();
+}
+
+int UAVObjectManager::indexOf(const QString& name) const
+{
+    QHash<QString, int>::const_iterator it = nameIndex.constFind(name);
+    if (it == nameIndex.constEnd())
+        return -1;
+    return it.value();
 }
 
 /**
- * Same as getObjects() but will only return DataObjects.
+ * Get all objects. A two dimentional QVector is returned. Objects are grouped by
+ * instances of the same object type, and each group is indexed by instance ID.
+ * The returned vector is the manager's own storage and is not copied.
  */
-QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjectsVector()
+const QVector< QVector<UAVObject*> > &UAVObjectManager::getObjectsVector() const
 {
-    QVector< QVector<UAVDataObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
-    {
-        UAVDataObject* obj = dynamic_cast<UAVDataObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVDataObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(o);
-                if(dobj)
-                    vec.append(dobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    return objects;
 }
 
 /**
- * Same as getObjects() but will only return MetaObjects.
+ * Get all objects keyed by object and instance ID. This builds a new
+ * container on every call, prefer getObjectsVector() for iteration.
  */
-QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
+QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
 {
-    QVector< QVector<UAVMetaObject*> > vector;
-    foreach(const ObjectMap &map,objects.values())
+    QHash<quint32, ObjectMap> hash;
+    foreach (const QVector<UAVObject*> &instances, objects)
     {
-        UAVMetaObject* obj = dynamic_cast<UAVMetaObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVMetaObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(o);
-                if(mobj)
-                    vec.append(mobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+        if (instances.isEmpty())
+            continue;
+        ObjectMap map;
+        for (int instId = 0; instId < instances.size(); ++instId)
+            map.insert(instId, instances.at(instId));
+        hash.insert(instances.first()->getObjID(), map);
+    }
+    return hash;
 }
 
 /**
- * Get a specific object given its name and instance ID
- * @returns The object is found or NULL if not
+ * Same as getObjectsVector() but will only return DataObjects.
  */
-UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
+const QVector< QVector<UAVDataObject*> > &UAVObjectManager::getDataObjectsVector() const
 {
-    return getObject(name, 0, instId);
+    return dataObjects;
 }
 
 /**
- * Get a specific object given its object and instance ID
- * @returns The object is found or NULL if not
+ * Same as getObjectsVector() but will only return MetaObjects.
  */
-UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
+const QVector <QVector<UAVMetaObject*> > &UAVObjectManager::getMetaObjectsVector() const
 {
-    return getObject(NULL, objId, instId);
+    return metaObjects;
 }
 
 /**
- * Helper function for the public getObject() functions.
+ * Get a specific object given its name and instance ID
+ * @returns The object is found or NULL if not
  */
-UAVObject* UAVObjectManager::getObject(const QString& name, quint32 objId, quint32 instId)
+UAVObject* UAVObjectManager::getObject(const QString& name, quint32 instId)
 {
-    if(name != NULL)
-    {
-        if (objectsByName.contains(name)) {
-            return objectsByName.value(name).value(instId);
-        }
-
+    int index = indexOf(name);
+    if (index < 0)
         return NULL;
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    const QVector<UAVObject*> &instances = objects.at(index);
+    if (instId >= (quint32)instances.size())
+        return NULL;
+    return instances.at(instId);
 }
 
 /**
- * Get all the instances of the object specified by name
+ * Get a specific object given its object and instance ID
+ * @returns The object is found or NULL if not
  */
-QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString& name)
+UAVObject* UAVObjectManager::getObject(quint32 objId, quint32 instId)
 {
-    return getObjectInstancesVector(&name, 0);
+    int index = indexOf(objId);
+    if (index < 0)
+        return NULL;
+    const QVector<UAVObject*> &instances = objects.at(index);
+    if (instId >= (quint32)instances.size())
+        return NULL;
+    return instances.at(instId);
 }
 
 /**
- * Get all the instances of the object specified by its ID
+ * Get all the instances of the object specified by name
  */
-QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(quint32 objId)
+const QVector<UAVObject*> &UAVObjectManager::getObjectInstancesVector(const QString& name) const
 {
-    return getObjectInstancesVector(NULL, objId);
+    static const QVector<UAVObject*> empty;
+    int index = indexOf(name);
+    if (index < 0)
+        return empty;
+    return objects.at(index);
 }
 
 /**
- * Helper function for the public getObjectInstances()
+ * Get all the instances of the object specified by its ID
  */
-QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* name, quint32 objId)
+const QVector<UAVObject*> &UAVObjectManager::getObjectInstancesVector(quint32 objId) const
 {
-    if(name != NULL)
-    {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return  QVector<UAVObject*>();
+    static const QVector<UAVObject*> empty;
+    int index = indexOf(objId);
+    if (index < 0)
+        return empty;
+    return objects.at(index);
 }
 
 /**
@@ -288,7 +300,10 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* na
  */
 qint32 UAVObjectManager::getNumInstances(const QString& name)
 {
-    return getNumInstances(&name, 0);
+    int index = indexOf(name);
+    if (index < 0)
+        return -1;
+    return objects.at(index).size();
 }
 
 /**
@@ -296,25 +311,10 @@ qint32 UAVObjectManager::getNumInstances(const QString& name)
  */
 qint32 UAVObjectManager::getNumInstances(quint32 objId)
 {
-    return getNumInstances(NULL, objId);
-}
-
-/**
- * Helper function for public getNumInstances
- */
-qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
-{
-    if(name != NULL)
-    {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+    int index = indexOf(objId);
+    if (index < 0)
+        return -1;
+    return objects.at(index).size();
 }
 
 UAVObjectField *UAVObjectManager::getField(const QString &objName, const QString &fieldName, quint32 instId)
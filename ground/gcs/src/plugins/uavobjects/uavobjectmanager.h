@@ -53,10 +53,10 @@ public:
     ~UAVObjectManager();
     typedef QMap<quint32,UAVObject*> ObjectMap;
     bool registerObject(UAVDataObject* obj);
-    QVector< QVector<UAVObject*> > getObjectsVector();
+    const QVector< QVector<UAVObject*> > &getObjectsVector() const;
     QHash<quint32, QMap<quint32,UAVObject*> > getObjects();
-    QVector< QVector<UAVDataObject*> > getDataObjectsVector();
-    QVector< QVector<UAVMetaObject*> > getMetaObjectsVector();
+    const QVector< QVector<UAVDataObject*> > &getDataObjectsVector() const;
+    const QVector< QVector<UAVMetaObject*> > &getMetaObjectsVector() const;
     UAVObject* getObject(const QString& name, quint32 instId = 0);
     UAVObject* getObject(quint32 objId, quint32 instId = 0);
     /**
@@ -68,8 +68,8 @@ public:
      * @return The field if successful, null pointer otherwise
      */
     UAVObjectField *getField(const QString &objName, const QString &fieldName, quint32 instId = 0);
-    QVector<UAVObject*> getObjectInstancesVector(const QString& name);
-    QVector<UAVObject*> getObjectInstancesVector(quint32 objId);
+    const QVector<UAVObject*> &getObjectInstancesVector(const QString& name) const;
+    const QVector<UAVObject*> &getObjectInstancesVector(quint32 objId) const;
     qint32 getNumInstances(const QString& name);
     qint32 getNumInstances(quint32 objId);    
     bool unRegisterObject(UAVDataObject *obj);
@@ -79,13 +79,22 @@ signals:
     void instanceRemoved(UAVObject* obj);
 private:
     static const quint32 MAX_INSTANCES = 1000;
-    QHash<quint32, QMap<quint32,UAVObject*> > objects;
-    QHash<QString, QMap<quint32,UAVObject*> > objectsByName;
+    static const int EXPECTED_OBJECTS = 512;
+
+    // Instances of each object type, indexed by instance ID
+    QVector< QVector<UAVObject*> > objects;
+    QVector< QVector<UAVDataObject*> > dataObjects;
+    QVector< QVector<UAVMetaObject*> > metaObjects;
+
+    // Object ID and name to position in the vectors above
+    QHash<quint32, int> objectIndex;
+    QHash<quint32, int> dataObjectIndex;
+    QHash<QString, int> nameIndex;
 
     void addObject(UAVObject* obj);
-    UAVObject* getObject(const QString& name, quint32 objId, quint32 instId);
-    QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
-    qint32 getNumInstances(const QString* name, quint32 objId);
+    void addInstance(UAVDataObject* obj);
+    int indexOf(quint32 objId) const;
+    int indexOf(const QString& name) const;
 };
 
 
@@ -44,6 +44,8 @@ const QString $(NAME)::DESCRIPTION = QString("$(DESCRIPTION)");
 const QString $(NAME)::CATEGORY = QString("$(CATEGORY)");
 const QHash<QString, QString> $(NAME)::FIELD_DESCRIPTIONS{
 $(FIELDDESCRIPTIONS_STRINGS)};
+const UAVObject::FieldLayout $(NAME)::FIELD_LAYOUT[] = {
+$(FIELDLAYOUT)};
 
 /**
  * Constructor
@@ -54,7 +56,8 @@ $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
     QList<UAVObjectField*> fields;
 $(FIELDSINIT)
     // Initialize object
-    initializeFields(fields, (quint8*)&data, NUMBYTES);
+    initializeFields(fields, (quint8*)&data, NUMBYTES, FIELD_LAYOUT,
+                     sizeof(FIELD_LAYOUT) / sizeof(FIELD_LAYOUT[0]));
     // Set the default field values
     setDefaultFieldValues();
     // Set the object description
@@ -72,6 +72,7 @@ $(DATAFIELDINFO)
     static const bool ISSETTINGS = $(ISSETTINGS);
     static const quint32 NUMBYTES = $(NUMBYTES);
     static const QHash<QString, QString> FIELD_DESCRIPTIONS;
+    static const UAVObject::FieldLayout FIELD_LAYOUT[];
 
     // Functions
     $(NAME)();
@@ -104,16 +104,12 @@ void TelemetryManager::onGeneralSettingsChanged()
 {
     if (!settings->useSessionManaging())
     {
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
+            foreach(UAVDataObject* dobj, instances)
             {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
-                if(dobj)
-                {
-                    dobj->setIsPresentOnHardware(false);
-                    dobj->setIsPresentOnHardware(true);
-                }
+                dobj->setIsPresentOnHardware(false);
+                dobj->setIsPresentOnHardware(true);
             }
         }
     }
@@ -110,14 +110,10 @@ TelemetryMonitor::~TelemetryMonitor() {
     gcsStats.Status = GCSTelemetryStats::STATUS_DISCONNECTED;
     if (settings->useSessionManaging())
     {
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
-                if(dobj)
-                    dobj->setIsPresentOnHardware(false);
-            }
+            foreach(UAVDataObject* dobj, instances)
+                dobj->setIsPresentOnHardware(false);
         }
     }
     // Set data
@@ -475,14 +471,10 @@ void TelemetryMonitor::startSessionRetrieving(UAVObject *session)
     {
         sessionRetrieveTimeout->start(SESSION_RETRIEVE_TIMEOUT);
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 NULL new session start").arg(Q_FUNC_INFO));
-        foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+        foreach(const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector())
         {
-            foreach(UAVObject* obj, map.values())
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
-                if(dobj)
-                    dobj->setIsPresentOnHardware(false);
-            }
+            foreach(UAVDataObject* dobj, instances)
+                dobj->setIsPresentOnHardware(false);
         }
         currentIndex = 0;
         objectCount = 0;
@@ -559,13 +551,10 @@ void TelemetryMonitor::sessionFallback()
 {
     isManaged = false;
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 SESSION FALLBACK").arg(Q_FUNC_INFO));
-    foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
+    foreach(const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector())
     {
-        foreach (UAVObject* obj, map) {
-            UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
-            if(dobj)
-                dobj->setIsPresentOnHardware(true);
-        }
+        foreach(UAVDataObject* dobj, instances)
+            dobj->setIsPresentOnHardware(true);
     }
     startRetrievingObjects();
 }
@@ -667,14 +656,10 @@ void TelemetryMonitor::processStatsUpdates()
         Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
         if (settings->useSessionManaging())
         {
-            foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects())
+            foreach(const QVector<UAVDataObject*> &instances, objMngr->getDataObjectsVector())
             {
-                foreach(UAVObject* obj, map.values())
-                {
-                    UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
-                    if(dobj)
-                        dobj->setIsPresentOnHardware(false);
-                }
+                foreach(UAVDataObject* dobj, instances)
+                    dobj->setIsPresentOnHardware(false);
             }
         }
         emit disconnected();
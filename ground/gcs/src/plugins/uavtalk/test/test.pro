@@ -0,0 +1,23 @@
+include(../../../../gcs.pri)
+
+QT += testlib network qml
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = tst_uavtalk
+TEMPLATE = app
+
+# The UAVObjects and UAVTalk libraries live with the plugins
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+INCLUDEPATH *= $$PWD/.. $$GCS_SOURCE_TREE/src/plugins
+linux-* {
+    QMAKE_LFLAGS += -Wl,-rpath,$$GCS_PLUGIN_PATH/dRonin
+}
+
+include(../uavtalk.pri)
+
+SOURCES += tst_uavtalk.cpp
+
+SOURCES += $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp
@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_uavtalk.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Checks the block receive path against the byte-wise parser
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDataStream>
+#include <QtCore/QObject>
+
+#include "uavobjectmanager.h"
+#include "uavobjects/uavobjectsinit.h"
+#include "uavtalk.h"
+
+// Rounds of every object in the capture
+#define CAPTURE_ROUNDS 40
+
+// Typical sizes of a serial port read
+#define MAX_READ_SIZE 300
+
+/**
+ * Receiver that records the packets it is handed instead of updating
+ * the objects
+ */
+class PacketRecorder : public UAVTalk
+{
+public:
+    PacketRecorder(QIODevice *iodev, UAVObjectManager *objMngr) :
+        UAVTalk(iodev, objMngr)
+    {
+    }
+
+    QList<QByteArray> packets;
+
+protected:
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length)
+    {
+        QByteArray packet;
+        QDataStream out(&packet, QIODevice::WriteOnly);
+        out << type << objId << instId;
+        out.writeRawData((const char *) data, length);
+
+        packets.append(packet);
+        return true;
+    }
+};
+
+class tst_UAVTalk : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void samePackets();
+    void byteParser();
+    void blockParser();
+
+private:
+    quint32 nextRandom();
+    void replayBytes(PacketRecorder *rx);
+    void replayBlocks(PacketRecorder *rx);
+
+    UAVObjectManager *m_objMngr;
+    QBuffer m_io;
+    QByteArray m_capture;
+    int m_frames;
+    quint32 m_seed;
+};
+
+/**
+ * Simple LCG, so that the capture is the same on every run
+ */
+quint32 tst_UAVTalk::nextRandom()
+{
+    m_seed = m_seed * 1103515245 + 12345;
+    return m_seed >> 16;
+}
+
+/**
+ * Build a telemetry capture: every object, over and over with new data,
+ * with line noise between some frames and a damaged checksum on others.
+ * The noise never contains a sync byte, both parsers resync the same way
+ * only after a frame boundary.
+ */
+void tst_UAVTalk::initTestCase()
+{
+    m_objMngr = new UAVObjectManager;
+    UAVObjectsInitialize(m_objMngr);
+
+    m_seed = 0x55A0;
+    m_frames = 0;
+
+    int frameCount = 0;
+    for (int round = 0; round < CAPTURE_ROUNDS; round++) {
+        foreach (const QVector<UAVObject *> &instances, m_objMngr->getObjectsVector()) {
+            UAVObject *obj = instances.first();
+
+            QByteArray data(obj->getNumBytes(), 0);
+            for (int i = 0; i < data.size(); i++)
+                data[i] = nextRandom() & 0xFF;
+            obj->unpack((const quint8 *) data.constData());
+
+            QByteArray frame = UAVTalk::encodeObject(obj);
+            if (frame.isEmpty())
+                continue;
+
+            frameCount++;
+            if (frameCount % 13 == 0) {
+                frame[frame.size() - 1] = frame.at(frame.size() - 1) ^ 0x5A;
+            } else {
+                m_frames++;
+            }
+            m_capture.append(frame);
+
+            if (frameCount % 7 == 0) {
+                int noise = nextRandom() % 40;
+                for (int i = 0; i < noise; i++) {
+                    quint8 byte = nextRandom() & 0xFF;
+                    m_capture.append((char) (byte == 0x3C ? 0x00 : byte));
+                }
+            }
+        }
+    }
+
+    QVERIFY(m_frames > 0);
+    qDebug() << m_capture.size() << "bytes," << m_frames << "good frames";
+}
+
+void tst_UAVTalk::cleanupTestCase()
+{
+    // The object manager does not own the objects it indexes
+    foreach (const QVector<UAVObject *> &instances, m_objMngr->getObjectsVector())
+        qDeleteAll(instances);
+    delete m_objMngr;
+}
+
+void tst_UAVTalk::replayBytes(PacketRecorder *rx)
+{
+    const quint8 *data = (const quint8 *) m_capture.constData();
+    for (int i = 0; i < m_capture.size(); i++)
+        rx->processInputByte(data[i]);
+}
+
+/**
+ * Feed the capture in reads of varying size, so packets straddle reads
+ */
+void tst_UAVTalk::replayBlocks(PacketRecorder *rx)
+{
+    const quint8 *data = (const quint8 *) m_capture.constData();
+    int pos = 0;
+    int read = 0;
+    while (pos < m_capture.size()) {
+        int size = qMin(1 + (read++ * 37) % MAX_READ_SIZE, m_capture.size() - pos);
+        rx->processInputBlock(&data[pos], size);
+        pos += size;
+    }
+}
+
+void tst_UAVTalk::samePackets()
+{
+    PacketRecorder byteRx(&m_io, m_objMngr);
+    PacketRecorder blockRx(&m_io, m_objMngr);
+
+    replayBytes(&byteRx);
+    replayBlocks(&blockRx);
+
+    QCOMPARE(byteRx.packets.size(), m_frames);
+    QCOMPARE(blockRx.packets.size(), m_frames);
+    QVERIFY(byteRx.packets == blockRx.packets);
+    QCOMPARE(byteRx.getStats().rxObjects, blockRx.getStats().rxObjects);
+}
+
+void tst_UAVTalk::byteParser()
+{
+    QBENCHMARK {
+        PacketRecorder rx(&m_io, m_objMngr);
+        replayBytes(&rx);
+    }
+}
+
+void tst_UAVTalk::blockParser()
+{
+    QBENCHMARK {
+        PacketRecorder rx(&m_io, m_objMngr);
+        replayBlocks(&rx);
+    }
+}
+
+QTEST_MAIN(tst_UAVTalk)
+
+#include "tst_uavtalk.moc"
@@ -35,6 +35,7 @@
 
 #include "uavtalk.h"
 #include <QtEndian>
+#include <uavtalk_delta.h>
 #include <QDebug>
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/generalsettings.h>
@@ -79,13 +80,16 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
 
     rxState = STATE_SYNC;
     rxPacketLength = 0;
+    rxStreamFill = 0;
+    deltaEncoded = false;
 
     memset(&stats, 0, sizeof(ComStats));
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+    // Headless tools (e.g. the log converter) run without a plugin manager
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    Core::Internal::GeneralSettings * settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings && settings->useUDPMirror();
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -127,17 +131,226 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
-        while (io->bytesAvailable() > 0)
+        while (io && io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            qint64 count = io->read((char*)&rxStreamBuffer[rxStreamFill],
+                    RX_STREAM_BUFFER_SIZE - rxStreamFill);
+            if (count <= 0)
+                break;
+
+            rxStreamFill += count;
+            processStreamBuffer();
         }
     }
 }
 
+/**
+ * Process a block of bytes from the telemetry stream. Complete packets are
+ * dispatched immediately, a trailing partial packet is kept until the next
+ * call completes it.
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes in data
+ */
+void UAVTalk::processInputBlock(const quint8 *data, qint64 length)
+{
+    while (length > 0)
+    {
+        qint32 count = qMin<qint64>(length, RX_STREAM_BUFFER_SIZE - rxStreamFill);
+
+        memcpy(&rxStreamBuffer[rxStreamFill], data, count);
+        rxStreamFill += count;
+        data += count;
+        length -= count;
+
+        processStreamBuffer();
+    }
+}
+
+/**
+ * Dispatch all complete packets in the receive buffer and move whatever
+ * remains to the front of it.
+ */
+void UAVTalk::processStreamBuffer()
+{
+    qint32 used = processInputFrames(rxStreamBuffer, rxStreamFill);
+
+    rxStreamFill -= used;
+    if (rxStreamFill > 0 && used > 0)
+        memmove(rxStreamBuffer, &rxStreamBuffer[used], rxStreamFill);
+}
+
+/**
+ * Scan a buffer for complete packets and dispatch them. This is the
+ * block equivalent of processInputByte(): the header is validated in
+ * one go and the CRC is computed over the whole frame at once.
+ * \param[in] data Buffer to scan
+ * \param[in] length Number of valid bytes in data
+ * \return Number of bytes consumed, the rest is an incomplete packet
+ */
+qint32 UAVTalk::processInputFrames(quint8 *data, qint32 length)
+{
+    qint32 pos = 0;
+
+    // Finish off any packet the byte-wise state machine has started
+    while (pos < length && rxState != STATE_SYNC)
+        processInputByte(data[pos++]);
+
+    while (pos < length)
+    {
+        quint8 *sync = (quint8 *)memchr(&data[pos], SYNC_VAL, length - pos);
+        if (sync == NULL)
+        {
+            stats.rxBytes += length - pos;
+            return length;
+        }
+
+        stats.rxBytes += sync - &data[pos];
+        pos = sync - data;
+
+        if (length - pos < MIN_HEADER_LENGTH)
+            break;
+
+        quint8 *frame = &data[pos];
+        bool timestamped = frame[1] & TIMESTAMPED;
+        quint8 type = frame[1] & ~TIMESTAMPED;
+        qint32 size = qFromLittleEndian<quint16>(&frame[2]);
+
+        if ((type & TYPE_MASK) != TYPE_VER || (type == TYPE_OBJ_DELTA && !timestamped) ||
+                size < MIN_HEADER_LENGTH || size > MAX_HEADER_LENGTH + TIMESTAMP_LENGTH + MAX_PAYLOAD_LENGTH)
+        {   // not a packet start, resync on the next byte
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Frame->Sync (bad header)");
+            stats.rxBytes++;
+            pos++;
+            continue;
+        }
+
+        quint32 objId = qFromLittleEndian<quint32>(&frame[4]);
+        UAVObject *obj = objMngr->getObject(objId);
+        qint32 dataLength = 0;
+        qint32 dataOffset = MIN_HEADER_LENGTH;
+        bool hasInstance = false;
+
+        if (obj == NULL && type != TYPE_OBJ_REQ)
+        {
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Frame->Sync (badtype)");
+            stats.rxErrors++;
+            stats.rxBytes++;
+            pos++;
+            continue;
+        }
+        else if (obj != NULL)
+        {
+            hasInstance = !obj->isSingleInstance();
+            if (hasInstance)
+                dataOffset = MAX_HEADER_LENGTH;
+            if (timestamped)
+                dataOffset += TIMESTAMP_LENGTH;
+
+            // Deltas are shorter than the object, and vary in length
+            if (type == TYPE_OBJ_DELTA)
+                dataLength = qBound<qint32>(0, size - dataOffset, obj->getNumBytes() - 1);
+            else if (type != TYPE_OBJ_REQ && type != TYPE_ACK && type != TYPE_NACK)
+                dataLength = obj->getNumBytes();
+        }
+
+        if (dataLength >= MAX_PAYLOAD_LENGTH || dataOffset + dataLength != size ||
+                (type == TYPE_OBJ_DELTA && dataLength < UAVTALK_DELTA_HEADER_LENGTH))
+        {   // packet error - oversize or mismatched packet size
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Frame->Sync (length mismatch)");
+            stats.rxErrors++;
+            stats.rxBytes++;
+            pos++;
+            continue;
+        }
+
+        // Wait for the rest of the packet
+        if (length - pos < size + CHECKSUM_LENGTH)
+            break;
+
+        if (updateCRC(0, frame, size) != frame[size])
+        {   // packet error - faulty CRC
+            UAVTALK_QXTLOG_DEBUG("UAVTalk: Frame->Sync (badcrc)");
+            stats.rxErrors++;
+            stats.rxBytes++;
+            pos++;
+            continue;
+        }
+
+        quint16 instId = 0;
+        if (hasInstance)
+            instId = qFromLittleEndian<quint16>(&frame[MIN_HEADER_LENGTH]);
+
+        stats.rxBytes += size + CHECKSUM_LENGTH;
+        pos += size + CHECKSUM_LENGTH;
+
+        if (type == TYPE_OBJ_DELTA)
+        {
+            deltaEncoded = true;
+            const QByteArray *objData = applyDelta(objId, instId, &frame[dataOffset], dataLength);
+
+            // Undecodable until the next complete copy of the object
+            if (objData == NULL)
+                continue;
+
+            receiveObject(TYPE_OBJ, objId, instId, (quint8 *)objData->constData(), objData->size());
+        }
+        else
+        {
+            // Complete logs never need a reference, so only keep them
+            // once the stream turned out to be delta encoded
+            if (timestamped && type == TYPE_OBJ && deltaEncoded)
+            {
+                DeltaReference &ref = deltaRefs[((quint64)objId << 16) | instId];
+                ref.data.resize(dataLength);
+                memcpy(ref.data.data(), &frame[dataOffset], dataLength);
+                ref.keyframeStamp = qFromLittleEndian<quint16>(&frame[dataOffset - TIMESTAMP_LENGTH]);
+                ref.seq = 0;
+            }
+
+            receiveObject(type, objId, instId, &frame[dataOffset], dataLength);
+        }
+        if (useUDPMirror)
+        {
+            udpSocketTx->writeDatagram((const char*)frame, size + CHECKSUM_LENGTH,
+                    QHostAddress::LocalHost, udpSocketRx->localPort());
+        }
+        stats.rxObjectBytes += dataLength;
+        stats.rxObjects++;
+    }
+
+    return pos;
+}
+
+/**
+ * Rebuild object data from a delta packet and the data it is relative to,
+ * see uavtalk_delta.h for the layout. The delta must name the keyframe the
+ * data comes from and follow on from the last delta applied to it,
+ * otherwise a packet has been lost.
+ * \param[in] objId Object ID
+ * \param[in] instId The instance ID
+ * \param[in] payload Delta packet payload
+ * \param[in] length Payload length
+ * \return The object data, NULL if it can not be rebuilt
+ */
+const QByteArray *UAVTalk::applyDelta(quint32 objId, quint16 instId, const quint8 *payload, qint32 length)
+{
+    QHash<quint64, DeltaReference>::iterator ref = deltaRefs.find(((quint64)objId << 16) | instId);
+    if (ref == deltaRefs.end())
+        return NULL;
+
+    if (!uavtalk_delta_follows(payload, ref->keyframeStamp, ref->seq) ||
+            uavtalk_delta_apply((uint8_t *)ref->data.data(), ref->data.size(), payload, length) < 0)
+    {
+        deltaRefs.erase(ref);
+        return NULL;
+    }
+
+    ref->seq++;
+
+    return &ref->data;
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -744,6 +957,63 @@ bool UAVTalk::transmitNack(quint32 objId)
  * \return Success (true), Failure (false)
  */
 bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances)
+{
+    qint32 length;
+    qint32 size = packFrame(obj, type, allInstances, txBuffer, &length);
+
+    if (size < 0)
+    {
+        return false;
+    }
+
+    if (!transmitFrame(txBuffer, size))
+    {
+        return false;
+    }
+
+    // Update stats
+    ++stats.txObjects;
+    stats.txObjectBytes += length;
+
+    // Done
+    return true;
+}
+
+/**
+ * Encode an object into a complete frame, without sending it. Lets
+ * callers sending the same update over several links encode it once.
+ * \param[in] obj Object handle to encode
+ * \param[out] payloadLength Length of the object data in the frame, if not NULL
+ * \return The frame, empty on failure
+ */
+QByteArray UAVTalk::encodeObject(UAVObject* obj, qint32 *payloadLength)
+{
+    quint8 buffer[MAX_PACKET_LENGTH];
+    qint32 length;
+    qint32 size = packFrame(obj, TYPE_OBJ, false, buffer, &length);
+
+    if (size < 0)
+    {
+        return QByteArray();
+    }
+
+    if (payloadLength)
+    {
+        *payloadLength = length;
+    }
+
+    return QByteArray((const char*)buffer, size);
+}
+
+/**
+ * Build a frame for an object.
+ * \param[in] obj Object handle to pack
+ * \param[in] type Transaction type
+ * \param[out] buffer At least MAX_PACKET_LENGTH bytes
+ * \param[out] payloadLength Length of the object data in the frame
+ * \return Length of the frame, or -1 on failure
+ */
+qint32 UAVTalk::packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8 *buffer, qint32 *payloadLength)
 {
     qint32 length;
     qint32 dataOffset;
@@ -753,9 +1023,9 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
 
     // Setup type and object id fields
     objId = obj->getObjID();
-    txBuffer[0] = SYNC_VAL;
-    txBuffer[1] = type;
-    qToLittleEndian<quint32>(objId, &txBuffer[4]);
+    buffer[0] = SYNC_VAL;
+    buffer[1] = type;
+    qToLittleEndian<quint32>(objId, &buffer[4]);
 
     // Setup instance ID if one is required
     if ( obj->isSingleInstance() )
@@ -767,12 +1037,12 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
         // Check if all instances are requested
         if (allInstances)
         {
-            qToLittleEndian<quint16>(allInstId, &txBuffer[8]);
+            qToLittleEndian<quint16>(allInstId, &buffer[8]);
         }
         else
         {
             instId = obj->getInstID();
-            qToLittleEndian<quint16>(instId, &txBuffer[8]);
+            qToLittleEndian<quint16>(instId, &buffer[8]);
         }
         dataOffset = 10;
     }
@@ -790,30 +1060,42 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
     // Check length
     if (length >= MAX_PAYLOAD_LENGTH)
     {
-        return false;
+        return -1;
     }
 
     // Copy data (if any)
     if (length > 0)
     {
-        if ( !obj->pack(&txBuffer[dataOffset]) )
+        if ( !obj->pack(&buffer[dataOffset]) )
         {
-            return false;
+            return -1;
         }
     }
 
-    qToLittleEndian<quint16>(dataOffset + length, &txBuffer[2]);
+    qToLittleEndian<quint16>(dataOffset + length, &buffer[2]);
 
     // Calculate checksum
-    txBuffer[dataOffset+length] = updateCRC(0, txBuffer, dataOffset + length);
+    buffer[dataOffset+length] = updateCRC(0, buffer, dataOffset + length);
+
+    *payloadLength = length;
+    return dataOffset + length + CHECKSUM_LENGTH;
+}
 
+/**
+ * Write a complete frame to the link.
+ * \param[in] frame Frame as built by packFrame()
+ * \param[in] size Length of the frame
+ * \return Success (true), Failure (false) if the transmit backlog is full
+ */
+bool UAVTalk::transmitFrame(const quint8 *frame, qint32 size)
+{
     // Send buffer, check that the transmit backlog does not grow above limit
     if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
     {
-        io->write((const char*)txBuffer, dataOffset+length+CHECKSUM_LENGTH);
+        io->write((const char*)frame, size);
         if(useUDPMirror)
         {
-            udpSocketRx->writeDatagram((const char*)txBuffer,dataOffset+length+CHECKSUM_LENGTH,QHostAddress::LocalHost,udpSocketTx->localPort());
+            udpSocketRx->writeDatagram((const char*)frame,size,QHostAddress::LocalHost,udpSocketTx->localPort());
         }
     }
     else
@@ -822,12 +1104,8 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
         return false;
     }
 
-    // Update stats
-    ++stats.txObjects;
-    stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
-    stats.txObjectBytes += length;
+    stats.txBytes += size;
 
-    // Done
     return true;
 }
 
@@ -68,6 +68,9 @@ public:
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    void processInputBlock(const quint8 *data, qint64 length);
+
+    static QByteArray encodeObject(UAVObject* obj, qint32 *payloadLength = NULL);
 
 signals:
     // The only signals we send to the upper level are when we
@@ -89,10 +92,13 @@ protected:
     static const int TYPE_OBJ_ACK = (TYPE_VER | 0x02);
     static const int TYPE_ACK = (TYPE_VER | 0x03);
     static const int TYPE_NACK = (TYPE_VER | 0x04);
+    static const int TYPE_OBJ_DELTA = (TYPE_VER | 0x05); // Only sent timestamped
+    static const int TIMESTAMPED = 0x80;
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = 10; // sync(1), type (1), size(2), object ID (4), instance ID(2, not used in single objects)
 
+    static const int TIMESTAMP_LENGTH = 2;
     static const int CHECKSUM_LENGTH = 1;
 
     static const int MAX_PAYLOAD_LENGTH = 256;
@@ -103,6 +109,7 @@ protected:
     static const quint16 OBJID_NOTFOUND = 0x0000;
 
     static const int TX_BUFFER_SIZE = 2*1024;
+    static const int RX_STREAM_BUFFER_SIZE = 8*1024;
     static const quint8 crc_table[256];
 
     // Types
@@ -127,20 +134,40 @@ protected:
     RxStateType rxState;
     ComStats stats;
 
+    // Bulk receive buffer, holds at most one partial packet between reads
+    quint8 rxStreamBuffer[RX_STREAM_BUFFER_SIZE];
+    qint32 rxStreamFill;
+
     bool useUDPMirror;
     QUdpSocket * udpSocketTx;
     QUdpSocket * udpSocketRx;
     QByteArray rxDataArray;
 
+    // Last data received timestamped per object instance, which delta
+    // packets from onboard logs are relative to
+    typedef struct {
+        QByteArray data;
+        quint16 keyframeStamp;
+        quint8 seq;
+    } DeltaReference;
+    QHash<quint64, DeltaReference> deltaRefs;
+    // Set by the first delta packet, until then no references are kept
+    bool deltaEncoded;
+
     // Methods
+    void processStreamBuffer();
+    qint32 processInputFrames(quint8 *data, qint32 length);
+    const QByteArray *applyDelta(quint32 objId, quint16 instId, const quint8 *payload, qint32 length);
     bool objectTransaction(UAVObject* obj, quint8 type, bool allInstances);
     virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
     UAVObject* updateObject(quint32 objId, quint16 instId, quint8* data);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
-    quint8 updateCRC(quint8 crc, const quint8 data);
-    quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
+    bool transmitFrame(const quint8 *frame, qint32 size);
+    static qint32 packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8 *buffer, qint32 *payloadLength);
+    static quint8 updateCRC(quint8 crc, const quint8 data);
+    static quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
 };
 
 #endif // UAVTALK_H
@@ -31,23 +31,88 @@
 FilteredUavTalk::FilteredUavTalk(QIODevice *iodev, UAVObjectManager *objMngr,
                                  QHash<quint32,UavTalkRelayComon::accessType> rules,
                                  UavTalkRelayComon::accessType defaultRule) :
-    UAVTalk(iodev,objMngr),m_rules(rules),m_defaultRule(defaultRule)
+    UAVTalk(iodev,objMngr),m_rules(rules),m_defaultRule(defaultRule),
+    m_receiving(false),m_receivingObjId(0),m_queueBytes(0)
 {
+    connect(iodev, SIGNAL(bytesWritten(qint64)), this, SLOT(flushQueue()));
 }
 
 /**
- * @brief FilteredUavTalk::sendObjectSlot Called whenever an object is updated by
- * the local GCS and sends it to the remote GCS is the rules allow it.
- * @param obj The UAVObject to possibly send
+ * @brief FilteredUavTalk::addObject Looks up the rule for an object once, so
+ * that relaying an update to it is a bit test instead of a hash lookup.
+ * @param index The relay's index for the object
+ * @param objId The ID of the object
  */
-void FilteredUavTalk::sendObjectSlot(UAVObject *obj)
+void FilteredUavTalk::addObject(int index, quint32 objId)
 {
-    UavTalkRelayComon::accessType access=m_rules.value(obj->getObjID(),m_defaultRule);
-    if(access==UavTalkRelayComon::WriteOnly || access==UavTalkRelayComon::None)
-        return;
-    if(obj==GCSTelemetryStats::GetInstance(objMngr))
+    UavTalkRelayComon::accessType access=m_rules.value(objId,m_defaultRule);
+    if(index>=m_readable.size())
+        m_readable.resize(index+1);
+    m_readable.setBit(index, access==UavTalkRelayComon::ReadOnly || access==UavTalkRelayComon::ReadWrite);
+}
+
+/**
+ * @brief FilteredUavTalk::queueFrame Sends an encoded object update to the remote
+ * GCS, or queues it if the socket is backed up.
+ * @param obj The UAVObject the frame was encoded from
+ * @param frame The encoded frame, shared with the other clients
+ * @param payloadLength Length of the object data in the frame
+ */
+void FilteredUavTalk::queueFrame(UAVObject *obj, const QByteArray &frame, qint32 payloadLength)
+{
+    quint64 key=((quint64)obj->getObjID() << 16) | obj->getInstID();
+    QHash<quint64, QueuedFrame>::iterator queued=m_queue.find(key);
+    if(queued!=m_queue.end()) {
+        // Supersedes the update still waiting, and keeps its place in line
+        m_queueBytes+=frame.size()-queued->frame.size();
+        queued->frame=frame;
+        queued->payloadLength=payloadLength;
         return;
-    sendObject(obj,false,false);
+    }
+    QueuedFrame entry;
+    entry.frame=frame;
+    entry.payloadLength=payloadLength;
+    m_queue.insert(key,entry);
+    m_queueOrder.append(key);
+    m_queueBytes+=frame.size();
+    while(m_queueBytes>RELAY_QUEUE_SIZE && m_queueOrder.size()>1) {
+        m_queueBytes-=m_queue.take(m_queueOrder.takeFirst()).frame.size();
+        ++stats.txErrors;
+    }
+    flushQueue();
+}
+
+/**
+ * @brief FilteredUavTalk::flushQueue Writes queued frames while the socket
+ * backlog is below the limit.
+ */
+void FilteredUavTalk::flushQueue()
+{
+    while(!m_queueOrder.isEmpty() && !io.isNull() && io->bytesToWrite()<TX_BUFFER_SIZE) {
+        QueuedFrame entry=m_queue.take(m_queueOrder.takeFirst());
+        m_queueBytes-=entry.frame.size();
+        if(!transmitFrame((const quint8 *)entry.frame.constData(),entry.frame.size()))
+            break;
+        ++stats.txObjects;
+        stats.txObjectBytes+=entry.payloadLength;
+    }
+}
+
+/**
+ * @brief FilteredUavTalk::updateFromSlave Updates an object with data from the
+ * remote GCS without relaying the update back to it.
+ * @return The updated object, NULL on failure
+ */
+UAVObject *FilteredUavTalk::updateFromSlave(quint32 objId, quint16 instId, quint8 *data)
+{
+    m_receiving=true;
+    m_receivingObjId=objId;
+    UAVObject *obj=updateObject(objId, instId, data);
+    m_receiving=false;
+    UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(objMngr->getObject(objId));
+    if(mobj)
+        mobj->updated();
+    return obj;
 }
 
 /**
@@ -80,14 +145,7 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         if (!allInstances)
         {
             // Get object and update its data
-            UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
-            obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
-            UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
-            if(mobj)
-                tobj->updated();
+            obj = updateFromSlave(objId, instId, data);
             if (obj == NULL)
                 error = true;
         }
@@ -101,14 +159,7 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         if (!allInstances)
         {
             // Get object and update its data
-            UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
-            obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
-            UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
-            if(mobj)
-                tobj->updated();
+            obj = updateFromSlave(objId, instId, data);
             // Transmit ACK
             if ( obj != NULL )
             {
@@ -29,12 +29,19 @@
 
 #include "../uavtalk/uavtalk.h"
 #include <QHash>
+#include <QList>
+#include <QBitArray>
 #include "uavtalkrelay_global.h"
 
 /**
  * @brief The FilteredUavTalk class An extension of the UAVTalk class to be run on the master
  * GCS (the one which also has a connection to the UAV) which will relay object updates to
  * a slave GCS subject to certain filtering rules which this class enforces.
+ *
+ * Updates are encoded once by the relay and handed to every client as a shared frame.
+ * A client that cannot keep up has its frames queued; a newer update to an object
+ * replaces the one still waiting, and the oldest frames are dropped once the queue
+ * is full, so a slow client gets the latest state instead of a growing backlog.
  */
 class UAVTALKRELAY_EXPORT FilteredUavTalk:public UAVTalk
 {
@@ -45,14 +52,42 @@ public:
     //! Called when an uavtalk packet is received from the slave.  Updates master based on filtering rules
     bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
 
-public slots:
-    //! Called whenever an object is updated either locally in the master GCS or from the main
-    //! telemetry connection, but NOT as a consquence of the receiveObject method
-    void sendObjectSlot(UAVObject *obj);
+    //! Precompute whether the slave may read the object the relay knows as index
+    void addObject(int index, quint32 objId);
+    //! True if updates to the object at index are sent to the slave
+    bool isReadable(int index) const { return index >= 0 && index < m_readable.size() && m_readable.testBit(index); }
+    //! True if obj is being updated by this slave, and must not be echoed back to it
+    bool isEcho(UAVObject *obj) const { return m_receiving && obj->getObjID() == m_receivingObjId; }
+
+    void queueFrame(UAVObject *obj, const QByteArray &frame, qint32 payloadLength);
+    //! Bytes of frames waiting for the socket
+    qint32 queuedBytes() const { return m_queueBytes; }
+
+private slots:
+    void flushQueue();
 
 private:
+    UAVObject *updateFromSlave(quint32 objId, quint16 instId, quint8 *data);
+
+    // Bytes of frames a slow client may have waiting before the oldest are dropped
+    static const int RELAY_QUEUE_SIZE = 16*1024;
+
+    typedef struct {
+        QByteArray frame;
+        qint32 payloadLength;
+    } QueuedFrame;
+
     QHash<quint32,UavTalkRelayComon::accessType> m_rules;
     UavTalkRelayComon::accessType m_defaultRule;
+    QBitArray m_readable;
+
+    bool m_receiving;
+    quint32 m_receivingObjId;
+
+    // Frames waiting for the socket, keyed by object and instance, oldest first
+    QHash<quint64, QueuedFrame> m_queue;
+    QList<quint64> m_queueOrder;
+    qint32 m_queueBytes;
 };
 
 #endif // FILTEREDUAVTALK_H
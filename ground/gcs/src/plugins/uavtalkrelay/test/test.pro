@@ -0,0 +1,25 @@
+include(../../../../gcs.pri)
+
+QT += testlib network qml
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = tst_filtereduavtalk
+TEMPLATE = app
+
+# The relay, UAVObjects and UAVTalk libraries live with the plugins
+LIBS += -L$$GCS_PLUGIN_PATH/dRonin
+INCLUDEPATH *= $$PWD/.. $$GCS_SOURCE_TREE/src/plugins
+linux-* {
+    QMAKE_LFLAGS += -Wl,-rpath,$$GCS_PLUGIN_PATH/dRonin
+}
+
+LIBS *= -l$$qtLibraryName(UAVTalkRelay)
+include(../../uavtalk/uavtalk.pri)
+include(../uavtalkrelay_dependencies.pri)
+
+SOURCES += tst_filtereduavtalk.cpp
+
+SOURCES += $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp
@@ -0,0 +1,278 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_filtereduavtalk.cpp
+ * @author     dRonin, http://dRonin.org Copyright (C) 2016
+ * @brief      Checks the queue of a relay client that cannot keep up
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QtTest/QtTest>
+
+#include <QtCore/QIODevice>
+#include <QtCore/QObject>
+
+#include "filtereduavtalk.h"
+#include "gcstelemetrystats.h"
+#include "uavobjectmanager.h"
+#include "uavobjects/uavobjectsinit.h"
+
+// Same as UAVTalk::TX_BUFFER_SIZE, above it the client is backed up
+#define TX_BUFFER_SIZE (2*1024)
+
+// Same as FilteredUavTalk::RELAY_QUEUE_SIZE
+#define RELAY_QUEUE_SIZE (16*1024)
+
+// Size of the frames used to fill the queue
+#define FRAME_SIZE 1000
+
+/**
+ * Client socket whose backlog is set by the test. Written bytes are
+ * recorded, received bytes are fed in by the test.
+ */
+class FakeSocket : public QIODevice
+{
+public:
+    FakeSocket() : backlog(0)
+    {
+        open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const { return true; }
+    qint64 bytesToWrite() const { return backlog; }
+    qint64 bytesAvailable() const { return input.size(); }
+
+    //! Pretend the socket has drained, and tell the client
+    void drain()
+    {
+        backlog = 0;
+        emit bytesWritten(0);
+    }
+
+    //! Hand bytes to the client as if they came from the remote GCS
+    void receive(const QByteArray &bytes)
+    {
+        input.append(bytes);
+        emit readyRead();
+    }
+
+    qint64 backlog;
+    QByteArray written;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        qint64 count = qMin<qint64>(maxSize, input.size());
+        memcpy(data, input.constData(), count);
+        input.remove(0, count);
+        return count;
+    }
+
+    qint64 writeData(const char *data, qint64 maxSize)
+    {
+        written.append(data, maxSize);
+        return maxSize;
+    }
+
+private:
+    QByteArray input;
+};
+
+class tst_FilteredUavTalk : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void supersedesQueuedUpdate();
+    void dropsOldestWhenFull();
+    void suppressesEchoToSender();
+
+public slots:
+    void recordEcho(UAVObject *obj);
+
+private:
+    FilteredUavTalk *newClient(FakeSocket *io);
+    QList<UAVObject *> dataObjects(int count);
+
+    UAVObjectManager *m_objMngr;
+
+    FilteredUavTalk *m_sender;
+    FilteredUavTalk *m_other;
+    QList<bool> m_senderEchoes;
+    QList<bool> m_otherEchoes;
+};
+
+void tst_FilteredUavTalk::initTestCase()
+{
+    m_objMngr = new UAVObjectManager;
+    UAVObjectsInitialize(m_objMngr);
+}
+
+void tst_FilteredUavTalk::cleanupTestCase()
+{
+    delete m_objMngr;
+}
+
+/**
+ * A client that may read and write every object
+ */
+FilteredUavTalk *tst_FilteredUavTalk::newClient(FakeSocket *io)
+{
+    return new FilteredUavTalk(io, m_objMngr,
+            QHash<quint32, UavTalkRelayComon::accessType>(),
+            UavTalkRelayComon::ReadWrite);
+}
+
+/**
+ * The first instance of count data objects the relay forwards
+ */
+QList<UAVObject *> tst_FilteredUavTalk::dataObjects(int count)
+{
+    QList<UAVObject *> objs;
+    foreach (const QVector<UAVObject *> &instances, m_objMngr->getObjectsVector()) {
+        UAVObject *obj = instances.first();
+        if (!dynamic_cast<UAVDataObject *>(obj) || obj->getObjID() == GCSTelemetryStats::OBJID)
+            continue;
+        objs.append(obj);
+        if (objs.size() == count)
+            break;
+    }
+    return objs;
+}
+
+/**
+ * A newer update to an object replaces the one still waiting, in its place
+ * in the queue
+ */
+void tst_FilteredUavTalk::supersedesQueuedUpdate()
+{
+    QList<UAVObject *> objs = dataObjects(2);
+    QCOMPARE(objs.size(), 2);
+
+    FakeSocket io;
+    FilteredUavTalk *client = newClient(&io);
+    io.backlog = TX_BUFFER_SIZE + 1;
+
+    QByteArray first(FRAME_SIZE, 'a');
+    QByteArray other(FRAME_SIZE / 2, 'b');
+    QByteArray newer(FRAME_SIZE / 4, 'c');
+
+    client->queueFrame(objs[0], first, first.size());
+    client->queueFrame(objs[1], other, other.size());
+    QCOMPARE(client->queuedBytes(), first.size() + other.size());
+
+    client->queueFrame(objs[0], newer, newer.size());
+    QCOMPARE(client->queuedBytes(), newer.size() + other.size());
+    QVERIFY(io.written.isEmpty());
+
+    io.drain();
+    QCOMPARE(io.written, newer + other);
+    QCOMPARE(client->queuedBytes(), 0);
+
+    UAVTalk::ComStats stats = client->getStats();
+    QCOMPARE(stats.txObjects, 2u);
+    QCOMPARE(stats.txObjectBytes, (quint32) (newer.size() + other.size()));
+    QCOMPARE(stats.txErrors, 0u);
+
+    delete client;
+}
+
+/**
+ * The queue never holds more than RELAY_QUEUE_SIZE, the oldest frames are
+ * dropped and counted as transmit errors
+ */
+void tst_FilteredUavTalk::dropsOldestWhenFull()
+{
+    const int fits = RELAY_QUEUE_SIZE / FRAME_SIZE;
+    const int extra = 4;
+
+    QList<UAVObject *> objs = dataObjects(fits + extra);
+    QCOMPARE(objs.size(), fits + extra);
+
+    FakeSocket io;
+    FilteredUavTalk *client = newClient(&io);
+    io.backlog = TX_BUFFER_SIZE + 1;
+
+    for (int i = 0; i < objs.size(); i++) {
+        client->queueFrame(objs[i], QByteArray(FRAME_SIZE, (char) ('A' + i)), FRAME_SIZE);
+        QVERIFY(client->queuedBytes() <= RELAY_QUEUE_SIZE);
+        QCOMPARE(client->getStats().txErrors, (quint32) qMax(0, i + 1 - fits));
+    }
+    QCOMPARE(client->queuedBytes(), fits * FRAME_SIZE);
+    QVERIFY(io.written.isEmpty());
+
+    io.drain();
+
+    QByteArray expected;
+    for (int i = extra; i < objs.size(); i++)
+        expected.append(QByteArray(FRAME_SIZE, (char) ('A' + i)));
+    QCOMPARE(io.written, expected);
+    QCOMPARE(client->queuedBytes(), 0);
+    QCOMPARE(client->getStats().txObjects, (quint32) fits);
+    QCOMPARE(client->getStats().txErrors, (quint32) extra);
+
+    delete client;
+}
+
+void tst_FilteredUavTalk::recordEcho(UAVObject *obj)
+{
+    m_senderEchoes.append(m_sender->isEcho(obj));
+    m_otherEchoes.append(m_other->isEcho(obj));
+}
+
+/**
+ * An update received from one client is only an echo for that client, the
+ * others still get it
+ */
+void tst_FilteredUavTalk::suppressesEchoToSender()
+{
+    QList<UAVObject *> objs = dataObjects(1);
+    QCOMPARE(objs.size(), 1);
+    UAVObject *obj = objs[0];
+
+    FakeSocket senderIo;
+    FakeSocket otherIo;
+    m_sender = newClient(&senderIo);
+    m_other = newClient(&otherIo);
+    m_senderEchoes.clear();
+    m_otherEchoes.clear();
+
+    QByteArray frame = UAVTalk::encodeObject(obj);
+    QVERIFY(!frame.isEmpty());
+
+    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(recordEcho(UAVObject *)));
+    senderIo.receive(frame);
+    disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(recordEcho(UAVObject *)));
+
+    QCOMPARE(m_senderEchoes, QList<bool>() << true);
+    QCOMPARE(m_otherEchoes, QList<bool>() << false);
+
+    // Once the update is delivered, nothing is an echo any more
+    QVERIFY(!m_sender->isEcho(obj));
+    QVERIFY(!m_other->isEcho(obj));
+
+    delete m_sender;
+    delete m_other;
+}
+
+QTEST_MAIN(tst_FilteredUavTalk)
+
+#include "tst_filtereduavtalk.moc"
@@ -29,9 +29,17 @@
 #include "QMessageBox"
 #include <QPointer>
 #include "filtereduavtalk.h"
+#include "gcstelemetrystats.h"
 
 UavTalkRelay::UavTalkRelay(UAVObjectManager *ObjMngr, QString IpAdress, quint16 Port,QHash<QString,QHash<quint32,UavTalkRelayComon::accessType> > rules,UavTalkRelayComon::accessType defaultRule):m_IpAddress(IpAdress),m_Port(Port),m_ObjMngr(ObjMngr),m_rules(rules),m_DefaultRule(defaultRule)
 {
+    QVector< QVector<UAVObject*> > list = m_ObjMngr->getObjectsVector();
+    foreach (const QVector<UAVObject*> &instances, list)
+        foreach (UAVObject *obj, instances)
+            registerObject(obj);
+    connect(m_ObjMngr, SIGNAL(newObject(UAVObject*)), this, SLOT(registerObject(UAVObject*)));
+    connect(m_ObjMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(registerObject(UAVObject*)));
+
     tcpServer = new QTcpServer(this);
     // if we did not find one, use IPv4 localhost
     if (m_IpAddress.isEmpty())
@@ -83,19 +91,53 @@ void UavTalkRelay::newConnection()
     uavTalkList.append(uav);
     connect(clientConnection, SIGNAL(disconnected()),
             uav, SLOT(deleteLater()));
-    QVector< QVector<UAVObject*> > list = m_ObjMngr->getObjectsVector();
-    QVector< QVector<UAVObject*> >::const_iterator i;
-    QVector<UAVObject*>::const_iterator j;
-    int objects = 0;
+    QHash<quint32,int>::const_iterator i;
+    for (i = m_objIndex.constBegin(); i != m_objIndex.constEnd(); ++i)
+        uav->addObject(i.value(), i.key());
+}
 
-    const QVector< QVector<UAVObject*> >::iterator iEnd = list.end();
-    for (i = list.constBegin(); i != iEnd; ++i)
-    {
-        QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
-        for (j = (*i).constBegin(); j != jEnd; ++j)
-        {
-            connect(*j, SIGNAL(objectUpdated(UAVObject*)), uav.data(), SLOT(sendObjectSlot(UAVObject*)));
-            objects++;
+/**
+ * @brief UavTalkRelay::registerObject Starts relaying updates to an object
+ * @param obj The new object or instance
+ */
+void UavTalkRelay::registerObject(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(relayObject(UAVObject*)), Qt::UniqueConnection);
+    if (m_objIndex.contains(obj->getObjID()))
+        return;
+    int index = m_objIndex.size();
+    m_objIndex.insert(obj->getObjID(), index);
+    foreach (FilteredUavTalk *uav, uavTalkList)
+        if (uav)
+            uav->addObject(index, obj->getObjID());
+}
+
+/**
+ * @brief UavTalkRelay::relayObject Called whenever an object is updated, either
+ * locally or from the main telemetry connection. Encodes the update once and
+ * hands it to every client whose rules allow reading it.
+ * @param obj The UAVObject to relay
+ */
+void UavTalkRelay::relayObject(UAVObject *obj)
+{
+    if (uavTalkList.isEmpty() || obj->getObjID() == GCSTelemetryStats::OBJID)
+        return;
+    int index = m_objIndex.value(obj->getObjID(), -1);
+    QByteArray frame;
+    qint32 payloadLength = 0;
+    QList< QPointer<FilteredUavTalk> >::iterator uav = uavTalkList.begin();
+    while (uav != uavTalkList.end()) {
+        if (uav->isNull()) {
+            uav = uavTalkList.erase(uav);
+            continue;
+        }
+        if ((*uav)->isReadable(index) && !(*uav)->isEcho(obj)) {
+            if (frame.isEmpty())
+                frame = UAVTalk::encodeObject(obj, &payloadLength);
+            if (frame.isEmpty())
+                return;
+            (*uav)->queueFrame(obj, frame, payloadLength);
         }
+        ++uav;
     }
 }
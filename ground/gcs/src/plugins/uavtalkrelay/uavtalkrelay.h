@@ -48,6 +48,8 @@ public:
     void restartServer();
 private slots:
     void newConnection();
+    void registerObject(UAVObject *obj);
+    void relayObject(UAVObject *obj);
 private:
     QString m_IpAddress;
     quint16 m_Port;
@@ -58,6 +60,8 @@ private:
     QHash<QString,QHash<quint32,UavTalkRelayComon::accessType> > m_rules;
     UavTalkRelayComon::accessType m_DefaultRule;
     QList< QPointer<FilteredUavTalk> > uavTalkList;
+    // Dense index of each object ID, for the clients' precomputed rules
+    QHash<quint32,int> m_objIndex;
 };
 
 #endif // UAVTALKRELAY_H
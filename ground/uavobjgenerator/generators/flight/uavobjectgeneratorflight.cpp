@@ -39,6 +39,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
             <<"uint16_t" << "uint32_t" << "float" << "uint8_t";
 
     QString flightObjInit,objInc,objFileNames,objNames;
+    QList<quint32> objIds;
     qint32 sizeCalc;
     flightCodePath = QDir( templatepath + QString("flight/UAVObjects"));
     flightOutputPath = QDir( outputpath + QString("flight") );
@@ -63,6 +64,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
         objInc.append("#include \"" + info->namelc + ".h\"\r\n");
 	objFileNames.append(" " + info->namelc);
 	objNames.append(" " + info->name);
+	objIds.append(info->id);
 	if (parser->getNumBytes(objidx)>sizeCalc) {
 		sizeCalc = parser->getNumBytes(objidx);
 	}
@@ -80,6 +82,15 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
 
     // Write the flight object initialization header
     flightInitIncludeTemplate.replace( QString("$(SIZECALCULATION)"), QString().setNum(sizeCalc));
+
+    // Sorted so the object manager can binary search it instead of walking its object list
+    QString sortedIds;
+    qSort(objIds);
+    foreach (quint32 id, objIds) {
+        sortedIds.append(QString(" \\\r\n\t0x%1,").arg(id, 8, 16, QChar('0')));
+    }
+    flightInitIncludeTemplate.replace( QString("$(OBJCOUNT)"), QString().setNum(objIds.length()));
+    flightInitIncludeTemplate.replace( QString("$(OBJIDS)"), sortedIds);
     res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/uavobjectsinit.h",
                      flightInitIncludeTemplate );
     if (!res) {
@@ -370,6 +370,20 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     }
     outCode.replace(QString("$(FIELDSINIT)"), finit);
 
+    // Replace the $(FIELDLAYOUT) tag
+    QString layout;
+    int layoutOffset = 0;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        FieldInfo *field = info->fields[n];
+        layout.append( QString("    { %1, %2, %3 },\n")
+                       .arg(layoutOffset)
+                       .arg(field->numElements)
+                       .arg(field->numBytes) );
+        layoutOffset += field->numBytes * field->numElements;
+    }
+    outCode.replace(QString("$(FIELDLAYOUT)"), layout);
+
     // Replace the $(DATAFIELDINFO) tag
     QString name;
     // To be populated with the enums definition
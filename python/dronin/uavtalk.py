@@ -27,6 +27,8 @@ from six import int2byte, indexbytes, byte2int, iterbytes
 (TYPE_MASK, TYPE_VER) = (0x78, 0x20)
 (TIMESTAMPED) = (0x80)
 (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x80, 0x82)
+(TYPE_OBJ_DELTA_TS) = (0x85)
+(DELTA_HEADER_LENGTH) = (3)
 
 # Serialization of header elements
 
@@ -35,6 +37,8 @@ header_fmt = Struct("<BBHL")
 logheader_fmt = Struct("<IQ")
 timestamp_fmt = Struct("<H")
 instance_fmt = Struct("<H")
+# keyframe timestamp(2) + sequence(1)
+delta_header_fmt = Struct("<HB")
 
 # CRC lookup table
 crc_table = [
@@ -56,6 +60,53 @@ crc_table = [
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 ]
 
+def apply_delta(reference, payload):
+    """Rebuilds object data from a delta packet payload and the data it is
+    relative to.
+
+    The payload is the timestamp of the keyframe the reference comes from
+    and a sequence number, followed by runs of changed bytes, each the count
+    of unchanged bytes before it and its length as varints, then the changed
+    bytes XORed with the reference.  See shared/api/uavtalk_delta.h.  The
+    header is not checked here.  Returns None if the payload is malformed."""
+
+    data = bytearray(reference)
+    payload = bytearray(payload)
+
+    def get_varint(i):
+        value = 0
+        shift = 0
+        while True:
+            b = payload[i]
+            i += 1
+            value |= (b & 0x7f) << shift
+            shift += 7
+            if not (b & 0x80):
+                return (value, i)
+
+    pos = 0
+    i = DELTA_HEADER_LENGTH
+
+    try:
+        while i < len(payload):
+            (skip, i) = get_varint(i)
+            (run_len, i) = get_varint(i)
+
+            pos += skip
+            if (run_len == 0 or pos + run_len > len(data)
+                    or i + run_len > len(payload)):
+                return None
+
+            for j in range(run_len):
+                data[pos + j] ^= payload[i + j]
+
+            pos += run_len
+            i += run_len
+    except IndexError:
+        return None
+
+    return data
+
 def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
         progress_callback=None):
     """Generator function that parses uavotalk stream.
@@ -77,6 +128,10 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
     pending_pieces = []
 
+    # Last data, keyframe timestamp and delta sequence number of each object
+    # instance, to decode delta packets
+    delta_refs = {}
+
     while True:
         # If we don't have sufficient data buffered, join up any chunks we've 
         # been given to ensure pending_pieces is empty for the rest of this loop.
@@ -180,7 +235,13 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
             timestamp_len = 0
             obj = None
         else:
-            if obj is not None:
+            if obj is not None and pack_type == TYPE_OBJ_DELTA_TS:
+                # Deltas are variable length, the CRC vouches for it
+                timestamp_len = timestamp_fmt.size
+                obj_len = pack_len - header_fmt.size - timestamp_len
+                if not obj._single:
+                    obj_len -= instance_fmt.size
+            elif obj is not None:
                 timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
                 obj_len = obj.get_size_of_data()
             else:
@@ -267,7 +328,37 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 
         if obj is not None:
             offset = header_fmt.size + instance_len + timestamp_len + buf_offset
-            objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
+
+            if pack_type == TYPE_OBJ_DELTA_TS:
+                # Only decodable following the packet it is relative to,
+                # otherwise wait for the next complete copy
+                ref = delta_refs.get((objId, instance_id))
+                data = None
+
+                if (obj_len >= DELTA_HEADER_LENGTH and ref is not None
+                        and delta_header_fmt.unpack_from(buf, offset) ==
+                            (ref[1], (ref[2] + 1) & 0xff)):
+                    data = apply_delta(ref[0], buf[offset:offset + obj_len])
+
+                if data is None:
+                    delta_refs.pop((objId, instance_id), None)
+                    obj = None
+                else:
+                    delta_refs[(objId, instance_id)] = [data, ref[1], ref[2] + 1]
+                    buf_data = bytes(data)
+                    buf_data_offset = 0
+            elif pack_type == TYPE_OBJ_TS:
+                delta_refs[(objId, instance_id)] = [
+                    bytearray(buf[offset:offset + obj_len]),
+                    timestamp_fmt.unpack_from(buf, offset - timestamp_len)[0], 0]
+                buf_data = buf
+                buf_data_offset = offset
+            else:
+                buf_data = buf
+                buf_data_offset = offset
+
+        if obj is not None:
+            objInstance = obj.from_bytes(buf_data, timestamp, instance_id, offset=buf_data_offset)
             received += 1
             if not (received % 10000):
                 if progress_callback is not None:
@@ -1,5 +1,6 @@
 #include <Python.h>
 #include "math.h"
+#include <time.h>
 
 #define NPY_NO_DEPRECATED_API 7
 #include "numpy/arrayobject.h"
@@ -7,6 +8,37 @@
 
 #include <insgps.h>
 
+/* The same wrapper is compiled once per estimator, see setup.py */
+#ifndef INS_MODULE_NAME
+#define INS_MODULE_NAME ins
+#endif
+
+#define INS_STR_(x) #x
+#define INS_STR(x) INS_STR_(x)
+#define INS_CAT_(a, b) a ## b
+#define INS_CAT(a, b) INS_CAT_(a, b)
+
+/**
+ * CPU time spent inside the estimator, excluding the python
+ * argument handling, so that the cost per update can be compared
+ * between estimators and between releases.
+ */
+static struct {
+	unsigned long long predictions;
+	unsigned long long prediction_ns;
+	unsigned long long prediction_max_ns;
+	unsigned long long corrections;
+	unsigned long long correction_ns;
+	unsigned long long correction_max_ns;
+} ins_timing;
+
+static unsigned long long timing_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 int not_doublevector(PyArrayObject *vec)
 {
 	if (PyArray_TYPE(vec) != NPY_DOUBLE) {
@@ -154,9 +186,17 @@ prediction(PyObject* self, PyObject* args)
 	if (!parseFloatVec3(vec_accel, accel_data))
 		return NULL;
 
+	unsigned long long start = timing_now_ns();
+
 	INSStatePrediction(gyro_data, accel_data, dT);
 	INSCovariancePrediction(dT);
 
+	unsigned long long elapsed = timing_now_ns() - start;
+	ins_timing.predictions++;
+	ins_timing.prediction_ns += elapsed;
+	if (elapsed > ins_timing.prediction_max_ns)
+		ins_timing.prediction_max_ns = elapsed;
+
 	if (false) {
 		const float zeros[3] = {0,0,0};
 		INSSetGyroBias(zeros);
@@ -188,8 +228,16 @@ correction(PyObject* self, PyObject* args)
 	if (!parseFloatVecN(vec_z, z, 10))
 		return NULL;
 
+	unsigned long long start = timing_now_ns();
+
 	INSCorrection(&z[6], &z[0], &z[3], z[9], sensors);
 
+	unsigned long long elapsed = timing_now_ns() - start;
+	ins_timing.corrections++;
+	ins_timing.correction_ns += elapsed;
+	if (elapsed > ins_timing.correction_max_ns)
+		ins_timing.correction_max_ns = elapsed;
+
 	return pack_state(self);
 }
 
@@ -294,10 +342,34 @@ set_state(PyObject* self, PyObject* args, PyObject *kwarg)
 }
 
 
+/**
+ * timing - report the time spent in the estimator since init
+ * @return dictionary with the number of predictions and corrections,
+ * and the total and worst case time spent in each in nanoseconds
+ */
+static PyObject*
+timing(PyObject* self, PyObject* args)
+{
+	return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K}",
+		"predictions", ins_timing.predictions,
+		"prediction_ns", ins_timing.prediction_ns,
+		"prediction_max_ns", ins_timing.prediction_max_ns,
+		"corrections", ins_timing.corrections,
+		"correction_ns", ins_timing.correction_ns,
+		"correction_max_ns", ins_timing.correction_max_ns);
+}
+
+static PyObject*
+num_states(PyObject* self, PyObject* args)
+{
+	return Py_BuildValue("i", ins_get_num_states());
+}
+
 static PyObject*
 init(PyObject* self, PyObject* args)
 {
 	INSGPSInit();
+	memset(&ins_timing, 0, sizeof(ins_timing));
 
 	const float Be[] = {400, 0, 1600};
 	INSSetMagNorth(Be);
@@ -312,13 +384,15 @@ static PyMethodDef InsMethods[] =
 	{"correction", correction, METH_VARARGS, "Apply state correction based on measured sensors."},
 	{"configure", (PyCFunction)configure, METH_VARARGS|METH_KEYWORDS, "Configure EKF parameters."},
 	{"set_state", (PyCFunction)set_state, METH_VARARGS|METH_KEYWORDS, "Set the EKF state."},
+	{"timing", timing, METH_VARARGS, "Time spent in the estimator since init."},
+	{"num_states", num_states, METH_VARARGS, "Number of states of this estimator."},
 	{NULL, NULL, 0, NULL}
 };
  
 PyMODINIT_FUNC
-initins(void)
+INS_CAT(init, INS_MODULE_NAME)(void)
 {
-	(void) Py_InitModule("ins", InsMethods);
+	(void) Py_InitModule(INS_STR(INS_MODULE_NAME), InsMethods);
 	import_array();
 	init(NULL, NULL);
 	INSGPSInit();
@@ -0,0 +1,479 @@
+#!/usr/bin/env python
+""" Replay the sensor data of flight logs through the attitude estimators.
+
+The Gyros, Accels, Magnetometer, BaroAltitude, GPSPosition and GPSVelocity
+objects of each log are fed, in log order, to one or more estimators as
+fast as they can run. The estimated attitude and position are written
+to a CSV file per log and estimator, and a summary line with the time
+spent per update is printed for each run so that batches of logs can be
+compared between filter settings and between releases.
+
+The EKFs are the flight code built by setup.py (ins, ins13, ins16). The
+complementary filter is a python transcription of the attitude part of
+updateAttitudeComplementary() in Modules/Attitude, its timing is python
+time and is only reported for completeness.
+
+Usage:
+   python setup.py build_ext --inplace
+   python replay_log.py -e ins -e ins13 -o results flight1.drlog flight2.drlog
+"""
+
+from __future__ import print_function
+
+import importlib
+import math
+import os
+import sys
+import time
+
+import numpy
+
+# Allow running from a source tree without installing the dronin package
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+DEG2RAD = math.pi / 180.0
+RAD2DEG = 180.0 / math.pi
+
+# Sensor masks, these must match the values in insgps.h
+HORIZ_POS_SENSORS = 0x003
+HORIZ_VEL_SENSORS = 0x018
+VERT_VEL_SENSORS = 0x020
+MAG_SENSORS = 0x1C0
+BARO_SENSOR = 0x200
+
+# INSSettings and AttitudeSettings defaults, used when the log has none
+default_settings = {
+	'AccelVar' : [0.003, 0.003, 0.003],
+	'GyroVar' : [0.00001, 0.00001, 0.0001],
+	'MagVar' : [10, 10, 100],
+	'GpsVar' : [0.001, 0.01, 0.5],
+	'BaroVar' : 0.01,
+	'AccelKp' : 0.05,
+	'AccelKi' : 0.0001,
+	'MagKp' : 0.05,
+	'MagKi' : 0.0001,
+	'AccelTau' : 0.1,
+}
+
+# Same as the attitude module: seconds spent with the biases held at zero
+WARMUP_TIME = 10.0
+
+def rpy_to_quat(rpy):
+	""" RPY2Quaternion() from coordinate_conversions.c, angles in degrees """
+
+	phi, theta, psi = [DEG2RAD * a / 2 for a in rpy]
+
+	q = numpy.array([
+		math.cos(phi) * math.cos(theta) * math.cos(psi) + math.sin(phi) * math.sin(theta) * math.sin(psi),
+		math.sin(phi) * math.cos(theta) * math.cos(psi) - math.cos(phi) * math.sin(theta) * math.sin(psi),
+		math.cos(phi) * math.sin(theta) * math.cos(psi) + math.sin(phi) * math.cos(theta) * math.sin(psi),
+		math.cos(phi) * math.cos(theta) * math.sin(psi) - math.sin(phi) * math.sin(theta) * math.cos(psi)])
+
+	return -q if q[0] < 0 else q
+
+def quat_to_rpy(q):
+	""" Quaternion2RPY() from coordinate_conversions.c, angles in degrees """
+
+	q0, q1, q2, q3 = q
+	R13 = 2 * (q1 * q3 - q0 * q2)
+	R11 = q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3
+	R12 = 2 * (q1 * q2 + q0 * q3)
+	R23 = 2 * (q2 * q3 + q0 * q1)
+	R33 = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3
+
+	return [RAD2DEG * math.atan2(R23, R33),
+		RAD2DEG * math.asin(max(-1.0, min(1.0, -R13))),
+		RAD2DEG * math.atan2(R12, R11)]
+
+def quat_to_rbe(q):
+	""" Quaternion2R() from coordinate_conversions.c """
+
+	q0, q1, q2, q3 = q
+	return numpy.array([
+		[q0 * q0 + q1 * q1 - q2 * q2 - q3 * q3, 2 * (q1 * q2 + q0 * q3), 2 * (q1 * q3 - q0 * q2)],
+		[2 * (q1 * q2 - q0 * q3), q0 * q0 - q1 * q1 + q2 * q2 - q3 * q3, 2 * (q2 * q3 + q0 * q1)],
+		[2 * (q1 * q3 + q0 * q2), 2 * (q2 * q3 - q0 * q1), q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3]])
+
+class EKFEstimator:
+	""" One of the INSGPS filters, through the insmodule.c wrapper """
+
+	def __init__(self, name, settings):
+		self.name = name
+		self.ins = importlib.import_module(name)
+		self.settings = settings
+
+	def start(self, q, pos, Be):
+		s = self.settings
+		self.ins.init()
+		self.ins.configure(mag_var=numpy.array(s['MagVar'], numpy.float64),
+			accel_var=numpy.array(s['AccelVar'], numpy.float64),
+			gyro_var=numpy.array(s['GyroVar'], numpy.float64),
+			baro_var=s['BaroVar'],
+			gps_var=numpy.array(s['GpsVar'], numpy.float64))
+		self.ins.set_state(pos=numpy.array(pos, numpy.float64),
+			vel=numpy.zeros(3), q=numpy.array(q, numpy.float64),
+			gyro_bias=numpy.zeros(3), accel_bias=numpy.zeros(3))
+		self.Be = Be
+		self.state = None
+
+	def set_gps_accuracy(self, pos_accuracy, vel_accuracy):
+		""" The variance scaling of updateAttitudeINSGPS() """
+		gps_var = self.settings['GpsVar']
+		pos_var = gps_var[0] * (0.6 + (pos_accuracy * 0.180) ** 2)
+		speed_var = gps_var[1] * (0.5 + (vel_accuracy * 1.414) ** 2)
+		v_pos_var = gps_var[2] + (0.7 + (pos_accuracy * 0.167) ** 3)
+		self.ins.configure(gps_var=numpy.array([pos_var, speed_var, v_pos_var]))
+
+	def predict(self, gyros, accels, dT, warmup):
+		# gyros arrive in deg/s with the bias already removed
+		self.state = self.ins.prediction(numpy.array(gyros, numpy.float64) * DEG2RAD,
+			numpy.array(accels, numpy.float64), dT)
+		if warmup:
+			self.ins.set_state(gyro_bias=numpy.zeros(3), accel_bias=numpy.zeros(3))
+
+	def correct(self, mag, pos, vel, baro, sensors):
+		Z = numpy.zeros((10,), numpy.float64)
+		Z[0:3] = pos
+		Z[3:6] = vel
+		Z[6:9] = mag
+		Z[9] = baro
+		self.state = self.ins.correction(Z, sensors)
+
+	def attitude(self):
+		return self.state[6:10]
+
+	def position(self):
+		return self.state[0:3]
+
+	def timing(self):
+		return self.ins.timing()
+
+class ComplementaryEstimator:
+	""" The attitude part of updateAttitudeComplementary() """
+
+	name = 'cf'
+
+	def __init__(self, name, settings):
+		self.settings = settings
+
+	def start(self, q, pos, Be):
+		self.q = numpy.array(q, numpy.float64)
+		self.pos = numpy.array(pos, numpy.float64)
+		self.Be = numpy.array(Be, numpy.float64)
+		self.gyro_bias = numpy.zeros(3)
+		self.accels_filtered = numpy.zeros(3)
+		self.grot_filtered = numpy.zeros(3)
+		self.mag = None
+		self.ticks = { 'predictions' : 0, 'prediction_ns' : 0, 'prediction_max_ns' : 0,
+			'corrections' : 0, 'correction_ns' : 0, 'correction_max_ns' : 0 }
+
+		tau = self.settings['AccelTau']
+		self.accel_alpha = math.exp(-0.0025 / tau) if tau >= 0.0001 else 0
+
+	def set_gps_accuracy(self, pos_accuracy, vel_accuracy):
+		pass
+
+	def predict(self, gyros, accels, dT, warmup):
+		start = time.time()
+
+		s = self.settings
+		q = self.q
+		accels = numpy.array(accels, numpy.float64)
+		gyros = numpy.array(gyros, numpy.float64) - self.gyro_bias
+
+		grot = -numpy.array([2 * (q[1] * q[3] - q[0] * q[2]),
+			2 * (q[2] * q[3] + q[0] * q[1]),
+			q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]])
+
+		alpha = self.accel_alpha
+		self.accels_filtered = self.accels_filtered * alpha + accels * (1 - alpha)
+		self.grot_filtered = self.grot_filtered * alpha + grot * (1 - alpha)
+
+		accel_err = numpy.cross(self.accels_filtered, self.grot_filtered)
+		grot_mag = numpy.linalg.norm(self.grot_filtered) if alpha > 0 else 1.0
+		accel_mag = numpy.linalg.norm(self.accels_filtered)
+		if grot_mag > 1e-3 and accel_mag > 1e-3:
+			accel_err /= accel_mag * grot_mag
+		else:
+			accel_err[:] = 0
+
+		mag_err = 0
+		if self.mag is not None:
+			brot = quat_to_rbe(q).dot(self.Be)
+			bmag = numpy.linalg.norm(brot)
+			mag_len = numpy.linalg.norm(self.mag)
+			if bmag >= 1 and mag_len >= 1:
+				mag_err = numpy.cross(self.mag / mag_len, brot / bmag)[2]
+			self.mag = None
+
+		if not warmup:
+			self.gyro_bias[0] += accel_err[0] * s['AccelKi']
+			self.gyro_bias[1] += accel_err[1] * s['AccelKi']
+			self.gyro_bias[2] += mag_err * s['MagKi']
+
+		gyros[0] += accel_err[0] * s['AccelKp'] / dT
+		gyros[1] += accel_err[1] * s['AccelKp'] / dT
+		gyros[2] += accel_err[2] * s['AccelKp'] / dT + mag_err * s['MagKp'] / dT
+
+		w = gyros * DEG2RAD * dT / 2
+		qdot = numpy.array([-q[1] * w[0] - q[2] * w[1] - q[3] * w[2],
+			q[0] * w[0] - q[3] * w[1] + q[2] * w[2],
+			q[3] * w[0] + q[0] * w[1] - q[1] * w[2],
+			-q[2] * w[0] + q[1] * w[1] + q[0] * w[2]])
+		q = q + qdot
+		if q[0] < 0:
+			q = -q
+		qmag = numpy.linalg.norm(q)
+		if qmag < 1e-3 or not numpy.isfinite(qmag):
+			q = numpy.array([1.0, 0, 0, 0])
+		else:
+			q = q / qmag
+		self.q = q
+
+		self.account('prediction', start)
+
+	def correct(self, mag, pos, vel, baro, sensors):
+		start = time.time()
+
+		if sensors & MAG_SENSORS:
+			self.mag = numpy.array(mag, numpy.float64)
+		if sensors & HORIZ_POS_SENSORS:
+			self.pos[0:2] = pos[0:2]
+		if sensors & BARO_SENSOR:
+			self.pos[2] = -baro
+
+		self.account('correction', start)
+
+	def account(self, kind, start):
+		elapsed = int((time.time() - start) * 1e9)
+		self.ticks[kind + 's'] += 1
+		self.ticks[kind + '_ns'] += elapsed
+		self.ticks[kind + '_max_ns'] = max(self.ticks[kind + '_max_ns'], elapsed)
+
+	def attitude(self):
+		return self.q
+
+	def position(self):
+		return self.pos
+
+	def timing(self):
+		return self.ticks
+
+def make_estimator(name, settings):
+	if name == 'cf':
+		return ComplementaryEstimator(name, settings)
+	return EKFEstimator(name, settings)
+
+def read_log(filename, githash=None):
+	""" Returns the objects the replay uses from a log, in log order """
+
+	from dronin import telemetry
+
+	wanted = ['UAVO_Gyros', 'UAVO_Accels', 'UAVO_Magnetometer', 'UAVO_BaroAltitude',
+		'UAVO_GPSPosition', 'UAVO_GPSVelocity', 'UAVO_HomeLocation',
+		'UAVO_GyrosBias', 'UAVO_INSSettings', 'UAVO_AttitudeSettings']
+
+	file_obj = open(filename, 'rb')
+	if githash is None:
+		t = telemetry.FileTelemetry(file_obj, parse_header=True, name=filename)
+	else:
+		t = telemetry.FileTelemetry(file_obj, parse_header=False, name=filename,
+			githash=githash)
+
+	return [o for o in t if o.name in wanted]
+
+def log_settings(objects):
+	""" Starts from the defaults and applies the last settings in the log """
+
+	settings = dict(default_settings)
+
+	for o in objects:
+		if o.name == 'UAVO_INSSettings':
+			for field in ['AccelVar', 'GyroVar', 'MagVar', 'GpsVar', 'BaroVar']:
+				settings[field] = getattr(o, field)
+		elif o.name == 'UAVO_AttitudeSettings':
+			for field in ['AccelKp', 'AccelKi', 'MagKp', 'MagKi', 'AccelTau']:
+				settings[field] = getattr(o, field)
+
+	return settings
+
+def replay(objects, estimator, out=None):
+	""" Runs one estimator over the log, mirroring updateAttitudeINSGPS().
+
+	Returns the log time covered and the wall clock time the replay took.
+	"""
+
+	home = None
+	T = None
+	gyros_bias = [0, 0, 0]
+	accels = mag = baro = None
+	gps = gps_vel = None
+	Be = [100, 0, 500]
+	baro_offset = 0
+
+	started = False
+	start_time = last_time = None
+	last_indoor_pos = None
+
+	if out is not None:
+		out.write('time,q0,q1,q2,q3,roll,pitch,yaw,north,east,down\n')
+
+	wall_start = time.time()
+
+	for o in objects:
+		if o.name == 'UAVO_HomeLocation':
+			if o.Set == o.ENUM_Set['TRUE']:
+				home = o
+				lat = home.Latitude / 10.0e6 * DEG2RAD
+				T = [home.Altitude + 6.378137E6,
+					math.cos(lat) * (home.Altitude + 6.378137E6), -1.0]
+				if any(home.Be):
+					Be = list(home.Be)
+			continue
+		elif o.name == 'UAVO_GyrosBias':
+			gyros_bias = [o.x, o.y, o.z]
+			continue
+		elif o.name == 'UAVO_Accels':
+			accels = [o.x, o.y, o.z]
+			continue
+		elif o.name == 'UAVO_Magnetometer':
+			mag = [o.x, o.y, o.z]
+			if started:
+				estimator.correct(mag, [0, 0, 0], [0, 0, 0], 0, MAG_SENSORS)
+			continue
+		elif o.name == 'UAVO_BaroAltitude':
+			baro = o.Altitude
+			if started:
+				estimator.correct([0, 0, 0], [0, 0, 0], [0, 0, 0], baro + baro_offset, BARO_SENSOR)
+			continue
+		elif o.name == 'UAVO_GPSPosition':
+			gps = o
+			if started and home is not None and o.Satellites >= 6 and o.PDOP <= 4.0:
+				NED = [T[0] * (o.Latitude - home.Latitude) / 10.0e6 * DEG2RAD,
+					T[1] * (o.Longitude - home.Longitude) / 10.0e6 * DEG2RAD,
+					T[2] * (o.Altitude - home.Altitude)]
+				estimator.set_gps_accuracy(o.Accuracy,
+					gps_vel.Accuracy if gps_vel is not None else 0)
+				estimator.correct([0, 0, 0], NED, [0, 0, 0], 0, HORIZ_POS_SENSORS)
+			continue
+		elif o.name == 'UAVO_GPSVelocity':
+			gps_vel = o
+			if started and home is not None:
+				estimator.correct([0, 0, 0], [0, 0, 0], [o.North, o.East, o.Down], 0,
+					HORIZ_VEL_SENSORS | VERT_VEL_SENSORS)
+			continue
+		elif o.name != 'UAVO_Gyros':
+			continue
+
+		# Everything else is driven by the gyro updates, as on the board
+		if not started:
+			if accels is None or mag is None or baro is None:
+				continue
+
+			q = rpy_to_quat([math.atan2(-accels[1], -accels[2]) * RAD2DEG,
+				math.atan2(accels[0], -accels[2]) * RAD2DEG,
+				math.atan2(-mag[1], mag[0]) * RAD2DEG])
+
+			baro_offset = -baro
+			estimator.start(q, [0, 0, 0], Be)
+
+			started = True
+			start_time = last_time = o.time
+			last_indoor_pos = o.time
+			continue
+
+		dT = min(max(o.time - last_time, 0.0005), 0.01)
+		last_time = o.time
+
+		gyros = [o.x + gyros_bias[0], o.y + gyros_bias[1], o.z + gyros_bias[2]]
+		estimator.predict(gyros, accels, dT, o.time - start_time < WARMUP_TIME)
+
+		# Fake position at 10 Hz when flying without a home location
+		if home is None and o.time - last_indoor_pos > 0.1:
+			last_indoor_pos = o.time
+			estimator.correct([0, 0, 0], [0, 0, -(baro + baro_offset)], [0, 0, 0], 0,
+				HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS)
+
+		if out is not None:
+			q = estimator.attitude()
+			pos = estimator.position()
+			out.write('%.3f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n' %
+				tuple([o.time] + list(q) + quat_to_rpy(q) + list(pos)))
+
+	wall_time = time.time() - wall_start
+
+	if not started:
+		return 0, wall_time
+	return last_time - start_time, wall_time
+
+def main():
+	import argparse
+	parser = argparse.ArgumentParser(description="Replay flight logs through the attitude estimators")
+
+	parser.add_argument("-e", "--estimator",
+	                    action  = "append",
+	                    choices = ['ins', 'ins13', 'ins16', 'cf'],
+	                    help    = "estimator to run, may be repeated (default ins)")
+
+	parser.add_argument("-o", "--output",
+	                    action  = "store",
+	                    default = None,
+	                    help    = "directory for the per log CSV files, none are written if omitted")
+
+	parser.add_argument("-g", "--githash",
+	                    action  = "store",
+	                    help    = "override githash for UAVO XML definitions")
+
+	parser.add_argument("logs",
+	                    nargs = "+",
+	                    help  = "log files to replay")
+
+	args = parser.parse_args()
+	estimators = args.estimator or ['ins']
+
+	if args.output is not None and not os.path.isdir(args.output):
+		os.makedirs(args.output)
+
+	print('log,estimator,log_s,replay_s,speedup,predictions,prediction_us,prediction_max_us,corrections,correction_us,correction_max_us')
+
+	failures = 0
+	for log in args.logs:
+		try:
+			objects = read_log(log, args.githash)
+		except Exception as e:
+			print('%s: %s' % (log, e), file=sys.stderr)
+			failures += 1
+			continue
+
+		settings = log_settings(objects)
+
+		for name in estimators:
+			estimator = make_estimator(name, settings)
+
+			out = None
+			if args.output is not None:
+				base = os.path.splitext(os.path.basename(log))[0]
+				out = open(os.path.join(args.output, '%s.%s.csv' % (base, name)), 'w')
+
+			log_time, wall_time = replay(objects, estimator, out)
+
+			if out is not None:
+				out.close()
+
+			if log_time == 0:
+				print('%s: not enough sensor data to start %s' % (log, name), file=sys.stderr)
+				failures += 1
+				continue
+
+			t = estimator.timing()
+			print('%s,%s,%.1f,%.2f,%.1f,%d,%.2f,%.2f,%d,%.2f,%.2f' % (log, name,
+				log_time, wall_time, log_time / wall_time,
+				t['predictions'], t['prediction_ns'] / 1e3 / max(t['predictions'], 1),
+				t['prediction_max_ns'] / 1e3,
+				t['corrections'], t['correction_ns'] / 1e3 / max(t['corrections'], 1),
+				t['correction_max_ns'] / 1e3))
+
+	return 1 if failures else 0
+
+if __name__ == '__main__':
+	sys.exit(main())
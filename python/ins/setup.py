@@ -1,12 +1,23 @@
 from distutils.core import setup, Extension, Command
 import numpy
 
-module1 = Extension('ins',
-	sources = ['insmodule.c', '../../flight/Libraries/insgps14state.c'],
+# One module per estimator. They all export the same symbols so each gets
+# its own extension, built from the same wrapper under a different name.
+# 'ins' stays the 14 state filter that most boards fly.
+estimators = [
+	('ins', 'insgps14state.c'),
+	('ins13', 'insgps13state.c'),
+	('ins16', 'insgps16state.c'),
+]
+
+modules = [Extension(name,
+	sources = ['insmodule.c', '../../flight/Libraries/' + source],
 	            include_dirs=['../../flight/Libraries/inc','../../shared/api',numpy.get_include()],
+	            define_macros=[('INS_MODULE_NAME', name)],
                     extra_compile_args=['-std=gnu99'],)
+	for name, source in estimators]
  
 setup (name = 'PackageName',
         version = '1.0',
         description = 'INS C module',
-        ext_modules = [module1])
+        ext_modules = modules)
@@ -88,7 +88,7 @@ setup(
 
     scripts = [ 'dronin-dumplog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
-        'dronin-shell' ],
+        'dronin-shell', 'dronin-simfarm' ],
 #    package_data={
 #        'sample': ['package_data.dat'],
 #    },
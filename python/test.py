@@ -1,5 +1,234 @@
 #!/usr/bin/env python
 
+def put_varint(value):
+    """Mirror of putVarint() in flight/UAVTalk/uavtalk.c"""
+    out = bytearray()
+
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+
+    return out
+
+def encode_delta(data, reference, max_length):
+    """Mirror of encodeDelta() in flight/UAVTalk/uavtalk.c: the runs of a
+    delta packet, or None if they do not fit in max_length"""
+    out = bytearray()
+    length = len(data)
+    pos = 0
+
+    while True:
+        start = pos
+        while start < length and data[start] == reference[start]:
+            start += 1
+
+        if start == length:
+            break
+
+        end = start + 1
+        i = end
+        while i < length and i - end < 3:
+            if data[i] != reference[i]:
+                end = i + 1
+            i += 1
+
+        if len(out) + 4 + (end - start) > max_length:
+            return None
+
+        out += put_varint(start - pos)
+        out += put_varint(end - start)
+        out += bytearray(data[j] ^ reference[j] for j in range(start, end))
+
+        pos = end
+
+    return out
+
+class DeltaLogger(object):
+    """Logs one object instance the way the flight logger does with delta
+    encoding enabled, see UAVTalkSendObjectDeltaTimestamped()"""
+
+    def __init__(self, obj, instance_id=None):
+        self.obj = obj
+        self.instance_id = instance_id
+        self.reference = None
+        self.keyframe_stamp = 0
+        self.seq = 0
+
+    def send(self, data, timestamp, keyframe=False):
+        """Returns the packet and whether it is a delta"""
+        from dronin import uavtalk
+
+        length = len(data)
+        payload = None
+
+        if (not keyframe and self.reference is not None and self.seq < 255
+                and length > uavtalk.DELTA_HEADER_LENGTH + 1):
+            runs = encode_delta(data, self.reference,
+                length - uavtalk.DELTA_HEADER_LENGTH - 1)
+            if runs is not None:
+                payload = bytearray(uavtalk.delta_header_fmt.pack(
+                    self.keyframe_stamp, self.seq + 1)) + runs
+
+        if payload is None:
+            pack_type = uavtalk.TYPE_OBJ_TS
+            payload = bytearray(data)
+            # A keyframe with the stamp of the one before can't be told
+            # apart from it, so the next update is a keyframe again
+            stamp = timestamp & 0xffff
+            self.seq = 255 if stamp == self.keyframe_stamp else 0
+            self.keyframe_stamp = stamp
+        else:
+            pack_type = uavtalk.TYPE_OBJ_DELTA_TS
+            self.seq += 1
+
+        self.reference = bytearray(data)
+
+        head = bytearray()
+        if self.instance_id is not None:
+            head += uavtalk.instance_fmt.pack(self.instance_id)
+        head += uavtalk.timestamp_fmt.pack(timestamp)
+
+        size = uavtalk.header_fmt.size + len(head) + len(payload)
+        packet = bytearray(uavtalk.header_fmt.pack(uavtalk.SYNC_VAL,
+            pack_type | uavtalk.TYPE_VER, size, self.obj._id))
+        packet += head + payload
+        packet.append(uavtalk.calcCRC(bytes(packet)))
+
+        return (bytes(packet), pack_type == uavtalk.TYPE_OBJ_DELTA_TS)
+
+def check_delta_round_trip(uavo_defs):
+    """Logs object updates as keyframes and deltas, and checks that the
+    parser rebuilds the objects that were logged"""
+    from dronin import uavtalk
+
+    big = uavo_defs.find_by_name('StabilizationSettings')
+    multi = uavo_defs.find_by_name('Waypoint')
+    size = big.get_size_of_data()
+
+    # Room for skips and runs that need two byte varints
+    assert 150 < size < uavtalk.MAX_PAYLOAD_LENGTH
+
+    seed = [0x55A0]
+    def random_bytes(n):
+        # Kept below 0x40 so that no float field can hold a NaN, which
+        # would not compare equal to itself
+        out = bytearray()
+        for i in range(n):
+            seed[0] = (seed[0] * 1103515245 + 12345) & 0xffffffff
+            out.append((seed[0] >> 16) & 0x3f)
+        return out
+
+    def changed(data, positions):
+        data = bytearray(data)
+        for i in positions:
+            data[i] = (data[i] + 1) & 0x3f
+        return data
+
+    stream = bytearray()
+    expected = []
+    timestamp = [1000]
+
+    def log(logger, data, keyframe=False, lost=False, decodable=True,
+            delta=None, same_time=False):
+        if not same_time:
+            timestamp[0] += 10
+        (packet, is_delta) = logger.send(data, timestamp[0], keyframe)
+
+        if delta is not None:
+            assert is_delta == delta
+
+        if not lost:
+            stream.extend(packet)
+            if decodable:
+                expected.append(logger.obj.from_bytes(bytes(data),
+                    timestamp[0], logger.instance_id))
+
+    logger = DeltaLogger(big)
+    wp_logger = DeltaLogger(multi, 1)
+
+    data = random_bytes(size)
+    wp_data = random_bytes(multi.get_size_of_data())
+
+    # Joining a log part way through: deltas are dropped up to a keyframe
+    log(logger, data, delta=False, lost=True)
+    data = changed(data, [3])
+    log(logger, data, delta=True, decodable=False)
+
+    log(logger, data, keyframe=True, delta=False)
+    log(wp_logger, wp_data, delta=False)
+
+    # Unchanged data is a delta without runs
+    log(logger, data, delta=True)
+    log(wp_logger, wp_data, delta=True)
+
+    # A few scattered bytes, with gaps short enough to join the runs
+    data = changed(data, [0, 2, 5, 40, size - 1])
+    log(logger, data, delta=True)
+    wp_data = changed(wp_data, [1, 7])
+    log(wp_logger, wp_data, delta=True)
+
+    # Skips and runs of 128 bytes or more
+    data = changed(data, [size - 10])
+    log(logger, data, delta=True)
+    data = changed(data, range(4, 140))
+    log(logger, data, delta=True)
+    data = changed(data, range(150, size))
+    log(logger, data, delta=True)
+
+    # Fully changed data is sent as a keyframe, the delta would be longer
+    data = bytearray((b + 7) & 0x3f for b in data)
+    log(logger, data, delta=False)
+    data = changed(data, [1])
+    log(logger, data, delta=True)
+
+    # A lost delta breaks the chain until the next keyframe
+    data = changed(data, [20])
+    log(logger, data, delta=True, lost=True)
+    data = changed(data, [21])
+    log(logger, data, delta=True, decodable=False)
+    log(wp_logger, changed(wp_data, [0]), delta=True)
+    data = changed(data, [22])
+    log(logger, data, delta=True, decodable=False)
+    log(logger, data, keyframe=True, delta=False)
+    data = changed(data, [23])
+    log(logger, data, delta=True)
+
+    # A lost keyframe right after another: its deltas must not be applied
+    # to the keyframe before it
+    log(logger, data, keyframe=True, delta=False)
+    data = changed(data, [24])
+    log(logger, data, keyframe=True, delta=False, lost=True)
+    data = changed(data, [25])
+    log(logger, data, delta=True, decodable=False)
+    data = changed(data, [26])
+    log(logger, data, delta=True, decodable=False)
+
+    # Two keyframes in the same millisecond, then a keyframe again
+    log(logger, data, keyframe=True, delta=False)
+    data = changed(data, [27])
+    log(logger, data, keyframe=True, delta=False, lost=True, same_time=True)
+    data = changed(data, [28])
+    log(logger, data, delta=False)
+    data = changed(data, [29])
+    log(logger, data, delta=True)
+
+    parser = uavtalk.process_stream(uavo_defs, gcs_timestamps=False)
+    parser.send(None)
+
+    received = []
+    obj = parser.send(bytes(stream))
+    while obj:
+        received.append(obj)
+        obj = parser.send(b'')
+
+    assert len(received) == len(expected), \
+        "%d objects decoded, %d expected" % (len(received), len(expected))
+
+    for (got, want) in zip(received, expected):
+        assert got._name == want._name
+        assert got[1:] == want[1:], "%s decoded wrong" % (got._name)
+
 def main():
 
     # Load the UAVO xml files in the workspace
@@ -7,6 +236,8 @@ def main():
     uavo_defs = dronin.uavo_collection.UAVOCollection()
     uavo_defs.from_uavo_xml_path('shared/uavobjectdefinition')
 
+    check_delta_round_trip(uavo_defs)
+
 #-------------------------------------------------------------------------------
 if __name__ == "__main__":
     main()
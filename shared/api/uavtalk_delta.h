@@ -0,0 +1,122 @@
+/**
+ ******************************************************************************
+ * @file       uavtalk_delta.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UAVTalk UAVTalk implementation
+ * @{
+ * @addtogroup
+ * @{
+ * @brief Layout and decoding of delta encoded UAVTalk packets, shared by
+ *        the flight encoder and the ground readers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVTALK_DELTA_H_
+#define UAVTALK_DELTA_H_
+
+#include <stdint.h>
+
+/*
+ * The payload of a delta packet starts with the timestamp of the keyframe
+ * (the complete OBJ_TS copy) it builds on and the number of deltas sent
+ * since that keyframe, this one included. Then come the runs of changed
+ * bytes: the count of unchanged bytes before the run and its length, both
+ * as varints, then the XOR of the new and the old data. Unchanged bytes
+ * after the last run are implied.
+ *
+ * A delta can only be applied to the data of the keyframe it names,
+ * updated by every delta before it.
+ */
+
+// Keyframe timestamp (2) + sequence number (1)
+#define UAVTALK_DELTA_HEADER_LENGTH 3
+
+/**
+ * Check that a delta packet follows on from the data a reader holds
+ * \param[in] payload Delta packet payload, at least UAVTALK_DELTA_HEADER_LENGTH long
+ * \param[in] keyframe_stamp Timestamp of the keyframe the data comes from
+ * \param[in] sequence Deltas applied to the data since the keyframe
+ * \return 1 if the delta can be applied, 0 otherwise
+ */
+static inline int uavtalk_delta_follows(const uint8_t *payload,
+		uint16_t keyframe_stamp, uint8_t sequence)
+{
+	uint16_t stamp = payload[0] | (payload[1] << 8);
+
+	return stamp == keyframe_stamp && payload[2] == (uint8_t)(sequence + 1);
+}
+
+/**
+ * Apply the runs of a delta packet to the data it is relative to
+ * \param[in,out] data Object data, changed even when the runs are malformed
+ * \param[in] length Object length
+ * \param[in] payload Delta packet payload
+ * \param[in] payload_length Payload length
+ * \return 0 Success
+ * \return -1 if the runs are malformed
+ */
+static inline int uavtalk_delta_apply(uint8_t *data, int32_t length,
+		const uint8_t *payload, int32_t payload_length)
+{
+	int32_t pos = 0;
+	int32_t i = UAVTALK_DELTA_HEADER_LENGTH;
+
+	if (payload_length < UAVTALK_DELTA_HEADER_LENGTH) {
+		return -1;
+	}
+
+	while (i < payload_length) {
+		uint32_t run[2] = { 0, 0 }; // Unchanged bytes, changed bytes
+
+		for (int n = 0; n < 2; n++) {
+			int shift = 0;
+			uint8_t b;
+
+			do {
+				if (i >= payload_length || shift > 21) {
+					return -1;
+				}
+				b = payload[i++];
+				run[n] |= (uint32_t)(b & 0x7F) << shift;
+				shift += 7;
+			} while (b & 0x80);
+		}
+
+		if (run[1] == 0 || run[0] > (uint32_t)(length - pos) ||
+				run[1] > (uint32_t)(length - pos - run[0]) ||
+				run[1] > (uint32_t)(payload_length - i)) {
+			return -1;
+		}
+
+		pos += run[0];
+		for (uint32_t j = 0; j < run[1]; j++) {
+			data[pos + j] ^= payload[i + j];
+		}
+
+		pos += run[1];
+		i += run[1];
+	}
+
+	return 0;
+}
+
+#endif /* UAVTALK_DELTA_H_ */
+
+/**
+ * @}
+ * @}
+ */